@@ -0,0 +1,154 @@
+// Debounce engine benchmark: the per-button timestamp loop used by
+// button_control.c against the bit-parallel vertical counter engine
+// (scalar and AVX2) for 64 to 512 inputs.
+
+#include "debounce_vc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SAMPLES 4096          // Pre-generated input samples
+#define BENCH_ROUNDS 64             // Passes over the sample set
+#define BENCH_TICK_MS 10            // Time between samples
+#define BENCH_DELAY_MS 50           // DEBOUNCE_DELAY_MS
+#define BENCH_THRESHOLD (BENCH_DELAY_MS / BENCH_TICK_MS + 2)
+
+// Reference engine state, mirroring button_t
+typedef struct {
+    int current_state;
+    int last_state;
+    uint64_t last_debounce_time;
+    int state_changed;
+} ref_button_t;
+
+static uint64_t samples[BENCH_SAMPLES][DEBOUNCE_VC_WORDS];
+static ref_button_t ref_buttons[DEBOUNCE_VC_MAX_INPUTS];
+
+// xorshift64* generator
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+// Noisy inputs: every sample each input flips with probability 1/64
+static void generate_samples(void) {
+    uint64_t level[DEBOUNCE_VC_WORDS] = {0};
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        for (int w = 0; w < DEBOUNCE_VC_WORDS; w++) {
+            uint64_t flip = ~0ULL;
+            for (int k = 0; k < 6; k++) {
+                flip &= rng_next();
+            }
+            level[w] ^= flip;
+            samples[s][w] = level[w];
+        }
+    }
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Per-button loop with branches and timestamps, as in button_update_all()
+static uint64_t run_reference(size_t n) {
+    uint64_t flips = 0;
+    uint64_t time_ms = 0;
+    memset(ref_buttons, 0, sizeof(ref_buttons));
+    
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int s = 0; s < BENCH_SAMPLES; s++) {
+            time_ms += BENCH_TICK_MS;
+            for (size_t i = 0; i < n; i++) {
+                int new_state = (int)((samples[s][i / 64] >> (i % 64)) & 1);
+                ref_button_t *b = &ref_buttons[i];
+                
+                b->state_changed = 0;
+                if (new_state != b->last_state) {
+                    b->last_debounce_time = time_ms;
+                }
+                if ((time_ms - b->last_debounce_time) > BENCH_DELAY_MS &&
+                    new_state != b->current_state) {
+                    b->current_state = new_state;
+                    b->state_changed = 1;
+                    flips++;
+                }
+                b->last_state = new_state;
+            }
+        }
+    }
+    return flips;
+}
+
+// Vertical counter engine
+static uint64_t run_vertical(size_t n, bool avx2, uint64_t *checksum) {
+    static debounce_vc_t vc;
+    uint64_t flips = 0;
+    
+    debounce_vc_init(&vc, n, BENCH_THRESHOLD);
+    debounce_vc_set_avx2(&vc, avx2);
+    
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int s = 0; s < BENCH_SAMPLES; s++) {
+            if (debounce_vc_update(&vc, samples[s])) {
+                for (size_t w = 0; w < vc.num_words; w++) {
+                    flips += (uint64_t)__builtin_popcountll(vc.pressed[w] | vc.released[w]);
+                }
+            }
+        }
+    }
+    
+    *checksum = 0;
+    for (size_t w = 0; w < vc.num_words; w++) {
+        *checksum ^= vc.state[w] * (w + 1);
+    }
+    return flips;
+}
+
+int main(void) {
+    static const size_t sizes[] = { 64, 128, 256, 512 };
+    const double ticks = (double)BENCH_SAMPLES * BENCH_ROUNDS;
+    bool have_avx2 = debounce_vc_avx2_available();
+    
+    generate_samples();
+    
+    printf("engine,inputs,ns_per_tick,ns_per_input,flips\n");
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t n = sizes[k];
+        uint64_t sum_scalar = 0;
+        uint64_t sum_avx2 = 0;
+        
+        uint64_t t0 = now_ns();
+        uint64_t flips = run_reference(n);
+        double ns = (double)(now_ns() - t0) / ticks;
+        printf("timestamp,%zu,%.2f,%.3f,%llu\n", n, ns, ns / (double)n, (unsigned long long)flips);
+        
+        t0 = now_ns();
+        uint64_t flips_vc = run_vertical(n, false, &sum_scalar);
+        ns = (double)(now_ns() - t0) / ticks;
+        printf("vertical-scalar,%zu,%.2f,%.3f,%llu\n", n, ns, ns / (double)n, (unsigned long long)flips_vc);
+        
+        if (flips_vc != flips) {
+            fprintf(stderr, "Vertical and timestamp engines disagree for %zu inputs\n", n);
+            return 1;
+        }
+        
+        if (have_avx2) {
+            t0 = now_ns();
+            uint64_t flips_avx2 = run_vertical(n, true, &sum_avx2);
+            ns = (double)(now_ns() - t0) / ticks;
+            printf("vertical-avx2,%zu,%.2f,%.3f,%llu\n", n, ns, ns / (double)n, (unsigned long long)flips_avx2);
+            
+            if (flips_avx2 != flips || sum_avx2 != sum_scalar) {
+                fprintf(stderr, "AVX2 and scalar kernels disagree for %zu inputs\n", n);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,513 @@
+// Hot-path microbenchmarks for the GPIO, LED, button, rule, timer wheel
+// and esp_timer layers. Build with logging compiled out (make bench). Every benchmark runs
+// BENCH_SAMPLES timed batches of BENCH_BATCH operations; the per-batch
+// ns/op values give the mean and the percentiles.
+//
+// Usage: hotpath_bench [--format csv|json]
+
+#include "gpio_mock.h"
+#include "led_control.h"
+#include "button_control.h"
+#include "sim_clock.h"
+#include "timer_wheel.h"
+#include "esp_timer.h"
+#include "rule_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SAMPLES 512           // Timed batches per benchmark
+#define BENCH_BATCH 256             // Operations per batch
+#define BENCH_WARMUP 16             // Untimed batches first
+#define BENCH_EVENT_BATCH 16        // Button events drained at a time
+
+// One benchmark: 'op' runs a single operation on 'ctx'
+typedef struct {
+    const char *name;
+    int inputs;                     // Button inputs, 0 if not applicable
+    void (*op)(void *ctx);
+    void *ctx;
+} bench_case_t;
+
+// Summary of one benchmark
+typedef struct {
+    double mean_ns;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double ops_per_sec;
+} bench_result_t;
+
+static double samples[BENCH_SAMPLES];
+static volatile uint32_t level_sink;  // Keeps reads from being optimized away
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of the sorted samples
+static double percentile(double p) {
+    size_t rank = (size_t)(p / 100.0 * BENCH_SAMPLES + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > BENCH_SAMPLES) {
+        rank = BENCH_SAMPLES;
+    }
+    return samples[rank - 1];
+}
+
+// Time one benchmark
+static bench_result_t run_case(const bench_case_t *bc) {
+    for (int b = 0; b < BENCH_WARMUP; b++) {
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            bc->op(bc->ctx);
+        }
+    }
+    
+    double total = 0;
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            bc->op(bc->ctx);
+        }
+        samples[s] = (double)(now_ns() - start) / BENCH_BATCH;
+        total += samples[s];
+    }
+    qsort(samples, BENCH_SAMPLES, sizeof(samples[0]), compare_double);
+    
+    bench_result_t r;
+    r.mean_ns = total / BENCH_SAMPLES;
+    r.p50_ns = percentile(50);
+    r.p90_ns = percentile(90);
+    r.p99_ns = percentile(99);
+    r.ops_per_sec = r.mean_ns > 0 ? 1e9 / r.mean_ns : 0;
+    return r;
+}
+
+// Default-instance GPIO and LED operations
+
+static void op_gpio_set_level(void *ctx) {
+    static uint32_t level;
+    (void)ctx;
+    gpio_set_level(LED1_PIN, level ^= 1);
+}
+
+static void op_gpio_get_level(void *ctx) {
+    (void)ctx;
+    level_sink = gpio_get_level(BUTTON1_PIN);
+}
+
+static void op_gpio_toggle_level(void *ctx) {
+    (void)ctx;
+    gpio_toggle_level(LED1_PIN);
+}
+
+static void op_led_toggle(void *ctx) {
+    (void)ctx;
+    led_toggle(LED1_PIN);
+}
+
+// Button controller with 'inputs' buttons on its own board and clock
+typedef struct {
+    gpio_device_t gpio;
+    sim_clock_t clock;
+    button_controller_t ctrl;
+    uint32_t next_pin;
+    int inputs;
+} button_bench_t;
+
+static void button_bench_init(button_bench_t *bb, int inputs, button_debounce_engine_t engine) {
+    gpio_dev_init(&bb->gpio);
+    sim_clock_configure(&bb->clock, SIM_CLOCK_VIRTUAL);
+    button_ctrl_init(&bb->ctrl, &bb->gpio, &bb->clock, engine);
+    for (int pin = 0; pin < inputs; pin++) {
+        button_ctrl_register(&bb->ctrl, (uint32_t)pin, "BTN");
+    }
+    bb->next_pin = 0;
+    bb->inputs = inputs;
+}
+
+// Take queued events so the queue never fills
+static void button_bench_drain(button_bench_t *bb) {
+    button_event_t events[BENCH_EVENT_BATCH];
+    while (button_ctrl_get_events(&bb->ctrl, events, BENCH_EVENT_BATCH) > 0) {
+    }
+}
+
+// No edges: the cost of an update with nothing to do
+static void op_button_update_idle(void *ctx) {
+    button_bench_t *bb = ctx;
+    sim_clock_advance(&bb->clock, DEBOUNCE_SAMPLE_NS);
+    button_ctrl_update_all(&bb->ctrl);
+}
+
+// One edge per update, each settling into a debounced transition:
+// drive a pin, let the edge register, then pass its deadline
+static void op_button_update_active(void *ctx) {
+    button_bench_t *bb = ctx;
+    uint32_t pin = bb->next_pin;
+    bb->next_pin = (pin + 1) % (uint32_t)bb->inputs;
+    
+    uint64_t bit = GPIO_PIN_SEL(pin);
+    gpio_dev_drive_inputs(&bb->gpio, bit, gpio_dev_read_all(&bb->gpio) ^ bit);
+    button_ctrl_update_all(&bb->ctrl);
+    sim_clock_advance(&bb->clock, DEBOUNCE_DELAY_NS + DEBOUNCE_SAMPLE_NS);
+    button_ctrl_update_all(&bb->ctrl);
+    button_bench_drain(bb);
+}
+
+// Full application tick, as main.c runs it: a stimulus edge, then
+// button_update_all() + process_button_events() once it has settled
+
+// Board rule table, as main.c loads it by default
+static rule_engine_t board_rules;
+
+// Mirror of process_button_events() in main.c
+static void process_button_events(void) {
+    button_event_t events[BENCH_EVENT_BATCH];
+    size_t n;
+    
+    while ((n = button_get_events(events, BENCH_EVENT_BATCH)) > 0) {
+        rule_engine_process(&board_rules, events, n);
+    }
+}
+
+static void op_full_tick(void *ctx) {
+    static int step;
+#define BENCH_BUTTON_PIN(n, name, pin, led) (pin),
+    static const uint32_t pins[NUM_BUTTONS] = {BOARD_BUTTONS(BENCH_BUTTON_PIN)};
+    (void)ctx;
+    
+    uint32_t pin = pins[(step / 2) % NUM_BUTTONS];
+    if (step++ & 1) {
+        button_simulate_release(pin);
+    } else {
+        button_simulate_press(pin);
+    }
+    button_update_all();
+    process_button_events();
+    sim_clock_advance_ns(DEBOUNCE_DELAY_NS + DEBOUNCE_SAMPLE_NS);
+    button_update_all();
+    process_button_events();
+}
+
+// Rule dispatch: one debounced press against a table of 'rules' toggle,
+// set and clear rules spread over every input pin. With logging compiled
+// out, the cost of an event should not grow with the table.
+typedef struct {
+    rule_engine_t engine;
+    button_event_t event;
+} rules_bench_t;
+
+static bool rules_bench_init(rules_bench_t *rb, int rules) {
+    static const rule_action_t actions[] = {RULE_ACTION_TOGGLE, RULE_ACTION_SET, RULE_ACTION_CLEAR};
+    rule_t *table = calloc((size_t)rules, sizeof(rule_t));
+    if (!table) {
+        return false;
+    }
+    for (int i = 0; i < rules; i++) {
+        table[i].trigger = RULE_TRIGGER_PRESS;
+        table[i].action = actions[i % 3];
+        table[i].inputs = GPIO_PIN_SEL((uint32_t)i % GPIO_NUM_MAX);
+        table[i].outputs = GPIO_PIN_SEL(i % 2 ? BOARD_PIN_LED2 : BOARD_PIN_LED1);
+    }
+    rule_engine_init(&rb->engine, led_default_controller(), timer_wheel_default());
+    bool ok = rule_engine_set_rules(&rb->engine, table, (size_t)rules);
+    free(table);
+    rb->event = (button_event_t){0, BUTTON1_PIN, BUTTON_PRESSED};
+    return ok;
+}
+
+static void op_rules_process(void *ctx) {
+    rules_bench_t *rb = ctx;
+    rule_engine_process(&rb->engine, &rb->event, 1);
+}
+
+// Timer wheel holding 'timers' periodic timers, one expiring per tick:
+// the cost of a tick should not grow with the armed timers
+typedef struct {
+    sim_clock_t clock;
+    timer_wheel_t wheel;
+    timer_wheel_timer_t *timers;
+    uint64_t period_ns;
+} wheel_bench_t;
+
+static void wheel_bench_expired(void *arg, uint64_t deadline_ns) {
+    wheel_bench_t *wb = arg;
+    uint64_t tick = deadline_ns / TIMER_WHEEL_TICK_NS;
+    timer_wheel_timer_t *timer = &wb->timers[(tick - 1) % (wb->period_ns / TIMER_WHEEL_TICK_NS)];
+    timer_wheel_arm(&wb->wheel, timer, deadline_ns + wb->period_ns);
+}
+
+static bool wheel_bench_init(wheel_bench_t *wb, int timers) {
+    wb->timers = malloc((size_t)timers * sizeof(*wb->timers));
+    if (!wb->timers) {
+        return false;
+    }
+    sim_clock_configure(&wb->clock, SIM_CLOCK_VIRTUAL);
+    timer_wheel_init(&wb->wheel, &wb->clock);
+    wb->period_ns = (uint64_t)timers * TIMER_WHEEL_TICK_NS;
+    for (int i = 0; i < timers; i++) {
+        timer_wheel_timer_init(&wb->timers[i], wheel_bench_expired, wb);
+        timer_wheel_arm(&wb->wheel, &wb->timers[i], (uint64_t)(i + 1) * TIMER_WHEEL_TICK_NS);
+    }
+    return true;
+}
+
+static void wheel_bench_deinit(wheel_bench_t *wb) {
+    free(wb->timers);
+    wb->timers = NULL;
+}
+
+// One tick of simulated time, firing and re-arming one timer
+static void op_wheel_tick(void *ctx) {
+    wheel_bench_t *wb = ctx;
+    sim_clock_advance(&wb->clock, TIMER_WHEEL_TICK_NS);
+    timer_wheel_run(&wb->wheel);
+}
+
+// Arm a timer half a period ahead and cancel it again
+static void op_wheel_arm_cancel(void *ctx) {
+    wheel_bench_t *wb = ctx;
+    timer_wheel_timer_t timer;
+    timer_wheel_timer_init(&timer, wheel_bench_expired, wb);
+    timer_wheel_arm(&wb->wheel, &timer, sim_clock_now(&wb->clock) + wb->period_ns / 2);
+    timer_wheel_cancel(&wb->wheel, &timer);
+}
+
+// esp_timer API on its own wheel: 'timers' periodic timers started one
+// tick apart with a period of 'timers' ticks, so once running exactly one
+// fires per tick
+typedef struct {
+    sim_clock_t clock;
+    timer_wheel_t wheel;
+    esp_timer_handle_t *timers;
+    int count;
+    uint64_t fired;
+} esp_timer_bench_t;
+
+static void esp_timer_bench_fired(void *arg) {
+    esp_timer_bench_t *eb = arg;
+    eb->fired++;
+}
+
+static bool esp_timer_bench_init(esp_timer_bench_t *eb, int timers) {
+    esp_timer_create_args_t args = {.callback = esp_timer_bench_fired, .arg = eb, .name = "bench"};
+    
+    eb->timers = calloc((size_t)timers, sizeof(*eb->timers));
+    if (!eb->timers) {
+        return false;
+    }
+    sim_clock_configure(&eb->clock, SIM_CLOCK_VIRTUAL);
+    timer_wheel_init(&eb->wheel, &eb->clock);
+    eb->count = 0;
+    eb->fired = 0;
+    for (int i = 0; i < timers; i++) {
+        if (i > 0) {
+            sim_clock_advance(&eb->clock, TIMER_WHEEL_TICK_NS);
+        }
+        if (!esp_timer_create_on(&eb->wheel, &args, &eb->timers[i]) ||
+            !esp_timer_start_periodic(eb->timers[i], (uint64_t)timers)) {
+            return false;
+        }
+        eb->count++;
+    }
+    return true;
+}
+
+static void esp_timer_bench_deinit(esp_timer_bench_t *eb) {
+    for (int i = 0; i < eb->count; i++) {
+        esp_timer_stop(eb->timers[i]);
+        esp_timer_delete(eb->timers[i]);
+    }
+    free(eb->timers);
+    eb->timers = NULL;
+    eb->count = 0;
+}
+
+// One tick of simulated time, firing and re-arming one periodic timer
+static void op_esp_timer_tick(void *ctx) {
+    esp_timer_bench_t *eb = ctx;
+    sim_clock_advance(&eb->clock, TIMER_WHEEL_TICK_NS);
+    timer_wheel_run(&eb->wheel);
+}
+
+// Push a running timer's expiry back, as a software watchdog does
+static void op_esp_timer_restart(void *ctx) {
+    esp_timer_bench_t *eb = ctx;
+    esp_timer_restart(eb->timers[0], (uint64_t)eb->count);
+}
+
+// Output
+
+static bool json_output = false;
+static bool first_row = true;
+
+static void print_header(void) {
+    if (json_output) {
+        printf("[\n");
+    } else {
+        printf("benchmark,inputs,samples,batch,mean_ns,p50_ns,p90_ns,p99_ns,ops_per_sec\n");
+    }
+}
+
+static void print_row(const bench_case_t *bc, const bench_result_t *r) {
+    if (json_output) {
+        printf("%s  {\"benchmark\": \"%s\", \"inputs\": ", first_row ? "" : ",\n", bc->name);
+        if (bc->inputs) {
+            printf("%d", bc->inputs);
+        } else {
+            printf("null");
+        }
+        printf(", \"samples\": %d, \"batch\": %d, \"mean_ns\": %.2f, \"p50_ns\": %.2f, "
+               "\"p90_ns\": %.2f, \"p99_ns\": %.2f, \"ops_per_sec\": %.0f}",
+               BENCH_SAMPLES, BENCH_BATCH, r->mean_ns, r->p50_ns, r->p90_ns, r->p99_ns,
+               r->ops_per_sec);
+    } else {
+        printf("%s,", bc->name);
+        if (bc->inputs) {
+            printf("%d", bc->inputs);
+        }
+        printf(",%d,%d,%.2f,%.2f,%.2f,%.2f,%.0f\n", BENCH_SAMPLES, BENCH_BATCH,
+               r->mean_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->ops_per_sec);
+    }
+    first_row = false;
+    fflush(stdout);
+}
+
+static void print_footer(void) {
+    if (json_output) {
+        printf("\n]\n");
+    }
+}
+
+static void run_and_print(const bench_case_t *bc) {
+    bench_result_t r = run_case(bc);
+    print_row(bc, &r);
+}
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "json") == 0) {
+                json_output = true;
+            } else if (strcmp(argv[i], "csv") != 0) {
+                fprintf(stderr, "Invalid format: %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--format csv|json]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    // Default board, as the application sets it up
+    sim_clock_init(SIM_CLOCK_VIRTUAL);
+    gpio_mock_init();
+    led_init_all();
+    button_init_all();
+    
+    print_header();
+    
+    static const bench_case_t basic[] = {
+        {"gpio_set_level", 0, op_gpio_set_level, NULL},
+        {"gpio_get_level", 0, op_gpio_get_level, NULL},
+        {"gpio_toggle_level", 0, op_gpio_toggle_level, NULL},
+        {"led_toggle", 0, op_led_toggle, NULL},
+    };
+    for (size_t i = 0; i < sizeof(basic) / sizeof(basic[0]); i++) {
+        run_and_print(&basic[i]);
+    }
+    
+    static const int input_counts[] = {3, 8, 16, 32, GPIO_NUM_MAX};
+    static const struct {
+        const char *idle;
+        const char *active;
+        button_debounce_engine_t engine;
+    } engines[] = {
+        {"button_update_all/timestamp/idle", "button_update_all/timestamp/active", BUTTON_DEBOUNCE_TIMESTAMP},
+        {"button_update_all/vertical/idle", "button_update_all/vertical/active", BUTTON_DEBOUNCE_VERTICAL},
+    };
+    static button_bench_t bb;
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        for (size_t k = 0; k < sizeof(input_counts) / sizeof(input_counts[0]); k++) {
+            bench_case_t idle = {engines[e].idle, input_counts[k], op_button_update_idle, &bb};
+            bench_case_t active = {engines[e].active, input_counts[k], op_button_update_active, &bb};
+            
+            button_bench_init(&bb, input_counts[k], engines[e].engine);
+            run_and_print(&idle);
+            run_and_print(&active);
+            button_ctrl_deinit(&bb.ctrl);
+        }
+    }
+    
+    rule_engine_init(&board_rules, led_default_controller(), timer_wheel_default());
+    rule_engine_load_board(&board_rules);
+    bench_case_t tick = {"tick/update_and_process", NUM_BUTTONS, op_full_tick, NULL};
+    run_and_print(&tick);
+    
+    static const int rule_counts[] = {NUM_BUTTONS, 64, 512, RULE_MAX_RULES};
+    static rules_bench_t rb;
+    for (size_t k = 0; k < sizeof(rule_counts) / sizeof(rule_counts[0]); k++) {
+        bench_case_t process = {"rules/process", rule_counts[k], op_rules_process, &rb};
+        
+        if (!rules_bench_init(&rb, rule_counts[k])) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        run_and_print(&process);
+        rule_engine_deinit(&rb.engine);
+    }
+    
+    static const int timer_counts[] = {1000, 10000, 100000};
+    static wheel_bench_t wb;
+    for (size_t k = 0; k < sizeof(timer_counts) / sizeof(timer_counts[0]); k++) {
+        bench_case_t expire = {"timer_wheel/tick", timer_counts[k], op_wheel_tick, &wb};
+        bench_case_t arm = {"timer_wheel/arm_cancel", timer_counts[k], op_wheel_arm_cancel, &wb};
+        
+        if (!wheel_bench_init(&wb, timer_counts[k])) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        run_and_print(&expire);
+        run_and_print(&arm);
+        wheel_bench_deinit(&wb);
+    }
+    
+    static esp_timer_bench_t eb;
+    for (size_t k = 0; k < sizeof(timer_counts) / sizeof(timer_counts[0]); k++) {
+        bench_case_t expire = {"esp_timer/tick", timer_counts[k], op_esp_timer_tick, &eb};
+        bench_case_t restart = {"esp_timer/restart", timer_counts[k], op_esp_timer_restart, &eb};
+        
+        if (!esp_timer_bench_init(&eb, timer_counts[k])) {
+            fprintf(stderr, "Out of memory\n");
+            esp_timer_bench_deinit(&eb);
+            return 1;
+        }
+        run_and_print(&expire);
+        // Every tick after the setup fires exactly one timer
+        uint64_t ticks = (uint64_t)(BENCH_WARMUP + BENCH_SAMPLES) * BENCH_BATCH;
+        if (eb.fired != ticks) {
+            fprintf(stderr, "esp_timer: %llu callbacks in %llu ticks with %d timers\n",
+                    (unsigned long long)eb.fired, (unsigned long long)ticks, timer_counts[k]);
+            esp_timer_bench_deinit(&eb);
+            return 1;
+        }
+        run_and_print(&restart);
+        esp_timer_bench_deinit(&eb);
+    }
+    
+    print_footer();
+    return 0;
+}
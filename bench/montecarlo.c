@@ -0,0 +1,619 @@
+// Monte Carlo debounce runner: millions of randomized press / bounce /
+// glitch / release scenarios, each on its own simulated board (GPIO
+// device, virtual clock, LED and button controllers), spread across all
+// cores. Build with logging compiled out (make montecarlo).
+//
+// Every scenario is generated from a single 64-bit seed. Each button gets
+// an independent timeline of gestures:
+//   press:  a bounce burst ending LOW, a hold, a bounce burst ending HIGH
+//   glitch: a burst of short LOW pulses that must never register
+// Bursts and holds keep a margin around the debounce delay, so both
+// engines have exactly one correct outcome and the checker can demand it:
+//   - every press gives one debounced press and one release, in order,
+//     and every glitch gives none
+//   - each transition lands between first edge + DEBOUNCE_DELAY_NS and
+//     settle + DEBOUNCE_DELAY_NS + 2 * DEBOUNCE_SAMPLE_NS (the timestamp
+//     engine: exactly settle + DEBOUNCE_DELAY_NS + 1)
+//   - each debounced press toggles its LED exactly once, and no LED
+//     changes outside a press action
+//   - no edge or event is lost to a full queue
+//
+// Scenarios are numbered 0 .. N-1 and split evenly between the workers;
+// a worker that runs out steals half of the remaining range of another.
+// Each worker checkpoints its fresh board once and restores it before
+// every scenario. Failing seeds are printed for --replay, which reruns
+// one scenario with a trace of its edges and transitions.
+//
+// Usage: montecarlo [--scenarios N] [--threads N] [--seed S]
+//                   [--gestures N] [--engine timestamp|vertical]
+//                   [--replay SEED]
+
+#include "gpio_mock.h"
+#include "led_control.h"
+#include "button_control.h"
+#include "sim_clock.h"
+#include "snapshot.h"
+#include "board.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MC_DEFAULT_SCENARIOS 1000000
+#define MC_DEFAULT_GESTURES 8       // Gestures per button and scenario
+#define MC_MAX_GESTURES 64
+#define MC_CHUNK 64                 // Scenarios taken from a range at a time
+#define MC_MAX_FAILURES 16          // Failing seeds kept per worker
+#define MC_EVENT_BATCH 16
+
+// Gesture shapes, in microseconds. Bursts stay well under the debounce
+// delay and holds and gaps well over it plus two sample periods.
+#define MC_MAX_BOUNCES 6            // Extra away-and-back pairs in a burst
+#define MC_BOUNCE_MIN_US 20
+#define MC_BOUNCE_MAX_US 2400       // 2 * 6 * 2.4 ms < 30 ms per burst
+#define MC_PULSE_MAX_US 3000        // Glitch: 6 pulses and gaps < 36 ms
+#define MC_HOLD_MIN_US 120000
+#define MC_HOLD_MAX_US 400000
+#define MC_START_MAX_US 50000
+#define MC_GLITCH_PERCENT 25
+
+// Edges one gesture can drive: two bursts of 1 + 2 * MC_MAX_BOUNCES
+#define MC_MAX_EDGES (MC_MAX_GESTURES * 2 * (1 + 2 * MC_MAX_BOUNCES))
+
+// Raw input edge of the stimulus
+typedef struct {
+    uint64_t time_ns;
+    uint32_t pin;
+    uint32_t level;
+} mc_edge_t;
+
+// Debounced transition the checker expects
+typedef struct {
+    uint64_t first_ns;    // First edge of the burst
+    uint64_t settle_ns;   // Last edge of the burst
+    button_state_t state;
+} mc_expect_t;
+
+// Failing scenario
+typedef struct {
+    uint64_t seed;
+    const char *reason;
+} mc_failure_t;
+
+typedef struct mc_worker mc_worker_t;
+
+// Run parameters, shared read-only by the workers
+typedef struct {
+    uint64_t scenarios;
+    uint64_t seed;
+    int gestures;
+    button_debounce_engine_t engine;
+    int threads;
+    mc_worker_t **workers;
+} mc_run_t;
+
+// One worker: its board, the scenario being checked and its statistics
+struct mc_worker {
+    // Remaining scenarios: next index in the low half, end in the high
+    // half. The owner takes from the front, thieves split off the back.
+    uint64_t range __attribute__((aligned(64)));
+
+    const mc_run_t *run;
+    int id;
+    pthread_t thread;
+    bool verbose;
+
+    gpio_device_t gpio;
+    sim_clock_t clock;
+    led_controller_t leds;
+    button_controller_t buttons;
+    uint8_t *reset;             // Checkpoint of the fresh board
+    size_t reset_len;
+
+    // Scenario
+    mc_edge_t stim[NUM_BUTTONS][MC_MAX_EDGES];
+    size_t stim_len[NUM_BUTTONS];
+    size_t stim_pos[NUM_BUTTONS];
+    mc_expect_t expect[NUM_BUTTONS][2 * MC_MAX_GESTURES];
+    size_t expect_len[NUM_BUTTONS];
+    size_t seen[NUM_BUTTONS];   // Transitions received so far
+    uint32_t led_edges[NUM_LEDS];
+    bool acting;                // Inside a press action
+    const char *failure;        // First broken invariant, NULL = none
+
+    // Statistics
+    uint64_t done;
+    uint64_t edges;
+    uint64_t transitions;
+    uint64_t steals;
+    uint64_t failed;
+    mc_failure_t failures[MC_MAX_FAILURES];
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// SplitMix64: scenario seeds from the run seed, and the scenario stream
+static uint64_t mc_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform value in [lo, hi]
+static uint64_t mc_range(uint64_t *state, uint64_t lo, uint64_t hi) {
+    return lo + mc_next(state) % (hi - lo + 1);
+}
+
+// Seed of scenario 'index' of a run
+static uint64_t mc_scenario_seed(uint64_t run_seed, uint64_t index) {
+    uint64_t state = run_seed ^ (index * 0xd1b54a32d192ed03ULL);
+    return mc_next(&state);
+}
+
+static void mc_fail(mc_worker_t *w, const char *reason) {
+    if (!w->failure) {
+        w->failure = reason;
+    }
+}
+
+static void mc_push_edge(mc_worker_t *w, int b, uint32_t pin, uint64_t t, uint32_t level) {
+    w->stim[b][w->stim_len[b]++] = (mc_edge_t){t, pin, level};
+}
+
+// Bounce burst settling at 'level': the edge to it, then away-and-back
+// pairs. Returns the time of the last edge.
+static uint64_t mc_burst(mc_worker_t *w, uint64_t *rng, int b, uint32_t pin, uint64_t t, uint32_t level) {
+    int bounces = (int)mc_range(rng, 0, MC_MAX_BOUNCES);
+    mc_push_edge(w, b, pin, t, level);
+    for (int k = 0; k < bounces; k++) {
+        t += mc_range(rng, MC_BOUNCE_MIN_US, MC_BOUNCE_MAX_US) * SIM_CLOCK_NS_PER_US;
+        mc_push_edge(w, b, pin, t, !level);
+        t += mc_range(rng, MC_BOUNCE_MIN_US, MC_BOUNCE_MAX_US) * SIM_CLOCK_NS_PER_US;
+        mc_push_edge(w, b, pin, t, level);
+    }
+    return t;
+}
+
+// Build the edges and expected transitions of one scenario
+static void mc_generate(mc_worker_t *w, uint64_t seed) {
+    uint64_t rng = seed;
+#define MC_BUTTON_PIN(n, name, pin, led) (pin),
+    static const uint32_t pins[NUM_BUTTONS] = {BOARD_BUTTONS(MC_BUTTON_PIN)};
+    
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+        uint32_t pin = pins[b];
+        uint64_t t = mc_range(&rng, 1, MC_START_MAX_US) * SIM_CLOCK_NS_PER_US;
+        w->stim_len[b] = 0;
+        w->stim_pos[b] = 0;
+        w->expect_len[b] = 0;
+        w->seen[b] = 0;
+        
+        for (int g = 0; g < w->run->gestures; g++) {
+            if (mc_range(&rng, 1, 100) <= MC_GLITCH_PERCENT) {
+                int pulses = (int)mc_range(&rng, 1, MC_MAX_BOUNCES);
+                for (int k = 0; k < pulses; k++) {
+                    mc_push_edge(w, b, pin, t, GPIO_LEVEL_LOW);
+                    t += mc_range(&rng, MC_BOUNCE_MIN_US, MC_PULSE_MAX_US) * SIM_CLOCK_NS_PER_US;
+                    mc_push_edge(w, b, pin, t, GPIO_LEVEL_HIGH);
+                    t += mc_range(&rng, MC_BOUNCE_MIN_US, MC_PULSE_MAX_US) * SIM_CLOCK_NS_PER_US;
+                }
+            } else {
+                uint64_t settle = mc_burst(w, &rng, b, pin, t, GPIO_LEVEL_LOW);
+                w->expect[b][w->expect_len[b]++] = (mc_expect_t){t, settle, BUTTON_PRESSED};
+                t = settle + mc_range(&rng, MC_HOLD_MIN_US, MC_HOLD_MAX_US) * SIM_CLOCK_NS_PER_US;
+                
+                settle = mc_burst(w, &rng, b, pin, t, GPIO_LEVEL_HIGH);
+                w->expect[b][w->expect_len[b]++] = (mc_expect_t){t, settle, BUTTON_RELEASED};
+                t = settle;
+            }
+            t += mc_range(&rng, MC_HOLD_MIN_US, MC_HOLD_MAX_US) * SIM_CLOCK_NS_PER_US;
+        }
+    }
+}
+
+// LED watch: every LED edge must come from a press action
+static void mc_led_watch(void *arg, uint64_t changed, uint64_t levels) {
+    mc_worker_t *w = arg;
+    (void)levels;
+    
+    if (!w->acting) {
+        mc_fail(w, "LED changed without a press");
+    }
+    while (changed) {
+        int pin = __builtin_ctzll(changed);
+        changed &= changed - 1;
+        int i = board_led_index((uint32_t)pin);
+        if (i >= 0) {
+            w->led_edges[i]++;
+        }
+    }
+}
+
+// Check one debounced transition against the next expected one
+static void mc_check_transition(mc_worker_t *w, const button_event_t *ev) {
+    int b = board_button_index(ev->pin);
+    if (b < 0) {
+        mc_fail(w, "transition on a pin that is not a button");
+        return;
+    }
+    if (w->seen[b] >= w->expect_len[b]) {
+        mc_fail(w, "transition without a press (glitch registered)");
+        return;
+    }
+    
+    const mc_expect_t *ex = &w->expect[b][w->seen[b]++];
+    if (ev->state != ex->state) {
+        mc_fail(w, "transitions out of order");
+    } else if (w->run->engine == BUTTON_DEBOUNCE_TIMESTAMP) {
+        if (ev->time_ns != ex->settle_ns + DEBOUNCE_DELAY_NS + 1) {
+            mc_fail(w, "transition not at settle + debounce delay");
+        }
+    } else if (ev->time_ns < ex->first_ns + DEBOUNCE_DELAY_NS) {
+        mc_fail(w, "transition before the debounce delay");
+    } else if (ev->time_ns > ex->settle_ns + DEBOUNCE_DELAY_NS + 2 * DEBOUNCE_SAMPLE_NS) {
+        mc_fail(w, "transition later than two samples past the delay");
+    }
+    
+    if (w->verbose) {
+        printf("%12.3f ms  %-4s %s\n", ev->time_ns / 1e6, board_pin_name(ev->pin),
+               ev->state == BUTTON_PRESSED ? "pressed" : "released");
+    }
+}
+
+// Application: take the debounced events, toggle the LED of each press
+static void mc_process_events(mc_worker_t *w) {
+    button_event_t events[MC_EVENT_BATCH];
+    size_t n;
+    
+    while ((n = button_ctrl_get_events(&w->buttons, events, MC_EVENT_BATCH)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            mc_check_transition(w, &events[i]);
+            w->transitions++;
+            if (events[i].state != BUTTON_PRESSED) {
+                continue;
+            }
+            
+            int led = board_button_led(events[i].pin);
+            int li = led >= 0 ? board_led_index((uint32_t)led) : -1;
+            if (li < 0) {
+                continue;
+            }
+            uint32_t before = w->led_edges[li];
+            w->acting = true;
+            led_ctrl_toggle(&w->leds, (uint32_t)led);
+            w->acting = false;
+            if (w->led_edges[li] != before + 1) {
+                mc_fail(w, "press did not toggle its LED exactly once");
+            }
+        }
+    }
+}
+
+// Run the board up to 't', servicing every debounce deadline on the way
+static void mc_advance(mc_worker_t *w, uint64_t t) {
+    uint64_t deadline;
+    while (button_ctrl_next_deadline(&w->buttons, &deadline) && deadline <= t) {
+        sim_clock_set(&w->clock, deadline);
+        button_ctrl_update_all(&w->buttons);
+        mc_process_events(w);
+    }
+    sim_clock_set(&w->clock, t);
+}
+
+// Run one scenario on the worker's board
+// Returns NULL if it passed, otherwise the first broken invariant.
+static const char *mc_run_scenario(mc_worker_t *w, uint64_t seed) {
+    mc_generate(w, seed);
+    
+    snapshot_board_t board = {&w->gpio, &w->leds, &w->buttons, &w->clock};
+    if (!snapshot_restore(&board, w->reset, w->reset_len)) {
+        return "board reset failed";
+    }
+    memset(w->led_edges, 0, sizeof(w->led_edges));
+    w->failure = NULL;
+    uint64_t edge_overflows = w->buttons.edge_overflows;
+    uint64_t event_overflows = w->buttons.event_overflows;
+    uint64_t leds_before = gpio_dev_read_all(&w->gpio);
+    
+    // Merge the per-button timelines in time order
+    for (;;) {
+        int next = -1;
+        for (int b = 0; b < NUM_BUTTONS; b++) {
+            if (w->stim_pos[b] < w->stim_len[b] &&
+                (next < 0 || w->stim[b][w->stim_pos[b]].time_ns < w->stim[next][w->stim_pos[next]].time_ns)) {
+                next = b;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        
+        const mc_edge_t *e = &w->stim[next][w->stim_pos[next]++];
+        mc_advance(w, e->time_ns);
+        gpio_dev_drive_inputs(&w->gpio, GPIO_PIN_SEL(e->pin), (uint64_t)e->level << e->pin);
+        button_ctrl_update_all(&w->buttons);
+        mc_process_events(w);
+        w->edges++;
+        if (w->verbose) {
+            printf("%12.3f ms  %-4s %s\n", e->time_ns / 1e6, board_pin_name(e->pin),
+                   e->level ? "HIGH" : "LOW");
+        }
+    }
+    
+    // Let the last bursts settle
+    uint64_t deadline;
+    while (button_ctrl_next_deadline(&w->buttons, &deadline)) {
+        mc_advance(w, deadline);
+    }
+    button_ctrl_update_all(&w->buttons);
+    mc_process_events(w);
+    
+    uint64_t leds_after = gpio_dev_read_all(&w->gpio);
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+        if (w->seen[b] != w->expect_len[b]) {
+            mc_fail(w, "debounced press or release missing");
+        }
+    }
+    // Each LED ends where its toggles left it
+#define MC_LED_CHECK(n, name, pin) \
+    if ((((leds_before ^ leds_after) >> (pin)) & 1) != (w->led_edges[(n) - 1] & 1)) { \
+        mc_fail(w, "LED level does not match its toggles"); \
+    }
+    BOARD_LEDS(MC_LED_CHECK)
+    if (w->buttons.edge_overflows != edge_overflows || w->buttons.event_overflows != event_overflows) {
+        mc_fail(w, "edge or event lost to a full queue");
+    }
+    return w->failure;
+}
+
+static inline uint64_t mc_pack(uint32_t lo, uint32_t hi) {
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Take up to MC_CHUNK scenarios from the front of the worker's own range
+static bool mc_take(mc_worker_t *w, uint32_t *lo, uint32_t *hi) {
+    uint64_t r = __atomic_load_n(&w->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t first = (uint32_t)r;
+        uint32_t end = (uint32_t)(r >> 32);
+        if (first >= end) {
+            return false;
+        }
+        uint32_t last = end - first > MC_CHUNK ? first + MC_CHUNK : end;
+        if (__atomic_compare_exchange_n(&w->range, &r, mc_pack(last, end), false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *lo = first;
+            *hi = last;
+            return true;
+        }
+    }
+}
+
+// Steal the back half of another worker's range into our own
+static bool mc_steal(mc_worker_t *w) {
+    const mc_run_t *run = w->run;
+    for (int k = 1; k < run->threads; k++) {
+        mc_worker_t *victim = run->workers[(w->id + k) % run->threads];
+        uint64_t r = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+            uint32_t first = (uint32_t)r;
+            uint32_t end = (uint32_t)(r >> 32);
+            if (first >= end) {
+                break;
+            }
+            uint32_t mid = first + (end - first) / 2;
+            if (__atomic_compare_exchange_n(&victim->range, &r, mc_pack(first, mid), false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                // Nobody touches an empty range, so a plain store is enough
+                __atomic_store_n(&w->range, mc_pack(mid, end), __ATOMIC_RELEASE);
+                w->steals++;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void *mc_worker_main(void *arg) {
+    mc_worker_t *w = arg;
+    uint32_t lo, hi;
+    
+    for (;;) {
+        if (!mc_take(w, &lo, &hi) && !(mc_steal(w) && mc_take(w, &lo, &hi))) {
+            break;
+        }
+        for (uint32_t i = lo; i < hi; i++) {
+            uint64_t seed = mc_scenario_seed(w->run->seed, i);
+            const char *reason = mc_run_scenario(w, seed);
+            if (reason) {
+                if (w->failed < MC_MAX_FAILURES) {
+                    w->failures[w->failed] = (mc_failure_t){seed, reason};
+                }
+                w->failed++;
+            }
+            w->done++;
+        }
+    }
+    return NULL;
+}
+
+// Wire a worker's board and checkpoint it
+static mc_worker_t *mc_worker_create(const mc_run_t *run, int id) {
+    mc_worker_t *w;
+    if (posix_memalign((void **)&w, 64, sizeof(*w)) != 0) {
+        return NULL;
+    }
+    memset(w, 0, sizeof(*w));
+    w->run = run;
+    w->id = id;
+    
+    gpio_dev_init(&w->gpio);
+    sim_clock_configure(&w->clock, SIM_CLOCK_VIRTUAL);
+    led_ctrl_init_board(&w->leds, &w->gpio);
+    button_ctrl_init_board(&w->buttons, &w->gpio, &w->clock, run->engine);
+    gpio_dev_add_watch(&w->gpio, BOARD_LED_MASK, mc_led_watch, w);
+    
+    snapshot_board_t board = {&w->gpio, &w->leds, &w->buttons, &w->clock};
+    w->reset_len = snapshot_size(&board);
+    w->reset = malloc(w->reset_len);
+    if (!w->reset || snapshot_save(&board, w->reset, w->reset_len) == 0) {
+        free(w->reset);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+static void mc_worker_destroy(mc_worker_t *w) {
+    button_ctrl_deinit(&w->buttons);
+    led_ctrl_deinit(&w->leds);
+    free(w->reset);
+    free(w);
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--scenarios N] [--threads N] [--seed S] [--gestures N]\n"
+            "          [--engine timestamp|vertical] [--replay SEED]\n", prog);
+    return 1;
+}
+
+// Rerun one scenario with a trace of its edges and transitions
+static int mc_replay(mc_run_t *run, uint64_t seed) {
+    mc_worker_t *w = mc_worker_create(run, 0);
+    if (!w) {
+        fprintf(stderr, "Failed to set up the board\n");
+        return 1;
+    }
+    w->verbose = true;
+    printf("Replaying seed 0x%016llx (%s engine, %d gestures per button)\n",
+           (unsigned long long)seed, run->engine == BUTTON_DEBOUNCE_VERTICAL ? "vertical" : "timestamp",
+           run->gestures);
+    const char *reason = mc_run_scenario(w, seed);
+    printf("%s%s\n", reason ? "FAIL: " : "PASS", reason ? reason : "");
+    mc_worker_destroy(w);
+    return reason ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    mc_run_t run = {
+        .scenarios = MC_DEFAULT_SCENARIOS,
+        .seed = (uint64_t)time(NULL),
+        .gestures = MC_DEFAULT_GESTURES,
+        .engine = BUTTON_DEBOUNCE_TIMESTAMP,
+        .threads = (int)sysconf(_SC_NPROCESSORS_ONLN)
+    };
+    bool replay = false;
+    uint64_t replay_seed = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            return usage(argv[0]);
+        }
+        if (strcmp(argv[i], "--scenarios") == 0) {
+            run.scenarios = strtoull(value, NULL, 0);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            run.threads = atoi(value);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            run.seed = strtoull(value, NULL, 0);
+        } else if (strcmp(argv[i], "--gestures") == 0) {
+            run.gestures = atoi(value);
+        } else if (strcmp(argv[i], "--engine") == 0) {
+            int engine = button_parse_engine(value);
+            if (engine < 0) {
+                fprintf(stderr, "Invalid engine: %s\n", value);
+                return 1;
+            }
+            run.engine = (button_debounce_engine_t)engine;
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replay = true;
+            replay_seed = strtoull(value, NULL, 0);
+        } else {
+            return usage(argv[0]);
+        }
+        i++;
+    }
+    if (run.gestures < 1 || run.gestures > MC_MAX_GESTURES) {
+        fprintf(stderr, "Gestures must be 1..%d\n", MC_MAX_GESTURES);
+        return 1;
+    }
+    if (run.scenarios > UINT32_MAX) {
+        fprintf(stderr, "At most %u scenarios per run\n", UINT32_MAX);
+        return 1;
+    }
+    if (run.threads < 1) {
+        run.threads = 1;
+    }
+    if (replay) {
+        return mc_replay(&run, replay_seed);
+    }
+    
+    mc_worker_t *workers[run.threads];
+    run.workers = workers;
+    for (int t = 0; t < run.threads; t++) {
+        workers[t] = mc_worker_create(&run, t);
+        if (!workers[t]) {
+            fprintf(stderr, "Failed to set up board %d\n", t);
+            return 1;
+        }
+        uint32_t lo = (uint32_t)(run.scenarios * (uint64_t)t / (uint64_t)run.threads);
+        uint32_t hi = (uint32_t)(run.scenarios * (uint64_t)(t + 1) / (uint64_t)run.threads);
+        workers[t]->range = mc_pack(lo, hi);
+    }
+    
+    printf("Monte Carlo debounce run: %llu scenarios, %d threads, %s engine, "
+           "%d gestures per button, seed 0x%016llx\n",
+           (unsigned long long)run.scenarios, run.threads,
+           run.engine == BUTTON_DEBOUNCE_VERTICAL ? "vertical" : "timestamp", run.gestures,
+           (unsigned long long)run.seed);
+    
+    uint64_t start = now_ns();
+    for (int t = 0; t < run.threads; t++) {
+        if (pthread_create(&workers[t]->thread, NULL, mc_worker_main, workers[t]) != 0) {
+            fprintf(stderr, "Failed to start worker %d\n", t);
+            return 1;
+        }
+    }
+    for (int t = 0; t < run.threads; t++) {
+        pthread_join(workers[t]->thread, NULL);
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+    
+    uint64_t done = 0, edges = 0, transitions = 0, steals = 0, failed = 0;
+    for (int t = 0; t < run.threads; t++) {
+        mc_worker_t *w = workers[t];
+        done += w->done;
+        edges += w->edges;
+        transitions += w->transitions;
+        steals += w->steals;
+        failed += w->failed;
+        for (uint64_t k = 0; k < w->failed && k < MC_MAX_FAILURES; k++) {
+            printf("FAIL seed 0x%016llx: %s\n", (unsigned long long)w->failures[k].seed, w->failures[k].reason);
+        }
+    }
+    
+    printf("Scenarios:    %llu (%llu failed)\n", (unsigned long long)done, (unsigned long long)failed);
+    printf("Edges:        %llu driven, %llu debounced transitions\n",
+           (unsigned long long)edges, (unsigned long long)transitions);
+    printf("Steals:       %llu\n", (unsigned long long)steals);
+    printf("Elapsed:      %.3f s\n", elapsed);
+    printf("Throughput:   %.0f scenarios/s, %.0f edges/s\n",
+           elapsed > 0 ? done / elapsed : 0.0, elapsed > 0 ? edges / elapsed : 0.0);
+    if (failed) {
+        printf("Reproduce one with: montecarlo --replay SEED --gestures %d --engine %s\n", run.gestures,
+               run.engine == BUTTON_DEBOUNCE_VERTICAL ? "vertical" : "timestamp");
+    }
+    
+    for (int t = 0; t < run.threads; t++) {
+        mc_worker_destroy(workers[t]);
+    }
+    return failed ? 1 : 0;
+}
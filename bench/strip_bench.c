@@ -0,0 +1,225 @@
+// LED strip benchmark: animations drawn into WS2812 strips of 64 to 16384
+// pixels, each frame refreshed through the symbol encoder on a virtual
+// clock. Reports the host time per frame (the frame rate the simulation
+// sustains) next to the frame rate the wire allows, then decodes the
+// symbol buffer and, for the shorter strips, the pin waveform captured
+// edge by edge, and checks both against the drawing buffer.
+// Build with logging compiled out (make bench-strip).
+
+#include "led_strip.h"
+#include "gpio_mock.h"
+#include "sim_clock.h"
+#include "timer_wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_PIN 13
+#define BENCH_FRAME_NS (SIM_CLOCK_NS_PER_SEC / 60)  // Animation frame period
+#define BENCH_PIXEL_FRAMES (1u << 22)               // Pixels drawn per run
+#define BENCH_MIN_FRAMES 64
+#define BENCH_PIN_VERIFY_MAX 1024                   // Longest strip checked edge by edge
+#define BENCH_COMET 16                              // Chase tail length
+
+// One animation: draw frame 'frame' into the strip
+typedef struct {
+    const char *name;
+    void (*draw)(led_strip_t *strip, uint32_t frame);
+} bench_animation_t;
+
+// Strip on its own board, clock and wheel
+typedef struct {
+    gpio_device_t gpio;
+    sim_clock_t clock;
+    timer_wheel_t wheel;
+    led_strip_t strip;
+} strip_bench_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Color wheel: hue 0..255 to a fully saturated color
+static led_strip_pixel_t hue_color(uint32_t hue) {
+    uint8_t h = (uint8_t)hue;
+    uint8_t x = (uint8_t)((h % 85) * 3);
+    led_strip_pixel_t px = {0, 0, 0};
+    if (h < 85) {
+        px.r = (uint8_t)(255 - x);
+        px.g = x;
+    } else if (h < 170) {
+        px.g = (uint8_t)(255 - x);
+        px.b = x;
+    } else {
+        px.r = x;
+        px.b = (uint8_t)(255 - x);
+    }
+    return px;
+}
+
+// Rainbow scrolling along the strip: every pixel changes every frame
+static void draw_rainbow(led_strip_t *strip, uint32_t frame) {
+    uint32_t length = strip->config.length;
+    for (uint32_t i = 0; i < length; i++) {
+        led_strip_pixel_t px = hue_color(i * 256 / length + frame * 4);
+        led_strip_set_pixel(strip, i, px.r, px.g, px.b);
+    }
+}
+
+// Comet with a fading tail moving one pixel per frame
+static void draw_chase(led_strip_t *strip, uint32_t frame) {
+    uint32_t length = strip->config.length;
+    uint32_t head = frame % length;
+    led_strip_set_pixel(strip, (head + length - BENCH_COMET % length) % length, 0, 0, 0);
+    for (uint32_t k = 0; k < BENCH_COMET && k < length; k++) {
+        uint8_t level = (uint8_t)(255 >> (k / 2));
+        led_strip_set_pixel(strip, (head + length - k) % length, level, level / 2, 0);
+    }
+}
+
+// The same frame over and over: nothing is re-encoded
+static void draw_static(led_strip_t *strip, uint32_t frame) {
+    uint32_t length = strip->config.length;
+    (void)frame;
+    for (uint32_t i = 0; i < length; i++) {
+        led_strip_set_pixel(strip, i, 16, 16, 16);
+    }
+}
+
+static bool strip_bench_init(strip_bench_t *sb, uint32_t length) {
+    led_strip_config_t config = {
+        .gpio_num = BENCH_PIN,
+        .length = length,
+        .order = LED_STRIP_ORDER_GRB,
+        .timing = LED_STRIP_TIMING_WS2812
+    };
+    gpio_dev_init(&sb->gpio);
+    sim_clock_configure(&sb->clock, SIM_CLOCK_VIRTUAL);
+    timer_wheel_init(&sb->wheel, &sb->clock);
+    return led_strip_init(&sb->strip, &sb->gpio, &sb->clock, &sb->wheel, &config);
+}
+
+// Check decoded pixels against the drawing buffer
+static bool pixels_match(const led_strip_t *strip, const led_strip_pixel_t *decoded, size_t count) {
+    if (count != strip->config.length) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        led_strip_pixel_t px = led_strip_get_pixel(strip, (uint32_t)i);
+        if (px.r != decoded[i].r || px.g != decoded[i].g || px.b != decoded[i].b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run the animation at 60 fps, or as fast as the wire allows; the clock
+// is virtual, so only the host time of drawing and refreshing counts
+static bool run_animation(const bench_animation_t *anim, uint32_t length, led_strip_pixel_t *decoded) {
+    static strip_bench_t sb;
+    if (!strip_bench_init(&sb, length)) {
+        return false;
+    }
+    
+    uint32_t frames = BENCH_PIXEL_FRAMES / length;
+    if (frames < BENCH_MIN_FRAMES) {
+        frames = BENCH_MIN_FRAMES;
+    }
+    uint64_t host_ns = 0;
+    uint64_t wire_ns = 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        uint64_t t0 = now_ns();
+        anim->draw(&sb.strip, f);
+        bool sent = led_strip_refresh(&sb.strip);
+        host_ns += now_ns() - t0;
+        if (!sent) {
+            fprintf(stderr, "Refresh refused for %u pixels\n", length);
+            return false;
+        }
+        
+        uint64_t start = sim_clock_now(&sb.clock);
+        wire_ns = sb.strip.ready_ns - start;
+        sim_clock_set(&sb.clock, start + (wire_ns > BENCH_FRAME_NS ? wire_ns : BENCH_FRAME_NS));
+    }
+    
+    size_t count = length;
+    bool ok = led_strip_decode(&sb.strip.config, sb.strip.symbols, led_strip_symbol_count(&sb.strip), decoded,
+                               &count) && pixels_match(&sb.strip, decoded, count);
+    
+    double ns = (double)host_ns / frames;
+    printf("%s,%u,%.0f,%.2f,%.0f,%.1f,%.1f\n", anim->name, length, ns, ns / length, 1e9 / ns,
+           1e9 / (double)wire_ns, (double)sb.strip.encoded / frames);
+    led_strip_deinit(&sb.strip);
+    if (!ok) {
+        fprintf(stderr, "Decoded symbols differ from the pixels for %s on %u pixels\n", anim->name, length);
+    }
+    return ok;
+}
+
+// Send one rainbow frame with the pin observed, stepping the clock to
+// every edge, and decode what the receiver captured
+static bool verify_pin(uint32_t length, led_strip_pixel_t *decoded) {
+    static strip_bench_t sb;
+    led_strip_rx_t rx;
+    if (!strip_bench_init(&sb, length)) {
+        return false;
+    }
+    if (!led_strip_rx_start(&rx, &sb.gpio, &sb.clock, BENCH_PIN, led_strip_symbol_count(&sb.strip))) {
+        led_strip_deinit(&sb.strip);
+        return false;
+    }
+    
+    draw_rainbow(&sb.strip, 7);
+    led_strip_refresh(&sb.strip);
+    uint64_t deadline;
+    while (timer_wheel_next_deadline(&sb.wheel, &deadline)) {
+        sim_clock_set(&sb.clock, deadline);
+        timer_wheel_run(&sb.wheel);
+    }
+    sim_clock_set(&sb.clock, sb.strip.ready_ns);
+    
+    size_t count = length;
+    bool ok = led_strip_rx_decode(&rx, &sb.strip.config, decoded, &count) && pixels_match(&sb.strip, decoded, count);
+    printf("pin-verify,%u,%llu,%s\n", length, (unsigned long long)sb.strip.edges, ok ? "ok" : "FAILED");
+    led_strip_rx_stop(&rx);
+    led_strip_deinit(&sb.strip);
+    return ok;
+}
+
+int main(void) {
+    static const uint32_t lengths[] = {64, 256, 1024, 4096, 16384};
+    static const bench_animation_t animations[] = {
+        {"rainbow", draw_rainbow},
+        {"chase", draw_chase},
+        {"static", draw_static}
+    };
+    const size_t num_lengths = sizeof(lengths) / sizeof(lengths[0]);
+    const size_t num_animations = sizeof(animations) / sizeof(animations[0]);
+    
+    led_strip_pixel_t *decoded = malloc(lengths[num_lengths - 1] * sizeof(*decoded));
+    if (!decoded) {
+        return 1;
+    }
+    
+    int status = 0;
+    printf("animation,pixels,ns_per_frame,ns_per_pixel,sim_fps,wire_fps,encoded_per_frame\n");
+    for (size_t k = 0; k < num_lengths; k++) {
+        for (size_t a = 0; a < num_animations; a++) {
+            if (!run_animation(&animations[a], lengths[k], decoded)) {
+                status = 1;
+            }
+        }
+    }
+    
+    printf("\ncheck,pixels,edges,result\n");
+    for (size_t k = 0; k < num_lengths && lengths[k] <= BENCH_PIN_VERIFY_MAX; k++) {
+        if (!verify_pin(lengths[k], decoded)) {
+            status = 1;
+        }
+    }
+    free(decoded);
+    return status;
+}
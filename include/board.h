@@ -0,0 +1,106 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Board description: the single place where pins are assigned. Pin
+// constants, counts and masks, the registration tables, the status dump,
+// the help text and the default button rules are all generated from these
+// two lists, so wiring a different board means editing only this block.
+//
+//   BOARD_LEDS(X):    X(n, name, pin)
+//   BOARD_BUTTONS(X): X(n, name, pin, led)   'led' = name of the LED it toggles
+//
+// Rows are numbered 1, 2, ... in order (typed commands use the digit, so
+// keep at most 9 of each). A pin used twice fails to compile.
+#define BOARD_LEDS(X) \
+    X(1, LED1, 2) \
+    X(2, LED2, 4) \
+    X(3, LED3, 5)
+
+#define BOARD_BUTTONS(X) \
+    X(1, BTN1, 18, LED1) \
+    X(2, BTN2, 19, LED2) \
+    X(3, BTN3, 21, LED3)
+
+// Generated pin constants: LEDn_PIN / BUTTONn_PIN by row number and
+// BOARD_PIN_<name> by name
+#define BOARD_LED_PIN_ENUM(n, name, pin) LED##n##_PIN = (pin), BOARD_PIN_##name = (pin),
+#define BOARD_BUTTON_PIN_ENUM(n, name, pin, led) BUTTON##n##_PIN = (pin), BOARD_PIN_##name = (pin),
+enum { BOARD_LEDS(BOARD_LED_PIN_ENUM) };
+enum { BOARD_BUTTONS(BOARD_BUTTON_PIN_ENUM) };
+
+// Generated counts and pin masks
+#define BOARD_COUNT_ROW(...) + 1
+#define BOARD_LED_BIT(n, name, pin) | (1ULL << (pin))
+#define BOARD_BUTTON_BIT(n, name, pin, led) | (1ULL << (pin))
+
+#define NUM_LEDS (0 BOARD_LEDS(BOARD_COUNT_ROW))          // LEDs on the default board
+#define NUM_BUTTONS (0 BOARD_BUTTONS(BOARD_COUNT_ROW))    // Buttons on the default board
+#define BOARD_LED_MASK (0ULL BOARD_LEDS(BOARD_LED_BIT))
+#define BOARD_BUTTON_MASK (0ULL BOARD_BUTTONS(BOARD_BUTTON_BIT))
+#define BOARD_PIN_MASK (BOARD_LED_MASK | BOARD_BUTTON_MASK)
+
+// Generated lookups. They are switches over constants, so a call with a
+// constant pin folds to a constant.
+#define BOARD_LED_INDEX_CASE(n, name, pin) case (pin): return (n) - 1;
+#define BOARD_BUTTON_INDEX_CASE(n, name, pin, led) case (pin): return (n) - 1;
+#define BOARD_BUTTON_LED_CASE(n, name, pin, led) case (pin): return BOARD_PIN_##led;
+#define BOARD_PIN_NAME_LED_CASE(n, name, pin) case (pin): return #name;
+#define BOARD_PIN_NAME_BUTTON_CASE(n, name, pin, led) case (pin): return #name;
+
+// Row of a board LED (0-based), -1 for any other pin
+static inline int board_led_index(uint32_t pin) {
+    switch (pin) {
+        BOARD_LEDS(BOARD_LED_INDEX_CASE)
+        default:
+            return -1;
+    }
+}
+
+// Row of a board button (0-based), -1 for any other pin
+static inline int board_button_index(uint32_t pin) {
+    switch (pin) {
+        BOARD_BUTTONS(BOARD_BUTTON_INDEX_CASE)
+        default:
+            return -1;
+    }
+}
+
+// Pin of the LED a board button toggles, -1 for any other pin
+static inline int board_button_led(uint32_t pin) {
+    switch (pin) {
+        BOARD_BUTTONS(BOARD_BUTTON_LED_CASE)
+        default:
+            return -1;
+    }
+}
+
+// Name of a board LED or button, NULL for any other pin. LEDs and
+// buttons share the switch, so a pin wired to both fails to compile.
+static inline const char *board_pin_name(uint32_t pin) {
+    switch (pin) {
+        BOARD_LEDS(BOARD_PIN_NAME_LED_CASE)
+        BOARD_BUTTONS(BOARD_PIN_NAME_BUTTON_CASE)
+        default:
+            return NULL;
+    }
+}
+
+// Fixed board (BOARD_FIXED, set by 'make release'): the board pins are
+// configured once at start-up by led_init_all() / button_init_all() and
+// never reconfigured, so accesses to them skip the GPIO_IS_VALID_GPIO,
+// initialized and mode checks, and the LED / button controllers find them
+// by row instead of through their pin tables. Combined with link-time
+// optimization, an access with a constant pin compiles to a direct
+// register operation.
+#ifdef BOARD_FIXED
+#define BOARD_IS_FIXED_OUTPUT(pin) ((pin) < 64 && (BOARD_LED_MASK & (1ULL << (pin))) != 0)
+#define BOARD_IS_FIXED_PIN(pin) ((pin) < 64 && (BOARD_PIN_MASK & (1ULL << (pin))) != 0)
+#else
+#define BOARD_IS_FIXED_OUTPUT(pin) 0
+#define BOARD_IS_FIXED_PIN(pin) 0
+#endif
+
+#endif // BOARD_H
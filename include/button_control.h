@@ -2,15 +2,29 @@
 #define BUTTON_CONTROL_H
 
 #include "gpio_mock.h"
+#include "board.h"
+#include "sim_clock.h"
+#include "debounce_vc.h"
+#include "mpsc_ring.h"
+#include "timer_wheel.h"
 #include <stdbool.h>
 
-// Button definitions
-#define BUTTON1_PIN GPIO_NUM_18
-#define BUTTON2_PIN GPIO_NUM_19
-#define BUTTON3_PIN GPIO_NUM_21
-
-#define NUM_BUTTONS 3
+// Button pins (BUTTONn_PIN) and NUM_BUTTONS come from the board description
 #define DEBOUNCE_DELAY_MS 50
+#define DEBOUNCE_DELAY_NS ((uint64_t)DEBOUNCE_DELAY_MS * SIM_CLOCK_NS_PER_MS)
+
+// Vertical counter engine: sample period and samples needed to flip.
+// The count includes the sample that first saw the change, so a flip
+// lands on the first sample more than DEBOUNCE_DELAY_MS after the edge,
+// exactly like the timestamp engine sampled at the same rate.
+#define DEBOUNCE_SAMPLE_MS 10
+#define DEBOUNCE_SAMPLE_NS ((uint64_t)DEBOUNCE_SAMPLE_MS * SIM_CLOCK_NS_PER_MS)
+#define DEBOUNCE_VC_THRESHOLD (DEBOUNCE_DELAY_MS / DEBOUNCE_SAMPLE_MS + 2)
+
+// Queue depths: raw edges raised between two updates, and debounced
+// events waiting for the application
+#define BUTTON_EDGE_QUEUE_LEN 1024
+#define BUTTON_EVENT_QUEUE_LEN 256
 
 // Button states
 typedef enum {
@@ -18,19 +32,101 @@ typedef enum {
     BUTTON_PRESSED = 1
 } button_state_t;
 
+// Debounce engines, selected when a controller is initialized
+typedef enum {
+    BUTTON_DEBOUNCE_TIMESTAMP = 0,  // Per-button debounce deadline timers
+    BUTTON_DEBOUNCE_VERTICAL = 1    // Bit-parallel vertical counters (debounce_vc)
+} button_debounce_engine_t;
+
 // Button structure for debouncing
 typedef struct {
     uint32_t pin;
     button_state_t current_state;
     button_state_t last_state;
-    uint32_t last_debounce_time;
+    uint64_t last_debounce_time;   // sim_clock_now_ns() of the last raw edge
     bool state_changed;
     const char* name;
 } button_t;
 
-// Function declarations
+// Raw input edge queued by the pin interrupt handler
+typedef struct {
+    uint64_t time_ns;  // sim_clock_now() when the edge was raised
+    uint32_t pin;
+    uint32_t level;    // Pin level after the edge
+} button_edge_t;
+
+// Debounced transition queued for the application
+typedef struct {
+    uint64_t time_ns;  // sim_clock_now() when the transition took effect
+    uint32_t pin;
+    button_state_t state;
+} button_event_t;
+
+typedef struct button_controller button_controller_t;
+
+// Interrupt handler argument of one button pin
+typedef struct {
+    button_controller_t *ctrl;
+    uint32_t pin;
+} button_isr_arg_t;
+
+// Button controller: registry of the buttons of one board. A pin holds
+// at most one button, so per-button bit masks fit in 64 bits.
+struct button_controller {
+    gpio_device_t *gpio;       // Board the buttons are wired to
+    sim_clock_t *clock;        // Time source for debouncing
+    button_debounce_engine_t engine;
+    button_t *buttons;         // Dense storage in registration order
+    size_t count;
+    size_t capacity;
+    int16_t pin_index[GPIO_NUM_MAX];  // Pin -> index into buttons, -1 if none
+    uint64_t pin_mask;         // Pins of every registered button
+    bool board;                // buttons[0 .. NUM_BUTTONS - 1] are the board buttons, in order
+    uint64_t event_buttons;    // Bit i: buttons[i].state_changed is set
+    debounce_vc_t vc;          // Vertical counter state (BUTTON_DEBOUNCE_VERTICAL)
+    uint64_t next_sample_time; // Next vertical counter sample while counting
+    timer_wheel_t wheel;       // Debounce deadlines (BUTTON_DEBOUNCE_TIMESTAMP)
+    mpsc_ring_t edges;         // Raw edges from the interrupt handlers
+    mpsc_ring_t events;        // Debounced transitions for the application
+    uint64_t edge_overflow;    // Pins with edges lost to a full queue (atomic)
+    uint64_t edge_overflows;   // Edges that did not fit in 'edges' (atomic)
+    uint64_t event_overflows;  // Transitions that did not fit in 'events'
+    button_isr_arg_t isr_args[GPIO_NUM_MAX];
+    timer_wheel_timer_t debounce_timers[GPIO_NUM_MAX];  // By pin, on 'wheel'
+};
+
+// Controller functions
+void button_ctrl_init(button_controller_t *ctrl, gpio_device_t *gpio, sim_clock_t *clock,
+                      button_debounce_engine_t engine);
+void button_ctrl_deinit(button_controller_t *ctrl);
+int button_ctrl_register(button_controller_t *ctrl, uint32_t button_pin, const char *name);
+void button_ctrl_init_board(button_controller_t *ctrl, gpio_device_t *gpio, sim_clock_t *clock,
+                            button_debounce_engine_t engine);
+void button_ctrl_update_all(button_controller_t *ctrl);
+bool button_ctrl_next_deadline(const button_controller_t *ctrl, uint64_t *deadline_ns);
+bool button_ctrl_has_events(const button_controller_t *ctrl);
+size_t button_ctrl_get_events(button_controller_t *ctrl, button_event_t *events, size_t max);
+button_state_t button_ctrl_get_state(const button_controller_t *ctrl, uint32_t button_pin);
+bool button_ctrl_is_pressed(const button_controller_t *ctrl, uint32_t button_pin);
+bool button_ctrl_was_pressed(const button_controller_t *ctrl, uint32_t button_pin);
+bool button_ctrl_was_released(const button_controller_t *ctrl, uint32_t button_pin);
+void button_ctrl_clear_events(button_controller_t *ctrl, uint32_t button_pin);
+void button_ctrl_display_status(const button_controller_t *ctrl);
+const char* button_ctrl_get_name(const button_controller_t *ctrl, uint32_t button_pin);
+void button_ctrl_simulate_press(button_controller_t *ctrl, uint32_t button_pin);
+void button_ctrl_simulate_release(button_controller_t *ctrl, uint32_t button_pin);
+void button_ctrl_reload(button_controller_t *ctrl);
+
+// Default-instance API (operates on button_default_controller())
+button_controller_t *button_default_controller(void);
+void button_set_default_engine(button_debounce_engine_t engine);
+int button_parse_engine(const char *name);
 void button_init_all(void);
+int button_register(uint32_t button_pin, const char *name);
 void button_update_all(void);
+bool button_next_deadline(uint64_t *deadline_ns);
+bool button_has_events(void);
+size_t button_get_events(button_event_t *events, size_t max);
 button_state_t button_get_state(uint32_t button_pin);
 bool button_is_pressed(uint32_t button_pin);
 bool button_was_pressed(uint32_t button_pin);
@@ -38,7 +134,7 @@ bool button_was_released(uint32_t button_pin);
 void button_clear_events(uint32_t button_pin);
 void button_display_status(void);
 const char* button_get_name(uint32_t button_pin);
-uint32_t button_get_time_ms(void);
+uint64_t button_get_time_ms(void);
 
 // Simulation functions (for testing)
 void button_simulate_press(uint32_t button_pin);
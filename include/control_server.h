@@ -0,0 +1,119 @@
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Local control server: a Unix domain stream socket that takes framed
+// binary batches of operations. The server handles framing and
+// connections on the event loop; the application executes each batch in
+// one call, between two ticks, and the server sends one reply per batch.
+//
+// Wire format (host byte order, no padding beyond what is shown):
+//   request: control_header_t, then 'count' control_op_t
+//   reply:   control_header_t ('status' set), then 'count' control_result_t
+// A client may pipeline any number of requests; replies come back in
+// order. A frame with a bad magic or more than CONTROL_MAX_OPS operations
+// closes the connection. Client sockets are non-blocking: a reply the
+// socket does not take is held in the client's output buffer, and that
+// client's later requests wait until it is sent, so a client that stops
+// reading stalls only its own connection.
+
+#define CONTROL_MAGIC 0x314c5443u     // "CTL1"
+#define CONTROL_MAX_OPS 4096          // Operations per batch
+#define CONTROL_MAX_CLIENTS 8
+#define CONTROL_SNAPSHOT_SLOTS 64     // Checkpoints held for clients
+
+// Operation codes
+typedef enum {
+    CONTROL_OP_NOP = 0,
+    CONTROL_OP_SET_INPUTS = 1,       // a = pin mask: drive HIGH (released); value = pins changed
+    CONTROL_OP_CLEAR_INPUTS = 2,     // a = pin mask: drive LOW (pressed); value = pins changed
+    CONTROL_OP_READ_LEVELS = 3,      // value = level of every configured pin
+    CONTROL_OP_LED_STATES = 4,       // value = pins of the LEDs that are on
+    CONTROL_OP_LED_BRIGHTNESS = 5,   // a = LED pin; value = brightness in percent
+    CONTROL_OP_READ_COUNTER = 6,     // a = control_counter_t; value = counter
+    CONTROL_OP_ADVANCE = 7,          // a = ns: advance the virtual clock; value = new time
+    CONTROL_OP_SNAPSHOT = 8,         // a = slot: checkpoint the board; value = bytes
+    CONTROL_OP_RESTORE = 9,          // a = slot: roll back to a checkpoint; value = its time
+    CONTROL_OP_COUNT
+} control_opcode_t;
+
+// Counters readable with CONTROL_OP_READ_COUNTER
+typedef enum {
+    CONTROL_COUNTER_TIME_NS = 0,       // Simulation clock
+    CONTROL_COUNTER_BATCHES = 1,       // Batches executed by the server
+    CONTROL_COUNTER_OPS = 2,           // Operations executed by the server
+    CONTROL_COUNTER_BUTTON_ACTIONS = 3,  // Debounced presses acted upon
+    CONTROL_COUNTER_EDGE_OVERFLOWS = 4,  // Raw button edges lost to a full queue
+    CONTROL_COUNTER_EVENT_OVERFLOWS = 5, // Debounced events lost to a full queue
+    CONTROL_COUNTER_LATENCY_SAMPLES = 6, // Press-to-LED latencies recorded
+    CONTROL_COUNTER_COALESCED_WRITES = 7, // LED pin writes dropped by write combining
+    CONTROL_COUNTER_COUNT
+} control_counter_t;
+
+// Per-operation and per-batch status
+typedef enum {
+    CONTROL_OK = 0,
+    CONTROL_ERR_OPCODE = 1,          // Unknown operation
+    CONTROL_ERR_ARG = 2,             // Invalid pin, mask or counter
+    CONTROL_ERR_STATE = 3            // Not possible now (e.g. advancing the wall clock)
+} control_status_t;
+
+// Frame header (16 bytes)
+typedef struct {
+    uint32_t magic;            // CONTROL_MAGIC
+    uint32_t seq;              // Chosen by the client, echoed in the reply
+    uint32_t count;            // Operations (results) that follow
+    uint32_t status;           // Reply: CONTROL_OK, or the first failing status
+} control_header_t;
+
+// One operation (24 bytes)
+typedef struct {
+    uint32_t opcode;           // control_opcode_t
+    uint32_t reserved;
+    uint64_t a;
+    uint64_t b;
+} control_op_t;
+
+// Result of one operation (16 bytes)
+typedef struct {
+    uint32_t status;           // control_status_t
+    uint32_t reserved;
+    uint64_t value;
+} control_result_t;
+
+// Executes one batch: fill 'results[i]' for every 'ops[i]'
+typedef void (*control_batch_fn_t)(void *arg, const control_op_t *ops, control_result_t *results, size_t count);
+
+typedef struct control_server control_server_t;
+
+// One client connection
+typedef struct {
+    control_server_t *server;
+    int fd;                    // -1 = free slot
+    uint8_t *buf;              // Partial request
+    size_t len;
+    uint8_t *out;              // Reply the socket has not taken yet
+    size_t out_len;            // Bytes in 'out', 0 = none pending
+    size_t out_done;           // Bytes of 'out' already sent
+} control_client_t;
+
+// Server state
+struct control_server {
+    const char *path;
+    int listen_fd;             // -1 when closed
+    control_batch_fn_t exec;
+    void *arg;
+    control_client_t clients[CONTROL_MAX_CLIENTS];
+    uint8_t *reply;            // Reply frame being built
+    uint64_t batches;
+    uint64_t ops;
+};
+
+// Server functions
+bool control_server_open(control_server_t *srv, const char *path, control_batch_fn_t exec, void *arg);
+void control_server_close(control_server_t *srv);
+
+#endif // CONTROL_SERVER_H
@@ -0,0 +1,40 @@
+#ifndef DEBOUNCE_VC_H
+#define DEBOUNCE_VC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bit-parallel debounce engine using vertical counters. Inputs are a
+// bit-vector (bit i = input i, 1 = active); every input has a small
+// counter stored bit-sliced across DEBOUNCE_VC_PLANES words, so one tick
+// debounces 64 inputs per word with a handful of logic operations and no
+// branches. An input flips once it has differed from its debounced state
+// for 'threshold' consecutive samples.
+
+#define DEBOUNCE_VC_MAX_INPUTS 512
+#define DEBOUNCE_VC_WORDS (DEBOUNCE_VC_MAX_INPUTS / 64)
+#define DEBOUNCE_VC_PLANES 4   // Counter bits: thresholds up to 15 samples
+
+typedef struct {
+    // Bit-sliced counters, plane-major so SIMD loads are contiguous
+    uint64_t count[DEBOUNCE_VC_PLANES][DEBOUNCE_VC_WORDS] __attribute__((aligned(32)));
+    uint64_t state[DEBOUNCE_VC_WORDS] __attribute__((aligned(32)));     // Debounced level
+    uint64_t pressed[DEBOUNCE_VC_WORDS] __attribute__((aligned(32)));   // 0 -> 1 edges of the last update
+    uint64_t released[DEBOUNCE_VC_WORDS] __attribute__((aligned(32)));  // 1 -> 0 edges of the last update
+    uint64_t threshold_mask[DEBOUNCE_VC_PLANES];  // All-ones where threshold has a 1 bit
+    size_t num_inputs;
+    size_t num_words;
+    uint32_t threshold;
+    bool use_avx2;
+} debounce_vc_t;
+
+// Function declarations
+bool debounce_vc_init(debounce_vc_t *vc, size_t num_inputs, uint32_t threshold);
+bool debounce_vc_resize(debounce_vc_t *vc, size_t num_inputs);
+void debounce_vc_set_avx2(debounce_vc_t *vc, bool enable);
+bool debounce_vc_update(debounce_vc_t *vc, const uint64_t *raw);
+bool debounce_vc_busy(const debounce_vc_t *vc);
+bool debounce_vc_avx2_available(void);
+
+#endif // DEBOUNCE_VC_H
@@ -0,0 +1,41 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include "timer_wheel.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Software timers in the style of the ESP-IDF esp_timer API, running on a
+// timer wheel. Callbacks run from timer_wheel_run() on the application
+// thread (ESP-IDF's ESP_TIMER_TASK dispatch). Functions return false where
+// ESP-IDF returns an error code: starting a running timer, stopping an idle
+// one and deleting a running one are invalid. Use from the application
+// thread.
+
+// Timer callback
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef struct esp_timer *esp_timer_handle_t;
+
+// Timer creation arguments (esp_timer_create())
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;            // For logs; must outlive the timer
+    bool skip_unhandled_events;  // Periodic: drop periods missed while late
+} esp_timer_create_args_t;
+
+// Timer functions
+bool esp_timer_create_on(timer_wheel_t *wheel, const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle);
+bool esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+bool esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us);
+bool esp_timer_restart(esp_timer_handle_t timer, uint64_t timeout_us);
+bool esp_timer_stop(esp_timer_handle_t timer);
+bool esp_timer_delete(esp_timer_handle_t timer);
+bool esp_timer_is_active(esp_timer_handle_t timer);
+
+// Default-instance API (timer_wheel_default())
+bool esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle);
+int64_t esp_timer_get_time(void);
+
+#endif // ESP_TIMER_H
@@ -0,0 +1,36 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Single-threaded reactor: sleeps until a registered fd is readable (or
+// writable, once asked for with event_loop_want_write()), the
+// one-shot timer (an absolute CLOCK_MONOTONIC deadline) expires, or another thread / signal handler calls
+// event_loop_wake(). Linux uses epoll + timerfd + eventfd, other POSIX
+// systems fall back to poll() with a self-pipe.
+
+#define EVENT_LOOP_MAX_FDS 16
+
+// Reasons event_loop_wait() returned
+#define EVENT_LOOP_FD     0x1  // A registered fd callback ran
+#define EVENT_LOOP_TIMER  0x2  // The armed timer expired
+#define EVENT_LOOP_WAKE   0x4  // event_loop_wake() was called
+#define EVENT_LOOP_EINTR  0x8  // Interrupted by a signal
+
+// Callback invoked when a registered fd becomes readable (or writable,
+// see event_loop_want_write())
+typedef void (*event_loop_fd_cb_t)(int fd, void *arg);
+
+// Function declarations
+bool event_loop_init(void);
+void event_loop_deinit(void);
+bool event_loop_add_fd(int fd, event_loop_fd_cb_t cb, void *arg);
+void event_loop_remove_fd(int fd);
+bool event_loop_want_write(int fd, event_loop_fd_cb_t write_cb);
+void event_loop_arm_deadline(uint64_t deadline_ns);
+void event_loop_disarm_timer(void);
+void event_loop_wake(void);
+int event_loop_wait(bool block);
+
+#endif // EVENT_LOOP_H
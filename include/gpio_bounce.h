@@ -0,0 +1,88 @@
+#ifndef GPIO_BOUNCE_H
+#define GPIO_BOUNCE_H
+
+#include "gpio_mock.h"
+#include "sim_clock.h"
+#include "timer_wheel.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Contact bounce model for simulated button inputs. A simulated press or
+// release of a modelled pin no longer flips the level cleanly: the pin
+// chatters between the two levels for a random number of bounces with
+// random intervals before it settles. Each transition draws its burst at
+// once as a short sorted edge list, from a per-pin seeded generator, so a
+// run is reproducible from its seed.
+//
+// The burst is evaluated lazily: pin reads compute the level at the
+// current time from the edge list through a GPIO level source, so no
+// register is rewritten on a fixed step. Edges are written to IN (and so
+// raise interrupts and reach watches) on the shared timer wheel, one
+// timer per edge while the pin is observed (gpio_dev_is_observed()) and a
+// single timer at the end of the burst otherwise. A noisy run costs time
+// proportional to the edges somebody sees, not to the simulated time.
+// Use from the application thread.
+
+#define GPIO_BOUNCE_MAX_BOUNCES 15    // Away-and-back pairs per transition
+#define GPIO_BOUNCE_MAX_EDGES (2 * GPIO_BOUNCE_MAX_BOUNCES + 1)
+#define GPIO_BOUNCE_MAX_US 100000     // Longest interval between two edges
+
+// Distribution of the intervals between two edges of a burst
+typedef enum {
+    GPIO_BOUNCE_UNIFORM = 0,   // Uniform in [min_us, max_us]
+    GPIO_BOUNCE_DECAYING = 1   // Uniform up to a bound that shrinks linearly over the burst
+} gpio_bounce_dist_t;
+
+// Bounce model of one pin
+typedef struct {
+    uint32_t min_bounces;      // Away-and-back pairs per transition
+    uint32_t max_bounces;
+    uint32_t min_us;           // Interval between two edges
+    uint32_t max_us;
+    gpio_bounce_dist_t dist;
+} gpio_bounce_config_t;
+
+typedef struct gpio_bounce gpio_bounce_t;
+
+// One modelled pin and its burst in flight
+typedef struct {
+    gpio_bounce_t *dev;
+    uint32_t pin;
+    bool enabled;
+    gpio_bounce_config_t config;
+    uint64_t rng;              // Generator state
+    uint32_t level;            // Level the burst settles at
+    uint32_t count;            // Edges of the burst, 0 = settled
+    uint32_t next;             // First edge not yet written to IN
+    uint64_t times[GPIO_BOUNCE_MAX_EDGES];  // Edge k goes to 'level' if k is even
+    timer_wheel_timer_t timer;
+} gpio_bounce_pin_t;
+
+// Bounce models of one board
+struct gpio_bounce {
+    gpio_device_t *gpio;
+    sim_clock_t *clock;
+    timer_wheel_t *wheel;
+    uint64_t seed;
+    gpio_bounce_pin_t pins[GPIO_NUM_MAX];
+    uint64_t transitions;      // Simulated transitions that bounced
+    uint64_t edges;            // Edges generated
+    uint64_t writes;           // Edges written to IN
+};
+
+// Device functions
+void gpio_bounce_dev_init(gpio_bounce_t *dev, gpio_device_t *gpio, sim_clock_t *clock, timer_wheel_t *wheel,
+                          uint64_t seed);
+void gpio_bounce_dev_deinit(gpio_bounce_t *dev);
+bool gpio_bounce_dev_set_pin(gpio_bounce_t *dev, uint32_t gpio_num, const gpio_bounce_config_t *config);
+bool gpio_bounce_dev_drive(gpio_bounce_t *dev, uint32_t gpio_num, uint32_t level);
+void gpio_bounce_dev_reset(gpio_bounce_t *dev);
+bool gpio_bounce_parse(const char *spec, gpio_bounce_config_t *config);
+
+// Default-instance API (default board, clock and timer wheel)
+gpio_bounce_t *gpio_bounce_default_device(void);
+void gpio_bounce_init_all(uint64_t seed);
+bool gpio_bounce_set_pin(uint32_t gpio_num, const gpio_bounce_config_t *config);
+void gpio_bounce_reset(void);
+
+#endif // GPIO_BOUNCE_H
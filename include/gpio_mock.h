@@ -4,13 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-// GPIO pin definitions (simulating ESP32 pins)
-#define GPIO_NUM_2   2   // LED 1
-#define GPIO_NUM_4   4   // LED 2
-#define GPIO_NUM_5   5   // LED 3
-#define GPIO_NUM_18  18  // Button 1
-#define GPIO_NUM_19  19  // Button 2
-#define GPIO_NUM_21  21  // Button 3
+// GPIO pins (simulating ESP32); the board wiring lives in board.h
+#define GPIO_NUM_MAX 40  // Number of GPIO pins
 
 // GPIO modes
 typedef enum {
@@ -30,14 +25,114 @@ typedef enum {
     GPIO_LEVEL_HIGH = 1
 } gpio_level_t;
 
+// GPIO interrupt triggers
+typedef enum {
+    GPIO_INTR_DISABLE = 0,  // No interrupt
+    GPIO_INTR_POSEDGE = 1,  // Rising edge
+    GPIO_INTR_NEGEDGE = 2,  // Falling edge
+    GPIO_INTR_ANYEDGE = 3   // Both edges
+} gpio_int_type_t;
+
+// Pin interrupt handler, called from the context that drove the edge
+typedef void (*gpio_isr_t)(void *arg);
+
+// Level-change observer: pins in 'changed' now read as in 'levels'
+typedef void (*gpio_watch_t)(void *arg, uint64_t changed, uint64_t levels);
+
+#define GPIO_MAX_WATCHES 4
+
+// Computes the level of a pin when it is read, for peripherals such as
+// PWM or input models such as contact bounce that would otherwise have to
+// rewrite a register on every edge
+typedef uint32_t (*gpio_level_source_t)(void *arg, uint32_t gpio_num);
+
+// Takes a simulated button transition of a pin to 'level' in place of a
+// clean edge, e.g. to add contact bounce. Returns false to leave the pin
+// to a clean edge.
+typedef bool (*gpio_input_model_t)(void *arg, uint32_t gpio_num, uint32_t level);
+
 // GPIO configuration structure
 typedef struct {
-    uint32_t pin_bit_mask;     // GPIO pin: set with bit mask
+    uint64_t pin_bit_mask;     // GPIO pin: set with bit mask
     gpio_mode_t mode;          // GPIO mode: set input/output mode
     gpio_pullup_t pull_up_en;  // GPIO pull-up
 } gpio_config_t;
 
-// Function declarations
+// Simulated GPIO register file of one board, one bit per pin like the
+// ESP32 GPIO_OUT / GPIO_IN / GPIO_ENABLE registers. Every word is accessed
+// atomically, so all gpio_dev_* calls except gpio_dev_init() may be made
+// from several threads at once.
+typedef struct {
+    uint64_t out;         // GPIO_OUT: output level register
+    uint64_t in;          // GPIO_IN: input level register
+    uint64_t enable;      // GPIO_ENABLE: set = output driver enabled
+    uint64_t pullup;      // Pull-up configuration
+    uint64_t configured;  // Track initialized pins
+    uint64_t intr_posedge;  // Pins interrupting on rising edges
+    uint64_t intr_negedge;  // Pins interrupting on falling edges
+    bool isr_service;       // gpio_dev_install_isr_service() was called
+    gpio_isr_t isr_handlers[GPIO_NUM_MAX];
+    void *isr_args[GPIO_NUM_MAX];
+    struct {
+        uint64_t mask;      // Pins reported to this watch
+        gpio_watch_t fn;    // NULL = free slot
+        void *arg;
+    } watches[GPIO_MAX_WATCHES];
+    uint32_t num_watches;   // Slots in use, including freed ones
+    uint64_t sourced;       // Pins read through a level source
+    struct {
+        gpio_level_source_t fn;
+        void *arg;
+    } sources[GPIO_NUM_MAX];
+    struct {
+        gpio_input_model_t fn;  // NULL = clean edges
+        void *arg;
+    } input_model;
+} gpio_device_t;
+
+// Register contents kept by snapshots. Interrupt handlers, watches and
+// level sources are wiring rather than state and are not part of it.
+typedef struct {
+    uint64_t out;
+    uint64_t in;
+    uint64_t enable;
+    uint64_t pullup;
+    uint64_t configured;
+    uint64_t intr_posedge;
+    uint64_t intr_negedge;
+    uint64_t isr_service;   // 1 if the ISR service is installed
+} gpio_regs_t;
+
+// Device functions: every call names the board it operates on
+void gpio_dev_init(gpio_device_t *dev);
+void gpio_dev_config_pin(gpio_device_t *dev, gpio_config_t *gpio_conf);
+void gpio_dev_set_level(gpio_device_t *dev, uint32_t gpio_num, uint32_t level);
+uint32_t gpio_dev_get_level(gpio_device_t *dev, uint32_t gpio_num);
+void gpio_dev_toggle_level(gpio_device_t *dev, uint32_t gpio_num);
+void gpio_dev_print_status(gpio_device_t *dev);
+void gpio_dev_set_mask(gpio_device_t *dev, uint64_t mask);
+void gpio_dev_clear_mask(gpio_device_t *dev, uint64_t mask);
+void gpio_dev_toggle_mask(gpio_device_t *dev, uint64_t mask);
+void gpio_dev_write_mask(gpio_device_t *dev, uint64_t mask, uint64_t levels);
+uint64_t gpio_dev_read_all(gpio_device_t *dev);
+void gpio_dev_install_isr_service(gpio_device_t *dev);
+bool gpio_dev_set_intr_type(gpio_device_t *dev, uint32_t gpio_num, gpio_int_type_t intr_type);
+bool gpio_dev_isr_handler_add(gpio_device_t *dev, uint32_t gpio_num, gpio_isr_t isr_handler, void *args);
+bool gpio_dev_isr_handler_remove(gpio_device_t *dev, uint32_t gpio_num);
+uint64_t gpio_dev_drive_inputs(gpio_device_t *dev, uint64_t mask, uint64_t levels);
+uint64_t gpio_dev_drive_outputs(gpio_device_t *dev, uint64_t mask, uint64_t levels);
+bool gpio_dev_add_watch(gpio_device_t *dev, uint64_t mask, gpio_watch_t fn, void *arg);
+void gpio_dev_remove_watch(gpio_device_t *dev, gpio_watch_t fn, void *arg);
+bool gpio_dev_set_level_source(gpio_device_t *dev, uint32_t gpio_num, gpio_level_source_t fn, void *arg);
+void gpio_dev_set_input_model(gpio_device_t *dev, gpio_input_model_t fn, void *arg);
+bool gpio_dev_is_observed(gpio_device_t *dev, uint32_t gpio_num);
+void gpio_dev_simulate_button_press(gpio_device_t *dev, uint32_t gpio_num);
+void gpio_dev_simulate_button_release(gpio_device_t *dev, uint32_t gpio_num);
+void gpio_dev_save_regs(gpio_device_t *dev, gpio_regs_t *regs);
+void gpio_dev_load_regs(gpio_device_t *dev, const gpio_regs_t *regs);
+
+// Default-instance API (operates on gpio_default_device())
+gpio_device_t *gpio_default_device(void);
 void gpio_mock_init(void);
 void gpio_config_pin(gpio_config_t *gpio_conf);
 void gpio_set_level(uint32_t gpio_num, uint32_t level);
@@ -45,8 +140,25 @@ uint32_t gpio_get_level(uint32_t gpio_num);
 void gpio_toggle_level(uint32_t gpio_num);
 void gpio_print_status(void);
 
+// Batch register access: one operation for every pin in the mask
+void gpio_set_mask(uint64_t mask);
+void gpio_clear_mask(uint64_t mask);
+void gpio_toggle_mask(uint64_t mask);
+void gpio_write_mask(uint64_t mask, uint64_t levels);
+uint64_t gpio_read_all(void);
+
+// Interrupts: handlers run when a simulated input driver changes a pin
+void gpio_install_isr_service(void);
+bool gpio_set_intr_type(uint32_t gpio_num, gpio_int_type_t intr_type);
+bool gpio_isr_handler_add(uint32_t gpio_num, gpio_isr_t isr_handler, void *args);
+bool gpio_isr_handler_remove(uint32_t gpio_num);
+
+// Simulation functions (for testing)
+void gpio_simulate_button_press(uint32_t gpio_num);
+void gpio_simulate_button_release(uint32_t gpio_num);
+
 // Helper macros
 #define GPIO_PIN_SEL(pin) (1ULL << (pin))
-#define GPIO_IS_VALID_GPIO(gpio_num) ((gpio_num) < 40)
+#define GPIO_IS_VALID_GPIO(gpio_num) ((gpio_num) < GPIO_NUM_MAX)
 
 #endif // GPIO_MOCK_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef GPIO_SHM_H
+#define GPIO_SHM_H
+
+#include "gpio_mock.h"
+#include "sim_clock.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// GPIO register file published in a POSIX shared-memory segment, so that
+// test harnesses, dashboards or another simulator process can read the
+// board and drive its inputs through plain loads and stores.
+//
+// The simulator mirrors its registers into the segment from a GPIO watch,
+// under a sequence counter:
+//   1. load 'seq' (acquire); if odd, an update is in progress: retry
+//   2. copy the state words
+//   3. load 'seq' again (after an acquire fence); if it changed, retry
+// Output pins read as 'out', input pins as 'in' ('enable' set = output).
+// Pins driven by the LEDC peripheral show their OUT register, which only
+// follows the PWM waveform while it is observed (--vcd).
+//
+// To drive inputs, an external process sets the pins' bits in
+// 'drive_mask', stores their levels in 'drive_levels', then increments
+// 'drive_seq'. If 'drive_waiters' is non-zero the simulator is asleep on
+// 'drive_seq' and must be woken with FUTEX_WAKE (a shared, not private,
+// futex); otherwise no system call is needed. Only configured input
+// pins are driven, with the same edges and interrupts as a button press.
+//
+// Every field is a naturally aligned little-endian word accessed
+// atomically; the layout only grows at the end, with 'version' bumped.
+
+#define GPIO_SHM_MAGIC 0x4f495047u    // "GPIO"
+#define GPIO_SHM_VERSION 1
+
+// Segment layout
+typedef struct {
+    // Fixed at creation
+    uint32_t magic;            // GPIO_SHM_MAGIC
+    uint32_t version;          // GPIO_SHM_VERSION
+    uint32_t size;             // sizeof(gpio_shm_layout_t)
+    uint32_t num_pins;         // GPIO_NUM_MAX
+
+    // Board state, written by the simulator under 'seq'
+    uint64_t seq;              // Odd while an update is in progress
+    uint64_t time_ns;          // sim_clock_now() of the last update
+    uint64_t updates;          // Updates published so far
+    uint64_t out;              // GPIO_OUT
+    uint64_t in;               // GPIO_IN
+    uint64_t enable;           // GPIO_ENABLE
+    uint64_t pullup;
+    uint64_t configured;
+
+    // Input requests, written by external processes
+    uint64_t drive_mask;       // Pins driven from outside
+    uint64_t drive_levels;     // Their requested levels
+    uint32_t drive_seq;        // Futex word, incremented after each request
+    uint32_t drive_waiters;    // Non-zero while the simulator sleeps on drive_seq
+    uint64_t drives;           // Requests applied by the simulator
+} gpio_shm_layout_t;
+
+// Consistent copy of the board state
+typedef struct {
+    uint64_t time_ns;
+    uint64_t updates;
+    uint64_t out;
+    uint64_t in;
+    uint64_t enable;
+    uint64_t pullup;
+    uint64_t configured;
+} gpio_shm_snapshot_t;
+
+// Called after an external request changed an input, e.g. event_loop_wake()
+typedef void (*gpio_shm_notify_t)(void);
+
+// Simulator side of one segment
+typedef struct {
+    gpio_device_t *gpio;
+    sim_clock_t *clock;
+    const char *name;
+    int fd;                    // -1 when closed
+    gpio_shm_layout_t *shm;
+    gpio_shm_notify_t notify;
+    pthread_mutex_t lock;      // Serializes publishers: edges come from any thread
+    pthread_t thread;          // Applies drive requests
+    bool started;
+    bool stop;                 // Set by gpio_shm_close() (atomic)
+} gpio_shm_t;
+
+// Simulator functions
+bool gpio_shm_create(gpio_shm_t *gs, const char *name, gpio_device_t *gpio, sim_clock_t *clock);
+bool gpio_shm_start(gpio_shm_t *gs, gpio_shm_notify_t notify);
+void gpio_shm_close(gpio_shm_t *gs);
+
+// Client functions, for external processes
+gpio_shm_layout_t *gpio_shm_attach(const char *name);
+void gpio_shm_detach(gpio_shm_layout_t *shm);
+void gpio_shm_read(const gpio_shm_layout_t *shm, gpio_shm_snapshot_t *snap);
+void gpio_shm_drive(gpio_shm_layout_t *shm, uint64_t mask, uint64_t levels);
+
+#endif // GPIO_SHM_H
@@ -0,0 +1,75 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "gpio_mock.h"
+#include "sim_clock.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// End-to-end latency measurement. A tracker watches input pins and the
+// output pins they drive; the time from an input's press edge to the next
+// change of its output goes into an HDR-style histogram.
+
+// Histogram layout: values below 2^LATENCY_HIST_SUB_BITS nanoseconds get
+// one bucket each, every higher power of two is split into 2^(SUB_BITS-1)
+// buckets, so any recorded value is within 1/64 (1.6%) of its bucket.
+// Values of 2^LATENCY_HIST_MAX_BITS ns (about 18 minutes) or more share
+// the top bucket; the exact maximum is kept separately.
+#define LATENCY_HIST_SUB_BITS 7
+#define LATENCY_HIST_MAX_BITS 40
+#define LATENCY_HIST_SUB_COUNT (1u << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_HALF_COUNT (LATENCY_HIST_SUB_COUNT / 2)
+#define LATENCY_HIST_BUCKETS \
+    (LATENCY_HIST_SUB_COUNT + (LATENCY_HIST_MAX_BITS - LATENCY_HIST_SUB_BITS) * LATENCY_HIST_HALF_COUNT)
+
+// Latency histogram in nanoseconds
+typedef struct {
+    uint64_t counts[LATENCY_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t sum_ns;
+} latency_hist_t;
+
+// One input pin and the output pin it is expected to change
+typedef struct {
+    uint32_t in_pin;
+    uint32_t out_pin;
+    const char *in_name;    // Labels for the report, e.g. "BTN1", "LED1"
+    const char *out_name;
+    uint64_t press_ns;      // Clock time of the pending press + 1, 0 = none (atomic)
+    latency_hist_t *hist;
+} latency_pair_t;
+
+// Press-to-output tracker for one board. Inputs are active low like the
+// pulled-up buttons: a falling edge starts a measurement, a rising edge
+// before the output changes abandons it (the press was debounced away).
+typedef struct {
+    gpio_device_t *gpio;
+    sim_clock_t *clock;
+    latency_pair_t pairs[GPIO_NUM_MAX];
+    size_t count;
+    int8_t in_index[GPIO_NUM_MAX];   // Pair of each input pin, -1 = none
+    int8_t out_index[GPIO_NUM_MAX];  // Pair of each output pin, -1 = none
+    uint64_t in_mask;
+    uint64_t out_mask;
+    bool watching;
+} latency_tracker_t;
+
+// Histogram functions
+void latency_hist_reset(latency_hist_t *hist);
+void latency_hist_record(latency_hist_t *hist, uint64_t value_ns);
+uint64_t latency_hist_percentile(const latency_hist_t *hist, double percentile);
+
+// Tracker functions
+void latency_tracker_init(latency_tracker_t *tracker, gpio_device_t *gpio, sim_clock_t *clock);
+void latency_tracker_deinit(latency_tracker_t *tracker);
+bool latency_tracker_add(latency_tracker_t *tracker, uint32_t in_pin, uint32_t out_pin,
+                         const char *in_name, const char *out_name);
+bool latency_tracker_start(latency_tracker_t *tracker);
+void latency_tracker_stop(latency_tracker_t *tracker);
+void latency_tracker_print(const latency_tracker_t *tracker);
+uint64_t latency_tracker_samples(const latency_tracker_t *tracker);
+
+#endif // LATENCY_H
@@ -2,13 +2,16 @@
 #define LED_CONTROL_H
 
 #include "gpio_mock.h"
+#include "board.h"
+#include "ledc.h"
+#include <stddef.h>
 
-// LED definitions
-#define LED1_PIN GPIO_NUM_2
-#define LED2_PIN GPIO_NUM_4
-#define LED3_PIN GPIO_NUM_5
+// LED pins (LEDn_PIN) and NUM_LEDS come from the board description
 
-#define NUM_LEDS 3
+// PWM used for LED brightness (LEDC timer, frequency and resolution)
+#define LED_PWM_TIMER 0
+#define LED_PWM_FREQ_HZ 5000
+#define LED_PWM_RESOLUTION 8
 
 // LED states
 typedef enum {
@@ -19,12 +22,58 @@ typedef enum {
 // LED structure
 typedef struct {
     uint32_t pin;
-    led_state_t state;
+    led_state_t state;       // ON whenever the brightness is above 0%
     const char* name;
+    uint8_t brightness;      // Percent last set; fades report the live value
+    int32_t pwm_channel;     // LEDC channel once dimmed, -1 = plain GPIO
 } led_t;
 
-// Function declarations
+// LED controller: registry of the LEDs of one board
+typedef struct {
+    gpio_device_t *gpio;              // Board the LEDs are wired to
+    led_t *leds;                      // Dense storage in registration order
+    size_t count;
+    size_t capacity;
+    int16_t pin_index[GPIO_NUM_MAX];  // Pin -> index into leds, -1 if none
+    uint64_t pin_mask;                // Pins of every registered LED
+    bool board;                       // leds[0 .. NUM_LEDS - 1] are the board LEDs, in order
+    uint64_t pwm_mask;                // Pins driven by an LEDC channel
+    ledc_device_t *ledc;              // PWM for brightness, NULL = on/off only
+    bool combine;                     // Write combining, see led_ctrl_set_write_combining()
+    uint64_t shadow;                  // Pending OUT levels of plain LEDs
+    uint64_t dirty;                   // Plain LED pins written since the last commit
+    uint64_t combined_writes;         // Pin writes taken into the shadow word
+    uint64_t committed_writes;        // Of those, pin changes that reached OUT
+    uint64_t commits;                 // Commits that wrote OUT
+} led_controller_t;
+
+// Controller functions
+void led_ctrl_init(led_controller_t *ctrl, gpio_device_t *gpio);
+void led_ctrl_deinit(led_controller_t *ctrl);
+int led_ctrl_register(led_controller_t *ctrl, uint32_t led_pin, const char *name);
+void led_ctrl_init_board(led_controller_t *ctrl, gpio_device_t *gpio);
+void led_ctrl_set_state(led_controller_t *ctrl, uint32_t led_pin, led_state_t state);
+void led_ctrl_toggle(led_controller_t *ctrl, uint32_t led_pin);
+void led_ctrl_turn_on(led_controller_t *ctrl, uint32_t led_pin);
+void led_ctrl_turn_off(led_controller_t *ctrl, uint32_t led_pin);
+led_state_t led_ctrl_get_state(const led_controller_t *ctrl, uint32_t led_pin);
+void led_ctrl_all_off(led_controller_t *ctrl);
+void led_ctrl_all_on(led_controller_t *ctrl);
+void led_ctrl_write_mask(led_controller_t *ctrl, uint64_t mask, uint64_t levels);
+void led_ctrl_display_status(const led_controller_t *ctrl);
+const char* led_ctrl_get_name(const led_controller_t *ctrl, uint32_t led_pin);
+bool led_ctrl_attach_ledc(led_controller_t *ctrl, ledc_device_t *ledc);
+void led_ctrl_set_brightness(led_controller_t *ctrl, uint32_t led_pin, uint32_t percent);
+void led_ctrl_fade_brightness(led_controller_t *ctrl, uint32_t led_pin, uint32_t percent, uint32_t fade_ms);
+uint32_t led_ctrl_get_brightness(const led_controller_t *ctrl, uint32_t led_pin);
+void led_ctrl_reload(led_controller_t *ctrl);
+void led_ctrl_set_write_combining(led_controller_t *ctrl, bool enable);
+uint64_t led_ctrl_commit(led_controller_t *ctrl);
+
+// Default-instance API (operates on led_default_controller())
+led_controller_t *led_default_controller(void);
 void led_init_all(void);
+int led_register(uint32_t led_pin, const char *name);
 void led_set_state(uint32_t led_pin, led_state_t state);
 void led_toggle(uint32_t led_pin);
 void led_turn_on(uint32_t led_pin);
@@ -32,7 +81,13 @@ void led_turn_off(uint32_t led_pin);
 led_state_t led_get_state(uint32_t led_pin);
 void led_all_off(void);
 void led_all_on(void);
+void led_write_mask(uint64_t mask, uint64_t levels);
 void led_display_status(void);
 const char* led_get_name(uint32_t led_pin);
+void led_set_brightness(uint32_t led_pin, uint32_t percent);
+void led_fade_brightness(uint32_t led_pin, uint32_t percent, uint32_t fade_ms);
+uint32_t led_get_brightness(uint32_t led_pin);
+void led_set_write_combining(bool enable);
+uint64_t led_commit(void);
 
 #endif // LED_CONTROL_H
\ No newline at end of file
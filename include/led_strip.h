@@ -0,0 +1,139 @@
+#ifndef LED_STRIP_H
+#define LED_STRIP_H
+
+#include "gpio_mock.h"
+#include "sim_clock.h"
+#include "timer_wheel.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Addressable RGB LED strip (WS2812 and compatibles) on one GPIO pin, in
+// the style of the ESP-IDF led_strip component on its RMT backend.
+//
+// The application draws into an RGB pixel buffer; led_strip_refresh()
+// sends it. Only the pixels written since the last refresh (the dirty
+// range) go through the encoder, which turns each byte into eight RMT
+// symbols through a 256-entry table into the symbol buffer the simulated
+// RMT transmits. That buffer is the front buffer: it keeps the frame on
+// the wire while the next one is drawn, and a refresh is refused until
+// the frame and its reset (latch) time are over, as on hardware.
+//
+// The pin waveform is a function of time over the symbol buffer: pin
+// reads evaluate it through a GPIO level source, so an unobserved strip
+// costs nothing between refreshes. While the pin is observed
+// (gpio_dev_is_observed()), every edge is written to OUT on the shared
+// timer wheel. The receiver (led_strip_rx_*) captures those edges with a
+// GPIO watch and led_strip_decode() turns symbols back into pixels,
+// checking every pulse against the datasheet tolerance, so a frame can
+// be verified from the pin alone. Edge times are exact on a virtual or
+// warp clock. Use from the application thread.
+
+#define LED_STRIP_MAX_PIXELS 65536
+#define LED_STRIP_BITS_PER_PIXEL 24
+#define LED_STRIP_TICK_NS 50            // RMT resolution: 20 MHz
+#define LED_STRIP_MAX_TICKS 0x7fff      // 15-bit symbol durations
+#define LED_STRIP_TOLERANCE_NS 150      // Pulse tolerance of the WS2812 datasheet
+
+// WS2812B timing: 0 = 400 ns high, 850 ns low; 1 = 800 ns high, 450 ns
+// low; latch after 50 us low
+#define LED_STRIP_TIMING_WS2812 {400, 850, 800, 450, 50000}
+
+// Byte order on the wire
+typedef enum {
+    LED_STRIP_ORDER_GRB = 0,            // WS2812
+    LED_STRIP_ORDER_RGB = 1
+} led_strip_order_t;
+
+// Pulse widths in ns. Both bits must take the same time (t0h + t0l ==
+// t1h + t1l), which lets a pin read find its bit by division.
+typedef struct {
+    uint32_t t0h_ns;
+    uint32_t t0l_ns;
+    uint32_t t1h_ns;
+    uint32_t t1l_ns;
+    uint32_t reset_ns;                  // Low time that latches the frame
+} led_strip_timing_t;
+
+// Strip configuration
+typedef struct {
+    uint32_t gpio_num;                  // Data pin, becomes an output
+    uint32_t length;                    // Pixels, 1 .. LED_STRIP_MAX_PIXELS
+    led_strip_order_t order;
+    led_strip_timing_t timing;
+} led_strip_config_t;
+
+// One RMT symbol: 'level0' for 'duration0' ticks, then 'level1' for
+// 'duration1' ticks, packed like rmt_symbol_word_t
+typedef struct {
+    unsigned int duration0 : 15;
+    unsigned int level0 : 1;
+    unsigned int duration1 : 15;
+    unsigned int level1 : 1;
+} led_strip_symbol_t;
+
+// One pixel
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} led_strip_pixel_t;
+
+// Strip state
+typedef struct {
+    gpio_device_t *gpio;
+    sim_clock_t *clock;
+    timer_wheel_t *wheel;
+    led_strip_config_t config;
+    led_strip_pixel_t *pixels;          // Drawing buffer
+    led_strip_symbol_t *symbols;        // Frame on the wire: 24 per pixel, then the reset
+    uint32_t dirty_first;               // Pixels written since the last refresh:
+    uint32_t dirty_end;                 // [first, end), empty if first >= end
+    led_strip_symbol_t byte_symbols[256][8];  // Encoder table
+    uint64_t bit_ns;
+    uint64_t tx_start_ns;               // Data of the current frame is sent in
+    uint64_t tx_end_ns;                 // [tx_start_ns, tx_end_ns)
+    uint64_t ready_ns;                  // End of its reset time
+    timer_wheel_timer_t edge_timer;     // Next edge while observed
+    uint64_t frames;                    // Frames sent
+    uint64_t busy;                      // Refreshes refused while a frame was sent
+    uint64_t encoded;                   // Pixels re-encoded
+    uint64_t edges;                     // Edges written while observed
+} led_strip_t;
+
+// Receiver: symbols captured from a pin's edges
+typedef struct {
+    gpio_device_t *gpio;
+    sim_clock_t *clock;
+    uint32_t gpio_num;
+    led_strip_symbol_t *symbols;
+    size_t count;                       // Symbols captured, the last one may be open
+    size_t capacity;
+    uint64_t rise_ns;                   // Last rising edge
+    uint64_t fall_ns;                   // Last falling edge
+    bool high;                          // Level after the last edge
+    bool overflow;                      // Edges dropped for lack of room
+} led_strip_rx_t;
+
+// Strip functions
+bool led_strip_init(led_strip_t *strip, gpio_device_t *gpio, sim_clock_t *clock, timer_wheel_t *wheel,
+                    const led_strip_config_t *config);
+void led_strip_deinit(led_strip_t *strip);
+bool led_strip_set_pixel(led_strip_t *strip, uint32_t index, uint8_t r, uint8_t g, uint8_t b);
+led_strip_pixel_t led_strip_get_pixel(const led_strip_t *strip, uint32_t index);
+void led_strip_fill(led_strip_t *strip, uint32_t first, uint32_t count, led_strip_pixel_t pixel);
+void led_strip_clear(led_strip_t *strip);
+bool led_strip_refresh(led_strip_t *strip);
+bool led_strip_is_busy(const led_strip_t *strip);
+size_t led_strip_symbol_count(const led_strip_t *strip);
+bool led_strip_decode(const led_strip_config_t *config, const led_strip_symbol_t *symbols, size_t count,
+                      led_strip_pixel_t *pixels, size_t *num_pixels);
+
+// Receiver functions
+bool led_strip_rx_start(led_strip_rx_t *rx, gpio_device_t *gpio, sim_clock_t *clock, uint32_t gpio_num,
+                        size_t capacity);
+void led_strip_rx_stop(led_strip_rx_t *rx);
+bool led_strip_rx_decode(led_strip_rx_t *rx, const led_strip_config_t *config, led_strip_pixel_t *pixels,
+                         size_t *num_pixels);
+
+#endif // LED_STRIP_H
@@ -0,0 +1,115 @@
+#ifndef LEDC_H
+#define LEDC_H
+
+#include "gpio_mock.h"
+#include "sim_clock.h"
+#include "timer_wheel.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Simulated LEDC (LED PWM controller) in the style of the ESP-IDF driver.
+// A channel's output is a function of time: the timer's period, the duty
+// and an optional linear fade. Pin reads evaluate that function through a
+// GPIO level source, so an unobserved channel costs nothing between API
+// calls. When the device is observed (waveform dumps), every channel
+// schedules its next edge on the shared timer wheel and writes it to the
+// OUT register, costing one timer per edge actually produced.
+//
+// Differences from ESP-IDF: there is a single speed mode, hpoint is always
+// 0, and channel numbers go up to LEDC_CHANNEL_MAX so that many channels
+// can be simulated. Use from the application thread.
+
+#define LEDC_TIMER_MAX 4
+#define LEDC_CHANNEL_MAX 1024
+#define LEDC_DUTY_RES_MAX 20          // Duty resolution in bits
+#define LEDC_FADE_MAX_MS 1000000      // Longest fade
+#define LEDC_GPIO_NONE (-1)           // Channel not routed to a pin
+
+// Timer configuration (ledc_timer_config())
+typedef struct {
+    uint32_t timer_num;        // 0 .. LEDC_TIMER_MAX - 1
+    uint32_t freq_hz;          // PWM frequency
+    uint32_t duty_resolution;  // Duty range is 0 .. 2^duty_resolution
+} ledc_timer_config_t;
+
+// Channel configuration (ledc_channel_config())
+typedef struct {
+    uint32_t channel;          // 0 .. LEDC_CHANNEL_MAX - 1
+    int gpio_num;              // Output pin, or LEDC_GPIO_NONE
+    uint32_t timer_sel;        // Timer providing period and resolution
+    uint32_t duty;             // Initial duty
+} ledc_channel_config_t;
+
+// One PWM timer; all its channels start their cycles together
+typedef struct {
+    uint32_t freq_hz;
+    uint32_t duty_resolution;
+    uint64_t period_ns;
+    uint64_t epoch_ns;         // Start of a cycle
+    bool configured;
+} ledc_timer_t;
+
+typedef struct ledc_device ledc_device_t;
+
+// One PWM channel
+typedef struct {
+    ledc_device_t *dev;
+    uint32_t index;
+    int gpio_num;
+    uint32_t timer_sel;
+    uint32_t duty;             // Duty in effect when not fading
+    uint32_t duty_pending;     // ledc_set_duty() value until ledc_update_duty()
+    uint32_t fade_from;        // Linear fade: duty goes from fade_from at
+    uint32_t fade_to;          // fade_start_ns to fade_to at fade_end_ns
+    uint64_t fade_start_ns;
+    uint64_t fade_end_ns;
+    uint32_t fade_target;      // ledc_set_fade_with_time() values until
+    uint32_t fade_time_ms;     // ledc_fade_start()
+    bool fade_set;
+    bool fading;
+    timer_wheel_timer_t edge_timer;  // Next edge while observed
+    timer_wheel_timer_t fade_timer;  // End of the running fade
+} ledc_channel_t;
+
+// LEDC peripheral of one board
+struct ledc_device {
+    gpio_device_t *gpio;
+    sim_clock_t *clock;
+    timer_wheel_t *wheel;
+    ledc_timer_t timers[LEDC_TIMER_MAX];
+    ledc_channel_t **channels;  // Indexed by channel number, NULL if unused
+    size_t capacity;
+    bool observed;              // Write every edge to OUT
+    uint64_t edges;             // Edges written while observed
+};
+
+// Device functions
+void ledc_dev_init(ledc_device_t *dev, gpio_device_t *gpio, sim_clock_t *clock, timer_wheel_t *wheel);
+void ledc_dev_deinit(ledc_device_t *dev);
+bool ledc_dev_timer_config(ledc_device_t *dev, const ledc_timer_config_t *cfg);
+bool ledc_dev_channel_config(ledc_device_t *dev, const ledc_channel_config_t *cfg);
+bool ledc_dev_set_freq(ledc_device_t *dev, uint32_t timer_num, uint32_t freq_hz);
+bool ledc_dev_set_duty(ledc_device_t *dev, uint32_t channel, uint32_t duty);
+bool ledc_dev_update_duty(ledc_device_t *dev, uint32_t channel);
+uint32_t ledc_dev_get_duty(const ledc_device_t *dev, uint32_t channel);
+uint32_t ledc_dev_get_duty_max(const ledc_device_t *dev, uint32_t channel);
+bool ledc_dev_set_fade_with_time(ledc_device_t *dev, uint32_t channel, uint32_t target_duty, uint32_t max_fade_time_ms);
+bool ledc_dev_fade_start(ledc_device_t *dev, uint32_t channel);
+bool ledc_dev_is_fading(const ledc_device_t *dev, uint32_t channel);
+void ledc_dev_set_observed(ledc_device_t *dev, bool observed);
+
+// Default-instance API (default board, clock and timer wheel)
+ledc_device_t *ledc_default_device(void);
+void ledc_init_all(void);
+bool ledc_timer_config(const ledc_timer_config_t *cfg);
+bool ledc_channel_config(const ledc_channel_config_t *cfg);
+bool ledc_set_freq(uint32_t timer_num, uint32_t freq_hz);
+bool ledc_set_duty(uint32_t channel, uint32_t duty);
+bool ledc_update_duty(uint32_t channel);
+uint32_t ledc_get_duty(uint32_t channel);
+bool ledc_set_fade_with_time(uint32_t channel, uint32_t target_duty, uint32_t max_fade_time_ms);
+bool ledc_fade_start(uint32_t channel);
+void ledc_set_observed(bool observed);
+
+#endif // LEDC_H
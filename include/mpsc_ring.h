@@ -0,0 +1,35 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bounded lock-free multi-producer / single-consumer ring of fixed-size
+// elements. Producers never block: a push into a full ring fails and the
+// caller decides whether to drop or retry.
+
+#define MPSC_RING_CACHE_LINE 64
+
+typedef struct {
+    // Producer claim position, shared by all producers
+    size_t tail;
+    char pad0[MPSC_RING_CACHE_LINE - sizeof(size_t)];
+    // Consumer position, only touched by the single consumer
+    size_t head;
+    char pad1[MPSC_RING_CACHE_LINE - sizeof(size_t)];
+    size_t mask;          // capacity - 1 (capacity is a power of two)
+    size_t elem_size;     // payload bytes per element
+    size_t slot_size;     // sequence word + payload, rounded to 8 bytes
+    unsigned char *slots; // slot storage
+} mpsc_ring_t;
+
+// Function declarations
+bool mpsc_ring_init(mpsc_ring_t *ring, size_t capacity, size_t elem_size);
+void mpsc_ring_free(mpsc_ring_t *ring);
+bool mpsc_ring_push(mpsc_ring_t *ring, const void *elem);
+bool mpsc_ring_pop(mpsc_ring_t *ring, void *elem);
+size_t mpsc_ring_pop_batch(mpsc_ring_t *ring, void *elems, size_t max);
+bool mpsc_ring_is_empty(const mpsc_ring_t *ring);
+
+#endif // MPSC_RING_H
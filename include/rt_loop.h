@@ -0,0 +1,52 @@
+#ifndef RT_LOOP_H
+#define RT_LOOP_H
+
+#include "latency.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Real-time tick mode for the application loop. Instead of sleeping until
+// the next event, the loop runs one tick every period, sleeping with
+// clock_nanosleep() to absolute CLOCK_MONOTONIC deadlines, so the time a
+// tick takes never shifts the ticks after it. The loop thread can run
+// under SCHED_FIFO, pinned to one CPU, with its memory locked.
+//
+// Every tick records its execution time (wake-up to the end of its work)
+// and its wake-up jitter (wake-up minus deadline) in histograms. A tick
+// that ends after the next deadline is an overrun; the periods it ran
+// over are skipped, so later ticks stay on the original phase.
+
+#define RT_LOOP_MIN_PERIOD_US 100
+#define RT_LOOP_MAX_PERIOD_US 1000000
+
+// Real-time mode settings
+typedef struct {
+    uint64_t period_ns;
+    int priority;              // SCHED_FIFO priority, 0 = keep the normal policy
+    int cpu;                   // CPU to pin the loop to, -1 = any
+    bool lock_memory;          // mlockall() current and future pages
+} rt_loop_config_t;
+
+// Real-time loop state and statistics
+typedef struct {
+    rt_loop_config_t config;
+    bool fifo;                 // Settings actually in effect
+    bool pinned;
+    bool locked;
+    uint64_t deadline_ns;      // Wake-up deadline of the current tick
+    uint64_t wake_ns;          // When the current tick woke
+    uint64_t ticks;
+    uint64_t overruns;         // Ticks that ended after the next deadline
+    uint64_t missed;           // Deadlines skipped by overruns
+    latency_hist_t exec;       // Tick execution time
+    latency_hist_t jitter;     // Wake-up lateness
+} rt_loop_t;
+
+// Real-time loop functions
+bool rt_loop_parse(const char *spec, rt_loop_config_t *config);
+void rt_loop_start(rt_loop_t *rt, const rt_loop_config_t *config);
+void rt_loop_stop(rt_loop_t *rt);
+bool rt_loop_wait(rt_loop_t *rt);
+void rt_loop_print(const rt_loop_t *rt);
+
+#endif // RT_LOOP_H
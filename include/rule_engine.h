@@ -0,0 +1,130 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include "gpio_mock.h"
+#include "led_control.h"
+#include "button_control.h"
+#include "timer_wheel.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Input-to-output rule engine: a table of "when this input does that, do
+// this to those outputs" rules, loaded at run time, that turns debounced
+// button events into output writes.
+//
+// Table format, one rule per line, '#' starts a comment:
+//   <trigger> <inputs> <action> <outputs>
+//   trigger: press | release | hold:<ms>
+//   action:  toggle | set | clear | pulse:<ms>
+//   pins:    comma-separated board names (BTN1, LED2), GPIO numbers or
+//            0x masks, e.g. "BTN1", "18,19", "LED1,LED3" or "0x34"
+// A rule on several inputs fires on each of them. Rules that fire
+// together apply in table order.
+//
+// Loading compiles the table: every rule acting on a bit of OUT is an
+// affine map out' = (out & keep) ^ flip, and maps compose into one, so
+// each (trigger, input pin) gets the composition of all of its rules.
+// An event then costs one table lookup and one composition however many
+// rules it fires, and all the output changes of a batch of events go out
+// in one register write (led_ctrl_write_mask()). Holds and pulses run on
+// the timer wheel. Use from the application thread.
+
+#define RULE_MAX_RULES 4096
+#define RULE_MAX_MS 3600000           // Longest hold or pulse
+#define RULE_LABEL_LEN 64
+
+// Triggers
+typedef enum {
+    RULE_TRIGGER_PRESS = 0,
+    RULE_TRIGGER_RELEASE = 1,
+    RULE_TRIGGER_HOLD = 2             // Held down for 'hold_ms'
+} rule_trigger_t;
+
+// Actions on the outputs
+typedef enum {
+    RULE_ACTION_TOGGLE = 0,
+    RULE_ACTION_SET = 1,
+    RULE_ACTION_CLEAR = 2,
+    RULE_ACTION_PULSE = 3             // Set, then clear after 'pulse_ms'
+} rule_action_t;
+
+// One rule as written in a table
+typedef struct {
+    rule_trigger_t trigger;
+    rule_action_t action;
+    uint64_t inputs;                  // Pins that fire the rule
+    uint64_t outputs;                 // Pins it acts on
+    uint32_t hold_ms;
+    uint32_t pulse_ms;
+    char label[RULE_LABEL_LEN];       // Logged when it fires, e.g. "BTN1 pressed - Toggling LED1"
+} rule_t;
+
+// Composed effect on OUT: out' = (out & keep) ^ flip
+typedef struct {
+    uint64_t keep;
+    uint64_t flip;
+} rule_effect_t;
+
+// Rules fired by one (trigger, pin), composed; 'first' and 'count' select
+// their indices in rule_table_t.order
+typedef struct {
+    rule_effect_t effect;
+    uint32_t first;
+    uint32_t count;
+    uint32_t pulses;                  // Pulse rules among them
+    uint32_t hold_ms;                 // Hold groups only
+} rule_slot_t;
+
+typedef struct rule_engine rule_engine_t;
+
+// Timer that ends one pulse rule
+typedef struct {
+    rule_engine_t *engine;
+    uint64_t outputs;
+    timer_wheel_timer_t timer;
+} rule_pulse_t;
+
+// Hold timer of one input pin: fires at each hold duration in turn
+typedef struct {
+    rule_engine_t *engine;
+    uint32_t pin;
+    uint32_t next;                    // Next hold group of the pin
+    uint64_t press_ns;
+    timer_wheel_timer_t timer;
+} rule_hold_timer_t;
+
+// Compiled table
+typedef struct {
+    rule_t *rules;
+    size_t count;
+    uint32_t *order;                  // Rule indices, grouped by slot
+    rule_slot_t edges[2][GPIO_NUM_MAX];   // [RULE_TRIGGER_PRESS / RELEASE][pin]
+    rule_slot_t *holds;               // Hold groups, by pin, then duration
+    uint32_t hold_first[GPIO_NUM_MAX];
+    uint32_t hold_count[GPIO_NUM_MAX];
+    rule_pulse_t *pulses;             // One per rule, used by pulse rules
+} rule_table_t;
+
+// Engine state
+struct rule_engine {
+    led_controller_t *leds;           // Outputs are written through it
+    timer_wheel_t *wheel;
+    rule_table_t table;
+    rule_hold_timer_t hold_timers[GPIO_NUM_MAX];
+    uint64_t fired;                   // Rules fired
+    uint64_t writes;                  // Register writes issued
+};
+
+// Engine functions
+void rule_engine_init(rule_engine_t *engine, led_controller_t *leds, timer_wheel_t *wheel);
+void rule_engine_deinit(rule_engine_t *engine);
+void rule_engine_reset(rule_engine_t *engine);
+bool rule_engine_parse(const char *line, rule_t *rule);
+bool rule_engine_set_rules(rule_engine_t *engine, const rule_t *rules, size_t count);
+bool rule_engine_load_file(rule_engine_t *engine, const char *path);
+bool rule_engine_load_board(rule_engine_t *engine);
+void rule_engine_process(rule_engine_t *engine, const button_event_t *events, size_t count);
+void rule_engine_print(const rule_engine_t *engine);
+
+#endif // RULE_ENGINE_H
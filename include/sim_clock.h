@@ -0,0 +1,50 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Simulation time source. All timestamps are 64-bit nanoseconds, which
+// do not wrap for several centuries of simulated time.
+
+#define SIM_CLOCK_NS_PER_US 1000ULL
+#define SIM_CLOCK_NS_PER_MS 1000000ULL
+#define SIM_CLOCK_NS_PER_SEC 1000000000ULL
+
+// Clock backends
+typedef enum {
+    SIM_CLOCK_REALTIME = 0,  // CLOCK_MONOTONIC wall time
+    SIM_CLOCK_VIRTUAL,       // Advances only through sim_clock_advance_ns()
+    SIM_CLOCK_WARP           // Virtual, and jumps straight to the next deadline when idle
+} sim_clock_mode_t;
+
+// One time source; each simulated board may own its own
+typedef struct {
+    sim_clock_mode_t mode;
+    uint64_t virtual_now_ns;  // Current time in VIRTUAL and WARP modes
+} sim_clock_t;
+
+// Instance functions
+void sim_clock_configure(sim_clock_t *clk, sim_clock_mode_t mode);
+uint64_t sim_clock_now(const sim_clock_t *clk);
+void sim_clock_advance(sim_clock_t *clk, uint64_t delta_ns);
+void sim_clock_set(sim_clock_t *clk, uint64_t time_ns);
+void sim_clock_rewind(sim_clock_t *clk, uint64_t time_ns);
+bool sim_clock_warp(sim_clock_t *clk, uint64_t deadline_ns);
+
+// Default-instance API (operates on sim_clock_default())
+sim_clock_t *sim_clock_default(void);
+void sim_clock_init(sim_clock_mode_t mode);
+sim_clock_mode_t sim_clock_get_mode(void);
+bool sim_clock_is_virtual(void);
+uint64_t sim_clock_now_ns(void);
+void sim_clock_advance_ns(uint64_t delta_ns);
+void sim_clock_set_ns(uint64_t time_ns);
+bool sim_clock_warp_to(uint64_t deadline_ns);
+
+// Helpers
+uint64_t sim_clock_monotonic_ns(void);
+const char* sim_clock_mode_name(sim_clock_mode_t mode);
+int sim_clock_parse_mode(const char *name);
+
+#endif // SIM_CLOCK_H
@@ -0,0 +1,184 @@
+#ifndef SIM_LOG_H
+#define SIM_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Log levels
+#define SIM_LOG_OFF   0
+#define SIM_LOG_ERROR 1
+#define SIM_LOG_INFO  2
+#define SIM_LOG_DEBUG 3
+
+// Compile-time level ceiling; calls above it are compiled out entirely.
+// Each module may lower its own ceiling, e.g. -DSIM_LOG_LEVEL_GPIO=SIM_LOG_ERROR
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL SIM_LOG_INFO
+#endif
+#ifndef SIM_LOG_LEVEL_GPIO
+#define SIM_LOG_LEVEL_GPIO SIM_LOG_LEVEL
+#endif
+#ifndef SIM_LOG_LEVEL_LED
+#define SIM_LOG_LEVEL_LED SIM_LOG_LEVEL
+#endif
+#ifndef SIM_LOG_LEVEL_BUTTON
+#define SIM_LOG_LEVEL_BUTTON SIM_LOG_LEVEL
+#endif
+#ifndef SIM_LOG_LEVEL_MAIN
+#define SIM_LOG_LEVEL_MAIN SIM_LOG_LEVEL
+#endif
+#ifndef SIM_LOG_LEVEL_SIMULATION
+#define SIM_LOG_LEVEL_SIMULATION SIM_LOG_LEVEL
+#endif
+
+// Log modules (the "[TAG]" prefix of each line)
+typedef enum {
+    SIM_LOG_MODULE_GPIO = 0,
+    SIM_LOG_MODULE_LED,
+    SIM_LOG_MODULE_BUTTON,
+    SIM_LOG_MODULE_MAIN,
+    SIM_LOG_MODULE_SIMULATION,
+    SIM_LOG_MODULE_COUNT
+} sim_log_module_t;
+
+// Event identifiers; the text for each is produced at flush time
+typedef enum {
+    // GPIO
+    SIM_EVT_GPIO_INIT = 0,
+    SIM_EVT_GPIO_CONFIG,              // pin, value = gpio_mode_t
+    SIM_EVT_GPIO_SET_LEVEL,           // pin, value = level
+    SIM_EVT_GPIO_TOGGLE,              // pin, value = new level
+    SIM_EVT_GPIO_SET_MASK,            // value = mask
+    SIM_EVT_GPIO_CLEAR_MASK,          // value = mask
+    SIM_EVT_GPIO_TOGGLE_MASK,         // value = mask
+    SIM_EVT_GPIO_WRITE_MASK,          // value = mask
+    SIM_EVT_GPIO_ERR_NULL_CONFIG,
+    SIM_EVT_GPIO_ERR_INVALID_MASK,    // value = offending bits
+    SIM_EVT_GPIO_ERR_INVALID_PIN,     // pin
+    SIM_EVT_GPIO_ERR_NOT_INIT,        // pin
+    SIM_EVT_GPIO_ERR_NOT_OUTPUT,      // pin
+    SIM_EVT_GPIO_ERR_MASK_NOT_OUTPUT, // name = operation, value = offending bits
+    SIM_EVT_GPIO_INTR_TYPE,           // pin, value = gpio_int_type_t
+    SIM_EVT_GPIO_ERR_NO_ISR_SERVICE,  // pin
+    SIM_EVT_GPIO_ERR_LEDC,            // name = operation, pin = channel or timer
+    SIM_EVT_GPIO_LEDC_FADE_DONE,      // pin = channel, value = duty
+    SIM_EVT_GPIO_BOUNCE,              // pin, value = edges in the burst
+    SIM_EVT_GPIO_ERR_BOUNCE,          // pin, name = reason
+    SIM_EVT_GPIO_STRIP_REFRESH,       // pin, value = pixels encoded
+    SIM_EVT_GPIO_ERR_STRIP,           // pin, name = reason, value = offending length or index
+    // SIMULATION
+    SIM_EVT_SIM_PRESS,                // pin
+    SIM_EVT_SIM_RELEASE,              // pin
+    SIM_EVT_SIM_TRACE_OPEN,           // name = path, pin = 1 if binary, value = records
+    SIM_EVT_SIM_TRACE_ERR_OPEN,       // name = path
+    SIM_EVT_SIM_TRACE_ERR_FORMAT,     // name = path, pin = line (0 = binary header)
+    SIM_EVT_SIM_TRACE_ERR_WRITE,      // name = path
+    SIM_EVT_SIM_TRACE_ERR_WATCH,      // name = path
+    SIM_EVT_SIM_REPLAY_DONE,          // value = events replayed
+    SIM_EVT_SIM_VCD_OPEN,             // name = path, value = pins
+    SIM_EVT_SIM_VCD_ERR_WRITE,        // name = path
+    SIM_EVT_SIM_VCD_DONE,             // name = path, value = value changes
+    SIM_EVT_SIM_TIMER_ERR_STATE,      // name = timer, pin = 1 if it is running
+    SIM_EVT_SIM_SHM_OPEN,             // name = segment, value = bytes
+    SIM_EVT_SIM_SHM_ERR,              // name = segment, value = errno
+    SIM_EVT_SIM_SHM_DONE,             // name = segment, value = updates published
+    SIM_EVT_SIM_CONTROL_OPEN,         // name = socket path
+    SIM_EVT_SIM_CONTROL_ERR,          // name = socket path, value = errno
+    SIM_EVT_SIM_CONTROL_ERR_FRAME,    // pin = client, value = magic received
+    SIM_EVT_SIM_CONTROL_CONNECT,      // pin = client
+    SIM_EVT_SIM_CONTROL_DISCONNECT,   // pin = client
+    SIM_EVT_SIM_CONTROL_DONE,         // name = socket path, value = batches executed
+    SIM_EVT_SIM_SNAPSHOT_SAVE,        // value = bytes
+    SIM_EVT_SIM_SNAPSHOT_RESTORE,     // value = restored time in ns
+    SIM_EVT_SIM_SNAPSHOT_ERR,         // name = reason, pin = pin concerned
+    SIM_EVT_SIM_SNAPSHOT_ERR_FILE,    // name = path, value = errno
+    SIM_EVT_SIM_RT_START,             // pin = SCHED_FIFO priority, value = period in ns
+    SIM_EVT_SIM_RT_ERR,               // name = setting, pin = its value, value = errno
+    // LED
+    SIM_EVT_LED_INIT_BEGIN,
+    SIM_EVT_LED_INIT_DONE,
+    SIM_EVT_LED_STATE,                // name, value = led_state_t
+    SIM_EVT_LED_ALL,                  // value = led_state_t
+    SIM_EVT_LED_ERR_INVALID_PIN,      // pin
+    SIM_EVT_LED_ERR_INVALID_TOGGLE,   // pin
+    SIM_EVT_LED_ERR_INVALID_QUERY,    // pin
+    SIM_EVT_LED_ERR_REGISTER,         // pin
+    SIM_EVT_LED_BRIGHTNESS,           // name, value = percent
+    SIM_EVT_LED_FADE,                 // name, pin = milliseconds, value = target percent
+    SIM_EVT_LED_ERR_NO_PWM,           // pin
+    // BUTTON
+    SIM_EVT_BUTTON_INIT_BEGIN,
+    SIM_EVT_BUTTON_INIT_DONE,
+    SIM_EVT_BUTTON_TRANSITION,        // name, value = button_state_t
+    SIM_EVT_BUTTON_ERR_INVALID_PIN,   // pin
+    SIM_EVT_BUTTON_ERR_REGISTER,      // pin
+    SIM_EVT_BUTTON_ERR_QUEUE,
+    SIM_EVT_BUTTON_EDGE_OVERFLOW,     // value = resynced pin mask
+    // MAIN
+    SIM_EVT_MAIN_STARTING,
+    SIM_EVT_MAIN_INIT_DONE,
+    SIM_EVT_MAIN_LOOP_ENTER,
+    SIM_EVT_MAIN_SIGNAL,              // value = signal number
+    SIM_EVT_MAIN_RULE,                // pin = input pin, name = rule label
+    SIM_EVT_MAIN_RULES_LOADED,        // name = table, value = rules
+    SIM_EVT_MAIN_RULES_ERR,           // name = table, pin = line (0 = whole table)
+    SIM_EVT_MAIN_UNKNOWN_COMMAND,
+    SIM_EVT_MAIN_SHUTDOWN_BEGIN,
+    SIM_EVT_MAIN_SHUTDOWN_DONE,
+    SIM_EVT_MAIN_STIMULUS_START,      // pin = threads, value = edges/s per thread
+    SIM_EVT_MAIN_STIMULUS_DONE,       // value = edges driven
+    SIM_EVT_COUNT
+} sim_log_event_t;
+
+// Binary log record pushed by the hot path (32 bytes)
+typedef struct {
+    uint64_t timestamp_ns;  // sim_clock_now_ns() time of the event
+    uint64_t value;         // Event-specific value (level, state, mask...)
+    const char *name;       // Optional static string (device name, operation)
+    uint32_t pin;           // GPIO pin or other small integer argument
+    uint16_t event;         // sim_log_event_t
+    uint8_t module;         // sim_log_module_t
+    uint8_t level;          // SIM_LOG_ERROR..SIM_LOG_DEBUG
+} sim_log_record_t;
+
+// Runtime level per module, consulted before a record is queued
+extern uint8_t sim_log_levels[SIM_LOG_MODULE_COUNT];
+
+// Function declarations
+void sim_log_init(void);
+void sim_log_shutdown(void);
+void sim_log_set_level(sim_log_module_t module, int level);
+void sim_log_set_level_all(int level);
+int sim_log_get_level(sim_log_module_t module);
+int sim_log_parse_level(const char *name);
+void sim_log_set_timestamps(bool enable);
+void sim_log_write(sim_log_module_t module, int level, sim_log_event_t event,
+                   uint32_t pin, uint64_t value, const char *name);
+size_t sim_log_flush(void);
+uint64_t sim_log_dropped(void);
+
+// Check the runtime level for a module
+static inline bool sim_log_enabled(sim_log_module_t module, int level) {
+    return level <= __atomic_load_n(&sim_log_levels[module], __ATOMIC_RELAXED);
+}
+
+// Logging macros: SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, pin, 0, NULL)
+#if SIM_LOG_LEVEL == SIM_LOG_OFF
+#define SIM_LOG_AT(lvl, mod, evt, pin, value, name) \
+    do { (void)sizeof(pin); (void)sizeof(value); (void)sizeof(name); } while (0)
+#else
+#define SIM_LOG_AT(lvl, mod, evt, pin, value, name)                               \
+    do {                                                                          \
+        if ((lvl) <= SIM_LOG_LEVEL_##mod &&                                       \
+            sim_log_enabled(SIM_LOG_MODULE_##mod, (lvl))) {                       \
+            sim_log_write(SIM_LOG_MODULE_##mod, (lvl), (evt), (pin), (value), (name)); \
+        }                                                                         \
+    } while (0)
+#endif
+
+#define SIM_LOGE(mod, evt, pin, value, name) SIM_LOG_AT(SIM_LOG_ERROR, mod, evt, pin, value, name)
+#define SIM_LOGI(mod, evt, pin, value, name) SIM_LOG_AT(SIM_LOG_INFO, mod, evt, pin, value, name)
+#define SIM_LOGD(mod, evt, pin, value, name) SIM_LOG_AT(SIM_LOG_DEBUG, mod, evt, pin, value, name)
+
+#endif // SIM_LOG_H
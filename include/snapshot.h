@@ -0,0 +1,87 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "gpio_mock.h"
+#include "led_control.h"
+#include "button_control.h"
+#include "sim_clock.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Simulator checkpoints: the state of one board (GPIO registers, LEDs,
+// buttons with their debounce state, and the clock) in a compact blob, so
+// that many test branches can fork from a shared setup prefix instead of
+// replaying it. Saving and restoring copy a few hundred bytes and touch
+// no files.
+//
+// Blob format (native byte order): a snapshot_header_t, then 'num_leds'
+// snapshot_led_t, 'num_buttons' snapshot_button_t, and for the vertical
+// counter engine DEBOUNCE_VC_PLANES + 1 arrays of 'vc_words' counter and
+// debounced-state words.
+//
+// A snapshot restores into a board wired the same way: the same LED and
+// button pins in the same order and the same debounce engine. Both sides
+// need a virtual clock, and the board must be between two updates, with
+// no edges or events queued. LEDC fades and software timers are not part
+// of the state; a dimmed LED comes back at its brightness when saved.
+
+#define SNAPSHOT_MAGIC "ESPSNAPS"
+#define SNAPSHOT_VERSION 1
+
+// Blob header
+typedef struct {
+    char magic[8];            // SNAPSHOT_MAGIC, not NUL-terminated
+    uint32_t version;         // SNAPSHOT_VERSION
+    uint32_t size;            // Whole blob in bytes
+    uint64_t time_ns;         // Clock
+    gpio_regs_t gpio;
+    uint32_t num_leds;
+    uint32_t num_buttons;
+    uint32_t engine;          // button_debounce_engine_t
+    uint32_t vc_words;        // Vertical counter words per array, 0 = none
+    uint64_t event_buttons;   // Buttons flagged by the last update
+    uint64_t next_sample_time;
+} snapshot_header_t;
+
+// One LED (8 bytes)
+typedef struct {
+    uint32_t pin;
+    uint8_t state;            // led_state_t
+    uint8_t brightness;       // Percent
+    uint16_t reserved;
+} snapshot_led_t;
+
+// One button (16 bytes)
+typedef struct {
+    uint64_t last_debounce_time;
+    uint32_t pin;
+    uint8_t current_state;    // button_state_t
+    uint8_t last_state;
+    uint8_t state_changed;
+    uint8_t reserved;
+} snapshot_button_t;
+
+// The parts of one board a snapshot covers
+typedef struct {
+    gpio_device_t *gpio;
+    led_controller_t *leds;
+    button_controller_t *buttons;
+    sim_clock_t *clock;
+} snapshot_board_t;
+
+// Board functions
+size_t snapshot_size(const snapshot_board_t *board);
+size_t snapshot_save(const snapshot_board_t *board, void *buf, size_t capacity);
+bool snapshot_restore(const snapshot_board_t *board, const void *buf, size_t len);
+
+// Default-instance API (default board, controllers and clock)
+void snapshot_default_board(snapshot_board_t *board);
+size_t snapshot_take(void *buf, size_t capacity);
+bool snapshot_load(const void *buf, size_t len);
+
+// Files
+bool snapshot_write_file(const char *path, const void *buf, size_t len);
+void *snapshot_read_file(const char *path, size_t *len);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,43 @@
+#ifndef STIMULUS_H
+#define STIMULUS_H
+
+#include "gpio_mock.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Threaded input generators. Each generator runs on its own thread and
+// drives random press/release edges onto a set of input pins through
+// the atomic register API, so several sources can drive one board while
+// the application thread keeps consuming it.
+
+#define STIMULUS_MAX_THREADS 16
+
+// Called after every edge, e.g. event_loop_wake()
+typedef void (*stimulus_notify_t)(void);
+
+// Generator configuration
+typedef struct {
+    gpio_device_t *gpio;       // Board to drive
+    uint64_t pins;             // Input pins to toggle
+    uint32_t rate_hz;          // Edges per second, 0 = as fast as possible
+    uint64_t max_edges;        // Stop after this many edges, 0 = until stopped
+    uint32_t seed;             // Pseudo-random sequence seed (non-zero)
+    stimulus_notify_t notify;  // Optional edge notification
+} stimulus_config_t;
+
+// One generator thread
+typedef struct {
+    stimulus_config_t cfg;
+    pthread_t thread;
+    bool started;
+    bool stop;        // Set by stimulus_stop() (atomic)
+    uint64_t edges;   // Edges driven so far (atomic)
+} stimulus_t;
+
+// Function declarations
+bool stimulus_start(stimulus_t *st, const stimulus_config_t *cfg);
+void stimulus_stop(stimulus_t *st);
+uint64_t stimulus_edges(const stimulus_t *st);
+
+#endif // STIMULUS_H
@@ -0,0 +1,63 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "sim_clock.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Hierarchical timer wheel. Level 0 has one slot per TIMER_WHEEL_TICK_NS;
+// every level above has slots TIMER_WHEEL_LEVEL_SLOTS times as wide, so
+// TIMER_WHEEL_LEVELS levels cover the whole 64-bit tick range. A timer sits
+// on the lowest level whose slot tells it apart from the current tick and
+// cascades one level down when the wheel reaches its slot. Timers live in
+// intrusive lists and an occupancy bitmap per level lets the wheel skip
+// empty slots, so arming and cancelling are O(1) and running the wheel
+// costs time proportional to the timers that expire (plus at most one
+// cascade per level for each), not to the armed timers or to the
+// simulated time that passed. Not thread-safe: use from the application
+// thread.
+
+#define TIMER_WHEEL_TICK_NS SIM_CLOCK_NS_PER_US         // Level 0 slot width
+#define TIMER_WHEEL_LEVEL_BITS 6
+#define TIMER_WHEEL_LEVEL_SLOTS (1 << TIMER_WHEEL_LEVEL_BITS)  // One bitmap word
+#define TIMER_WHEEL_LEVELS 11                           // 11 * 6 bits >= 64
+
+// Timer callback; 'deadline_ns' is the exact time the timer was armed for
+typedef void (*timer_wheel_cb_t)(void *arg, uint64_t deadline_ns);
+
+// One timer, embedded in its owner
+typedef struct timer_wheel_timer {
+    struct timer_wheel_timer *next;
+    struct timer_wheel_timer *prev;
+    uint64_t deadline_ns;
+    uint64_t expires_tick;    // Tick the timer fires on, never in the past
+    timer_wheel_cb_t cb;
+    void *arg;
+    uint8_t level;            // Wheel level, TIMER_WHEEL_LEVELS once expired
+    bool armed;
+} timer_wheel_timer_t;
+
+// Timer wheel driven by one clock
+typedef struct {
+    sim_clock_t *clock;
+    uint64_t current_tick;                        // Every earlier tick has fired
+    timer_wheel_timer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SLOTS];
+    uint64_t occupied[TIMER_WHEEL_LEVELS];        // Bit set = slot list not empty
+    timer_wheel_timer_t *expired;                 // Due timers being fired, by deadline
+    size_t count;                                 // Armed timers
+} timer_wheel_t;
+
+// Wheel functions
+void timer_wheel_init(timer_wheel_t *wheel, sim_clock_t *clock);
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_cb_t cb, void *arg);
+void timer_wheel_arm(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint64_t deadline_ns);
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer);
+void timer_wheel_rebase(timer_wheel_t *wheel, uint64_t from_ns);
+bool timer_wheel_next_deadline(const timer_wheel_t *wheel, uint64_t *deadline_ns);
+size_t timer_wheel_run(timer_wheel_t *wheel);
+
+// Wheel shared by the default-instance peripherals (on sim_clock_default())
+timer_wheel_t *timer_wheel_default(void);
+
+#endif // TIMER_WHEEL_H
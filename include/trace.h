@@ -0,0 +1,69 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Stimulus traces: timestamped button press/release events.
+//
+// Binary format (native byte order): a trace_header_t followed by 'count'
+// trace_record_t. The file is memory-mapped and records are read in place.
+// Text format: one "<time_ms> <pin> press|release" event per line, where
+// time_ms may carry up to six decimals; blank lines and '#' comments are
+// skipped. Text is also parsed straight from the mapping.
+
+#define TRACE_MAGIC "ESPTRACE"
+#define TRACE_VERSION 1
+
+// Binary file header
+typedef struct {
+    char magic[8];         // TRACE_MAGIC, not NUL-terminated
+    uint32_t version;      // TRACE_VERSION
+    uint32_t record_size;  // sizeof(trace_record_t)
+    uint64_t count;        // Number of records that follow
+} trace_header_t;
+
+// One event; times are offsets from the start of the trace
+typedef struct {
+    uint64_t time_ns;
+    uint32_t pin;
+    uint32_t press;        // 1 = press, 0 = release
+} trace_record_t;
+
+// Streaming reader over a mapped trace
+typedef struct {
+    const char *path;
+    const char *map;                // Whole file, NULL if empty
+    size_t size;
+    bool binary;
+    const trace_record_t *records;  // Binary: records in the mapping
+    size_t count;                   // Binary: number of records
+    const char *pos;                // Text: parse cursor
+    size_t line;                    // Text: line of the cursor
+    trace_record_t parsed;          // Text: current event
+    bool has_parsed;
+    size_t index;                   // Events consumed so far
+    bool failed;                    // Malformed input; reading stopped
+} trace_reader_t;
+
+// Buffered binary writer
+typedef struct {
+    const char *path;
+    FILE *file;
+    uint64_t count;
+} trace_writer_t;
+
+// Reader functions
+bool trace_open(trace_reader_t *tr, const char *path);
+void trace_close(trace_reader_t *tr);
+const trace_record_t *trace_peek(trace_reader_t *tr);
+void trace_next(trace_reader_t *tr);
+
+// Writer functions
+bool trace_writer_open(trace_writer_t *tw, const char *path);
+bool trace_writer_append(trace_writer_t *tw, uint64_t time_ns, uint32_t pin, bool press);
+bool trace_writer_close(trace_writer_t *tw);
+
+#endif // TRACE_H
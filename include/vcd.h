@@ -0,0 +1,41 @@
+#ifndef VCD_H
+#define VCD_H
+
+#include "gpio_mock.h"
+#include "sim_clock.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Value Change Dump export of GPIO levels, readable by GTKWave and other
+// waveform viewers. The writer observes a board through a GPIO watch and
+// appends each level change to a large in-memory buffer that is written
+// out in VCD_BUFFER_SIZE chunks, so the hot path only formats a few bytes.
+
+#define VCD_BUFFER_SIZE (1u << 20)  // Output buffer, flushed when nearly full
+
+// Waveform writer for one board
+typedef struct {
+    gpio_device_t *gpio;
+    sim_clock_t *clock;
+    const char *path;
+    int fd;                           // -1 when closed
+    char *buf;
+    size_t len;                       // Bytes pending in buf
+    uint64_t pins;                    // Pins declared in the dump
+    const char *labels[GPIO_NUM_MAX]; // Optional signal names
+    uint64_t base_ns;                 // Clock time of dump time 0
+    uint64_t last_ns;                 // Last timestamp written
+    uint64_t changes;                 // Value changes written
+    bool started;
+    bool failed;                      // A write failed; output stops
+    pthread_mutex_t lock;             // Input edges may come from other threads
+} vcd_writer_t;
+
+// Function declarations
+bool vcd_writer_open(vcd_writer_t *vw, const char *path, gpio_device_t *gpio, sim_clock_t *clock);
+void vcd_writer_label(vcd_writer_t *vw, uint32_t gpio_num, const char *name);
+bool vcd_writer_start(vcd_writer_t *vw);
+bool vcd_writer_close(vcd_writer_t *vw);
+
+#endif // VCD_H
@@ -1,158 +1,553 @@
 #include "button_control.h"
+#include "sim_log.h"
 #include <stdio.h>
-#include <time.h>
-#include <sys/time.h>
-
-// Button array for easy management
-static button_t buttons[NUM_BUTTONS] = {
-    {BUTTON1_PIN, BUTTON_RELEASED, BUTTON_RELEASED, 0, false, "BTN1"},
-    {BUTTON2_PIN, BUTTON_RELEASED, BUTTON_RELEASED, 0, false, "BTN2"},
-    {BUTTON3_PIN, BUTTON_RELEASED, BUTTON_RELEASED, 0, false, "BTN3"}
+#include <stdlib.h>
+#include <string.h>
+
+// Default board buttons registered by button_ctrl_init_board()
+#define BUTTON_BOARD_ROW(n, name, pin, led) {(pin), #name},
+static const struct {
+    uint32_t pin;
+    const char *name;
+} default_buttons[NUM_BUTTONS] = {
+    BOARD_BUTTONS(BUTTON_BOARD_ROW)
+};
+
+// Controller used by the default-instance API
+static button_controller_t default_controller;
+static button_debounce_engine_t default_engine = BUTTON_DEBOUNCE_TIMESTAMP;
+
+static const char *const engine_names[] = {
+    "timestamp", "vertical"
 };
 
-// Get current time in milliseconds
-uint32_t button_get_time_ms(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint32_t)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+// Raw edges popped from the queue per batch
+#define BUTTON_EDGE_BATCH 32
+
+// O(1) pin-to-button lookup, NULL if no button is registered on the pin
+static inline button_t *button_find(const button_controller_t *ctrl, uint32_t button_pin) {
+#ifdef BOARD_FIXED
+    // Board buttons sit at their row, so a constant pin needs no table
+    int row = board_button_index(button_pin);
+    if (row >= 0 && ctrl->board) {
+        return &ctrl->buttons[row];
+    }
+#endif
+    if (button_pin >= GPIO_NUM_MAX || ctrl->pin_index[button_pin] < 0) {
+        return NULL;
+    }
+    return &ctrl->buttons[ctrl->pin_index[button_pin]];
 }
 
-// Initialize all buttons
-void button_init_all(void) {
-    printf("[BUTTON] Initializing buttons...\n");
+// Initialize an empty button registry on a board, timed by 'clock'
+void button_ctrl_init(button_controller_t *ctrl, gpio_device_t *gpio, sim_clock_t *clock,
+                      button_debounce_engine_t engine) {
+    ctrl->gpio = gpio;
+    ctrl->clock = clock;
+    ctrl->engine = engine;
+    ctrl->buttons = NULL;
+    ctrl->count = 0;
+    ctrl->capacity = 0;
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        ctrl->pin_index[pin] = -1;
+    }
+    ctrl->pin_mask = 0;
+    ctrl->board = false;
+    ctrl->event_buttons = 0;
+    debounce_vc_init(&ctrl->vc, 0, DEBOUNCE_VC_THRESHOLD);
+    ctrl->next_sample_time = sim_clock_now(clock);
+    timer_wheel_init(&ctrl->wheel, clock);
+    ctrl->edge_overflow = 0;
+    ctrl->edge_overflows = 0;
+    ctrl->event_overflows = 0;
+    
+    // Without queue storage every edge takes the overflow path, which
+    // still tracks levels, and events are only visible through polling
+    if (!mpsc_ring_init(&ctrl->edges, BUTTON_EDGE_QUEUE_LEN, sizeof(button_edge_t)) ||
+        !mpsc_ring_init(&ctrl->events, BUTTON_EVENT_QUEUE_LEN, sizeof(button_event_t))) {
+        SIM_LOGE(BUTTON, SIM_EVT_BUTTON_ERR_QUEUE, 0, 0, NULL);
+    }
+    gpio_dev_install_isr_service(gpio);
+}
+
+// Release registry storage and detach the interrupt handlers
+void button_ctrl_deinit(button_controller_t *ctrl) {
+    for (size_t i = 0; i < ctrl->count; i++) {
+        gpio_dev_set_intr_type(ctrl->gpio, ctrl->buttons[i].pin, GPIO_INTR_DISABLE);
+        gpio_dev_isr_handler_remove(ctrl->gpio, ctrl->buttons[i].pin);
+        timer_wheel_cancel(&ctrl->wheel, &ctrl->debounce_timers[ctrl->buttons[i].pin]);
+    }
+    mpsc_ring_free(&ctrl->edges);
+    mpsc_ring_free(&ctrl->events);
+    free(ctrl->buttons);
+    ctrl->buttons = NULL;
+    ctrl->count = 0;
+    ctrl->capacity = 0;
+    ctrl->board = false;
+}
+
+// Pin interrupt handler: queue the edge with its level and time
+// May run on any thread that drives the input.
+static void button_isr_handler(void *arg) {
+    const button_isr_arg_t *isr = arg;
+    button_controller_t *ctrl = isr->ctrl;
+    button_edge_t edge = {
+        .time_ns = sim_clock_now(ctrl->clock),
+        .pin = isr->pin,
+        .level = gpio_dev_get_level(ctrl->gpio, isr->pin)
+    };
+    
+    // A full queue must not lose the input: flag the pin so the next
+    // update resynchronizes it from the register
+    if (!ctrl->edges.slots || !mpsc_ring_push(&ctrl->edges, &edge)) {
+        __atomic_fetch_or(&ctrl->edge_overflow, GPIO_PIN_SEL(isr->pin), __ATOMIC_RELEASE);
+        __atomic_fetch_add(&ctrl->edge_overflows, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void button_debounce_expired(void *arg, uint64_t deadline_ns);
+
+// Register a button on a pin and configure the pin as a pulled-up input
+// Returns the dense button index, or -1 on error. 'name' must outlive the controller.
+int button_ctrl_register(button_controller_t *ctrl, uint32_t button_pin, const char *name) {
+    if (!GPIO_IS_VALID_GPIO(button_pin) || ctrl->pin_index[button_pin] >= 0) {
+        SIM_LOGE(BUTTON, SIM_EVT_BUTTON_ERR_REGISTER, button_pin, 0, NULL);
+        return -1;
+    }
+    
+    if (ctrl->count == ctrl->capacity) {
+        size_t capacity = ctrl->capacity ? ctrl->capacity * 2 : 8;
+        button_t *buttons = realloc(ctrl->buttons, capacity * sizeof(button_t));
+        if (!buttons) {
+            SIM_LOGE(BUTTON, SIM_EVT_BUTTON_ERR_REGISTER, button_pin, 0, NULL);
+            return -1;
+        }
+        ctrl->buttons = buttons;
+        ctrl->capacity = capacity;
+    }
     
-    // Configure button pins as inputs with pull-up
+    // Grow the vertical counters last: they cannot shrink back
+    if (!debounce_vc_resize(&ctrl->vc, ctrl->count + 1)) {
+        SIM_LOGE(BUTTON, SIM_EVT_BUTTON_ERR_REGISTER, button_pin, 0, NULL);
+        return -1;
+    }
+    
+    // Configure button pin as input with pull-up
     gpio_config_t button_config = {
-        .pin_bit_mask = GPIO_PIN_SEL(BUTTON1_PIN) | GPIO_PIN_SEL(BUTTON2_PIN) | GPIO_PIN_SEL(BUTTON3_PIN),
+        .pin_bit_mask = GPIO_PIN_SEL(button_pin),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_ENABLE
     };
+    gpio_dev_config_pin(ctrl->gpio, &button_config);
     
-    gpio_config_pin(&button_config);
+    int index = (int)ctrl->count++;
+    button_t *button = &ctrl->buttons[index];
+    button->pin = button_pin;
+    button->current_state = BUTTON_RELEASED;
+    button->last_state = BUTTON_RELEASED;
+    button->last_debounce_time = sim_clock_now(ctrl->clock);
+    button->state_changed = false;
+    button->name = name;
+    ctrl->pin_index[button_pin] = (int16_t)index;
+    ctrl->pin_mask |= GPIO_PIN_SEL(button_pin);
     
-    // Initialize button states
-    uint32_t current_time = button_get_time_ms();
+    // Raw edges arrive through the pin interrupt
+    ctrl->isr_args[button_pin].ctrl = ctrl;
+    ctrl->isr_args[button_pin].pin = button_pin;
+    timer_wheel_timer_init(&ctrl->debounce_timers[button_pin], button_debounce_expired,
+                           &ctrl->isr_args[button_pin]);
+    gpio_dev_isr_handler_add(ctrl->gpio, button_pin, button_isr_handler, &ctrl->isr_args[button_pin]);
+    gpio_dev_set_intr_type(ctrl->gpio, button_pin, GPIO_INTR_ANYEDGE);
+    return index;
+}
+
+// Initialize a controller with the default board buttons
+void button_ctrl_init_board(button_controller_t *ctrl, gpio_device_t *gpio, sim_clock_t *clock,
+                            button_debounce_engine_t engine) {
+    SIM_LOGI(BUTTON, SIM_EVT_BUTTON_INIT_BEGIN, 0, 0, NULL);
+    
+    button_ctrl_init(ctrl, gpio, clock, engine);
+    int registered = 0;
     for (int i = 0; i < NUM_BUTTONS; i++) {
-        buttons[i].current_state = BUTTON_RELEASED;
-        buttons[i].last_state = BUTTON_RELEASED;
-        buttons[i].last_debounce_time = current_time;
-        buttons[i].state_changed = false;
+        registered += button_ctrl_register(ctrl, default_buttons[i].pin, default_buttons[i].name) == i;
     }
+    ctrl->board = registered == NUM_BUTTONS;
     
-    printf("[BUTTON] All buttons initialized\n");
+    SIM_LOGI(BUTTON, SIM_EVT_BUTTON_INIT_DONE, 0, 0, NULL);
 }
 
-// Update all button states (should be called regularly)
-void button_update_all(void) {
-    uint32_t current_time = button_get_time_ms();
+// Debounce deadline of one button: first time the input counts as stable
+static inline uint64_t button_deadline(const button_t *button) {
+    return button->last_debounce_time + DEBOUNCE_DELAY_NS + 1;
+}
+
+// Commit a debounced transition, flag it for edge queries and queue it
+static void button_commit(button_controller_t *ctrl, int i, button_state_t new_state,
+                          uint64_t current_time) {
+    ctrl->buttons[i].current_state = new_state;
+    ctrl->buttons[i].state_changed = true;
+    ctrl->event_buttons |= 1ULL << i;
     
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        // Read raw button state (inverted because of pull-up)
-        uint32_t raw_state = gpio_get_level(buttons[i].pin);
-        button_state_t new_state = (raw_state == GPIO_LEVEL_LOW) ? BUTTON_PRESSED : BUTTON_RELEASED;
-        
-        // Reset state change flag
-        buttons[i].state_changed = false;
-        
-        // Check if state has changed
-        if (new_state != buttons[i].last_state) {
-            buttons[i].last_debounce_time = current_time;
+    button_event_t event = {current_time, ctrl->buttons[i].pin, new_state};
+    if (!ctrl->events.slots || !mpsc_ring_push(&ctrl->events, &event)) {
+        ctrl->event_overflows++;
+    }
+    
+    SIM_LOGI(BUTTON, SIM_EVT_BUTTON_TRANSITION, ctrl->buttons[i].pin, new_state, ctrl->buttons[i].name);
+}
+
+// Debounce timer callback: the input has been stable for the debounce
+// delay, so commit its level if it differs from the debounced state
+static void button_debounce_expired(void *arg, uint64_t deadline_ns) {
+    const button_isr_arg_t *owner = arg;
+    button_controller_t *ctrl = owner->ctrl;
+    int i = ctrl->pin_index[owner->pin];
+    
+    button_state_t new_state = ctrl->buttons[i].last_state;
+    if (new_state != ctrl->buttons[i].current_state) {
+        button_commit(ctrl, i, new_state, deadline_ns);
+    }
+}
+
+// Record a raw level change of a button pin and restart its debounce
+// timer, replacing the deadline of the previous edge
+static void button_raw_edge(button_controller_t *ctrl, uint32_t pin, uint32_t level, uint64_t time_ns) {
+    if (pin >= GPIO_NUM_MAX || ctrl->pin_index[pin] < 0) {
+        return;
+    }
+    
+    // Inverted because of pull-up
+    int i = ctrl->pin_index[pin];
+    button_state_t new_state = level ? BUTTON_RELEASED : BUTTON_PRESSED;
+    if (new_state != ctrl->buttons[i].last_state) {
+        ctrl->buttons[i].last_state = new_state;
+        ctrl->buttons[i].last_debounce_time = time_ns;
+        if (ctrl->engine == BUTTON_DEBOUNCE_TIMESTAMP) {
+            timer_wheel_arm(&ctrl->wheel, &ctrl->debounce_timers[pin], button_deadline(&ctrl->buttons[i]));
         }
-        
-        // Check if enough time has passed for debouncing
-        if ((current_time - buttons[i].last_debounce_time) > DEBOUNCE_DELAY_MS) {
-            // If the state has changed after debounce period
-            if (new_state != buttons[i].current_state) {
-                buttons[i].current_state = new_state;
-                buttons[i].state_changed = true;
-                
-                printf("[BUTTON] %s %s\n", 
-                       buttons[i].name, 
-                       (new_state == BUTTON_PRESSED) ? "PRESSED" : "RELEASED");
+    }
+}
+
+// Drain queued raw edges in batches; with 'apply' they restart the
+// debounce of their button, otherwise they are only counted
+// Returns the number of edges taken, including overflow resyncs.
+static size_t button_drain_edges(button_controller_t *ctrl, uint64_t current_time, bool apply) {
+    button_edge_t batch[BUTTON_EDGE_BATCH];
+    uint64_t touched = 0;
+    size_t total = 0;
+    size_t n;
+    
+    if (ctrl->edges.slots) {
+        while ((n = mpsc_ring_pop_batch(&ctrl->edges, batch, BUTTON_EDGE_BATCH)) > 0) {
+            for (size_t k = 0; apply && k < n; k++) {
+                button_raw_edge(ctrl, batch[k].pin, batch[k].level, batch[k].time_ns);
+                touched |= GPIO_PIN_SEL(batch[k].pin);
             }
+            total += n;
         }
-        
-        buttons[i].last_state = new_state;
     }
+    
+    uint64_t overflow = __atomic_exchange_n(&ctrl->edge_overflow, 0, __ATOMIC_ACQUIRE);
+    if (overflow) {
+        SIM_LOGE(BUTTON, SIM_EVT_BUTTON_EDGE_OVERFLOW, 0, overflow, NULL);
+        total++;
+    }
+    
+    // Handlers on racing threads may queue their edges out of order, and
+    // overflowed pins have no edge at all: settle both against a single
+    // register snapshot. Pins already at their queued level are unchanged.
+    uint64_t resync = (touched | overflow) & ctrl->pin_mask;
+    if (apply && resync) {
+        uint64_t levels = gpio_dev_read_all(ctrl->gpio);
+        while (resync) {
+            int pin = __builtin_ctzll(resync);
+            resync &= resync - 1;
+            button_raw_edge(ctrl, (uint32_t)pin, (uint32_t)((levels >> pin) & 1), current_time);
+        }
+    }
+    return total;
 }
 
-// Get button state
-button_state_t button_get_state(uint32_t button_pin) {
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        if (buttons[i].pin == button_pin) {
-            return buttons[i].current_state;
+// Timestamp engine: per-button debounce deadline timers
+static void button_update_timestamp(button_controller_t *ctrl, uint64_t current_time) {
+    // Restart the debounce timer of every button with a queued edge
+    button_drain_edges(ctrl, current_time, true);
+    
+    // Only buttons whose deadline has passed are called back
+    timer_wheel_run(&ctrl->wheel);
+}
+
+// Vertical counter engine: fixed-rate samples of the whole input vector
+static void button_update_vertical(button_controller_t *ctrl, uint64_t current_time) {
+    // Edges only wake the engine; it samples levels itself
+    bool edges = button_drain_edges(ctrl, current_time, false) > 0;
+    bool busy = debounce_vc_busy(&ctrl->vc);
+    
+    // While counting, only sample on the sample grid; an idle engine
+    // samples as soon as an edge arrives so it starts counting at once
+    if (busy ? current_time < ctrl->next_sample_time : !edges) {
+        return;
+    }
+    ctrl->next_sample_time = current_time + DEBOUNCE_SAMPLE_NS;
+    
+    // Sample every input pin in a single register read
+    uint64_t levels = gpio_dev_read_all(ctrl->gpio);
+    
+    // Gather raw pressed bits (inverted because of pull-up) in button order
+    uint64_t raw[DEBOUNCE_VC_WORDS] = {0};
+    for (size_t i = 0; i < ctrl->count; i++) {
+        bool pressed = !(levels & GPIO_PIN_SEL(ctrl->buttons[i].pin));
+        raw[i / 64] |= (uint64_t)pressed << (i % 64);
+        ctrl->buttons[i].last_state = pressed ? BUTTON_PRESSED : BUTTON_RELEASED;
+    }
+    
+    if (!debounce_vc_update(&ctrl->vc, raw)) {
+        return;
+    }
+    
+    for (size_t w = 0; w < ctrl->vc.num_words; w++) {
+        uint64_t edges = ctrl->vc.pressed[w] | ctrl->vc.released[w];
+        while (edges) {
+            int bit = __builtin_ctzll(edges);
+            edges &= edges - 1;
+            
+            int i = (int)(w * 64) + bit;
+            button_commit(ctrl, i, (ctrl->vc.pressed[w] >> bit) & 1 ? BUTTON_PRESSED : BUTTON_RELEASED,
+                          current_time);
         }
     }
-    printf("[BUTTON ERROR] Invalid button pin: %d\n", button_pin);
-    return BUTTON_RELEASED;
+}
+
+// Update button states after an input edge or an expired deadline
+// Only buttons with a queued edge or an expired debounce timer are serviced.
+void button_ctrl_update_all(button_controller_t *ctrl) {
+    uint64_t current_time = sim_clock_now(ctrl->clock);
+    
+    // Reset last update's state change flags
+    while (ctrl->event_buttons) {
+        int i = __builtin_ctzll(ctrl->event_buttons);
+        ctrl->event_buttons &= ctrl->event_buttons - 1;
+        ctrl->buttons[i].state_changed = false;
+    }
+    
+    if (ctrl->engine == BUTTON_DEBOUNCE_VERTICAL) {
+        button_update_vertical(ctrl, current_time);
+    } else {
+        button_update_timestamp(ctrl, current_time);
+    }
+}
+
+// Time by which button_ctrl_update_all() must run again to meet the
+// earliest debounce deadline, in sim_clock_now_ns() time
+// Returns false when no button is waiting.
+bool button_ctrl_next_deadline(const button_controller_t *ctrl, uint64_t *deadline_ns) {
+    bool found = false;
+    uint64_t earliest = 0;
+    
+    if (ctrl->engine == BUTTON_DEBOUNCE_VERTICAL) {
+        found = debounce_vc_busy(&ctrl->vc);
+        earliest = ctrl->next_sample_time;
+    } else {
+        found = timer_wheel_next_deadline(&ctrl->wheel, &earliest);
+    }
+    
+    if (found && deadline_ns) {
+        *deadline_ns = earliest;
+    }
+    return found;
+}
+
+// Check whether debounced transitions are waiting to be taken
+bool button_ctrl_has_events(const button_controller_t *ctrl) {
+    return ctrl->events.slots && !mpsc_ring_is_empty(&ctrl->events);
+}
+
+// Take up to 'max' debounced transitions, oldest first
+// Unlike the state_changed flags, queued events survive later updates.
+size_t button_ctrl_get_events(button_controller_t *ctrl, button_event_t *events, size_t max) {
+    if (!ctrl->events.slots) {
+        return 0;
+    }
+    return mpsc_ring_pop_batch(&ctrl->events, events, max);
+}
+
+// Get button state
+button_state_t button_ctrl_get_state(const button_controller_t *ctrl, uint32_t button_pin) {
+    const button_t *button = button_find(ctrl, button_pin);
+    if (!button) {
+        SIM_LOGE(BUTTON, SIM_EVT_BUTTON_ERR_INVALID_PIN, button_pin, 0, NULL);
+        return BUTTON_RELEASED;
+    }
+    return button->current_state;
 }
 
 // Check if button is currently pressed
-bool button_is_pressed(uint32_t button_pin) {
-    return button_get_state(button_pin) == BUTTON_PRESSED;
+bool button_ctrl_is_pressed(const button_controller_t *ctrl, uint32_t button_pin) {
+    return button_ctrl_get_state(ctrl, button_pin) == BUTTON_PRESSED;
 }
 
 // Check if button was just pressed (edge detection)
-bool button_was_pressed(uint32_t button_pin) {
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        if (buttons[i].pin == button_pin) {
-            return (buttons[i].state_changed && buttons[i].current_state == BUTTON_PRESSED);
-        }
-    }
-    return false;
+bool button_ctrl_was_pressed(const button_controller_t *ctrl, uint32_t button_pin) {
+    const button_t *button = button_find(ctrl, button_pin);
+    return button && button->state_changed && button->current_state == BUTTON_PRESSED;
 }
 
 // Check if button was just released (edge detection)
-bool button_was_released(uint32_t button_pin) {
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        if (buttons[i].pin == button_pin) {
-            return (buttons[i].state_changed && buttons[i].current_state == BUTTON_RELEASED);
-        }
-    }
-    return false;
+bool button_ctrl_was_released(const button_controller_t *ctrl, uint32_t button_pin) {
+    const button_t *button = button_find(ctrl, button_pin);
+    return button && button->state_changed && button->current_state == BUTTON_RELEASED;
 }
 
 // Clear button events (reset state_changed flag)
-void button_clear_events(uint32_t button_pin) {
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        if (buttons[i].pin == button_pin) {
-            buttons[i].state_changed = false;
-            return;
-        }
+void button_ctrl_clear_events(button_controller_t *ctrl, uint32_t button_pin) {
+    button_t *button = button_find(ctrl, button_pin);
+    if (button) {
+        button->state_changed = false;
+        ctrl->event_buttons &= ~(1ULL << ctrl->pin_index[button_pin]);
     }
 }
 
 // Display button status
-void button_display_status(void) {
+void button_ctrl_display_status(const button_controller_t *ctrl) {
+    sim_log_flush();
     printf("\n=== Button Status ===\n");
-    for (int i = 0; i < NUM_BUTTONS; i++) {
+    for (size_t i = 0; i < ctrl->count; i++) {
         printf("  %s (Pin %d): %s\n", 
-               buttons[i].name, 
-               buttons[i].pin, 
-               (buttons[i].current_state == BUTTON_PRESSED) ? "PRESSED" : "RELEASED");
+               ctrl->buttons[i].name, 
+               ctrl->buttons[i].pin, 
+               (ctrl->buttons[i].current_state == BUTTON_PRESSED) ? "PRESSED" : "RELEASED");
     }
     printf("=====================\n\n");
 }
 
 // Get button name
-const char* button_get_name(uint32_t button_pin) {
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        if (buttons[i].pin == button_pin) {
-            return buttons[i].name;
+const char* button_ctrl_get_name(const button_controller_t *ctrl, uint32_t button_pin) {
+    const button_t *button = button_find(ctrl, button_pin);
+    return button ? button->name : "UNKNOWN";
+}
+
+// Simulation functions for testing
+void button_ctrl_simulate_press(button_controller_t *ctrl, uint32_t button_pin) {
+    gpio_dev_simulate_button_press(ctrl->gpio, button_pin);
+}
+
+void button_ctrl_simulate_release(button_controller_t *ctrl, uint32_t button_pin) {
+    gpio_dev_simulate_button_release(ctrl->gpio, button_pin);
+}
+
+// Resume debouncing from button state that was written directly
+// (snapshot restore): the queued edges and events of the abandoned run
+// are dropped and the debounce timers re-armed from each button's last
+// raw edge. The clock may have moved back, so the wheel restarts at the
+// current time.
+void button_ctrl_reload(button_controller_t *ctrl) {
+    button_edge_t edge;
+    button_event_t event;
+    while (ctrl->edges.slots && mpsc_ring_pop(&ctrl->edges, &edge)) {
+    }
+    while (ctrl->events.slots && mpsc_ring_pop(&ctrl->events, &event)) {
+    }
+    __atomic_store_n(&ctrl->edge_overflow, 0, __ATOMIC_RELAXED);
+    
+    for (size_t i = 0; i < ctrl->count; i++) {
+        timer_wheel_cancel(&ctrl->wheel, &ctrl->debounce_timers[ctrl->buttons[i].pin]);
+    }
+    timer_wheel_init(&ctrl->wheel, ctrl->clock);
+    
+    if (ctrl->engine != BUTTON_DEBOUNCE_TIMESTAMP) {
+        return;
+    }
+    for (size_t i = 0; i < ctrl->count; i++) {
+        const button_t *button = &ctrl->buttons[i];
+        if (button->last_state != button->current_state) {
+            timer_wheel_arm(&ctrl->wheel, &ctrl->debounce_timers[button->pin], button_deadline(button));
         }
     }
-    return "UNKNOWN";
 }
 
-// Simulation functions for testing
+// Default-instance API
+
+// Get the controller used by the default-instance functions
+button_controller_t *button_default_controller(void) {
+    return &default_controller;
+}
+
+// Get current simulation time in milliseconds
+uint64_t button_get_time_ms(void) {
+    return sim_clock_now_ns() / SIM_CLOCK_NS_PER_MS;
+}
+
+// Choose the debounce engine used by button_init_all()
+void button_set_default_engine(button_debounce_engine_t engine) {
+    default_engine = engine;
+}
+
+// Parse "timestamp" or "vertical"; returns -1 if unknown
+int button_parse_engine(const char *name) {
+    for (int i = 0; i < (int)(sizeof(engine_names) / sizeof(engine_names[0])); i++) {
+        if (strcmp(name, engine_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void button_init_all(void) {
+    button_ctrl_init_board(&default_controller, gpio_default_device(), sim_clock_default(), default_engine);
+}
+
+int button_register(uint32_t button_pin, const char *name) {
+    return button_ctrl_register(&default_controller, button_pin, name);
+}
+
+void button_update_all(void) {
+    button_ctrl_update_all(&default_controller);
+}
+
+bool button_next_deadline(uint64_t *deadline_ns) {
+    return button_ctrl_next_deadline(&default_controller, deadline_ns);
+}
+
+bool button_has_events(void) {
+    return button_ctrl_has_events(&default_controller);
+}
+
+size_t button_get_events(button_event_t *events, size_t max) {
+    return button_ctrl_get_events(&default_controller, events, max);
+}
+
+button_state_t button_get_state(uint32_t button_pin) {
+    return button_ctrl_get_state(&default_controller, button_pin);
+}
+
+bool button_is_pressed(uint32_t button_pin) {
+    return button_ctrl_is_pressed(&default_controller, button_pin);
+}
+
+bool button_was_pressed(uint32_t button_pin) {
+    return button_ctrl_was_pressed(&default_controller, button_pin);
+}
+
+bool button_was_released(uint32_t button_pin) {
+    return button_ctrl_was_released(&default_controller, button_pin);
+}
+
+void button_clear_events(uint32_t button_pin) {
+    button_ctrl_clear_events(&default_controller, button_pin);
+}
+
+void button_display_status(void) {
+    button_ctrl_display_status(&default_controller);
+}
+
+const char* button_get_name(uint32_t button_pin) {
+    return button_ctrl_get_name(&default_controller, button_pin);
+}
+
 void button_simulate_press(uint32_t button_pin) {
-    // Use the GPIO mock simulation functions
-    extern void gpio_simulate_button_press(uint32_t gpio_num);
-    gpio_simulate_button_press(button_pin);
+    button_ctrl_simulate_press(&default_controller, button_pin);
 }
 
 void button_simulate_release(uint32_t button_pin) {
-    // Use the GPIO mock simulation functions
-    extern void gpio_simulate_button_release(uint32_t gpio_num);
-    gpio_simulate_button_release(button_pin);
-}
\ No newline at end of file
+    button_ctrl_simulate_release(&default_controller, button_pin);
+}
@@ -0,0 +1,285 @@
+#include "control_server.h"
+#include "event_loop.h"
+#include "sim_log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Largest request and reply frames
+#define CONTROL_REQUEST_MAX (sizeof(control_header_t) + CONTROL_MAX_OPS * sizeof(control_op_t))
+#define CONTROL_REPLY_MAX (sizeof(control_header_t) + CONTROL_MAX_OPS * sizeof(control_result_t))
+
+// Close a connection and free its slot
+static void control_client_close(control_client_t *client) {
+    event_loop_remove_fd(client->fd);
+    close(client->fd);
+    SIM_LOGI(SIMULATION, SIM_EVT_SIM_CONTROL_DISCONNECT, (uint32_t)(client - client->server->clients), 0, NULL);
+    free(client->buf);
+    free(client->out);
+    client->buf = NULL;
+    client->out = NULL;
+    client->len = 0;
+    client->out_len = 0;
+    client->out_done = 0;
+    client->fd = -1;
+}
+
+static void control_on_writable(int fd, void *arg);
+
+// Send a reply without blocking; what the socket does not take is kept in
+// the client's output buffer and sent once the socket is writable
+static bool control_send(control_client_t *client, const uint8_t *data, size_t size) {
+    while (size) {
+        ssize_t n = send(client->fd, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            memcpy(client->out, data, size);
+            client->out_len = size;
+            client->out_done = 0;
+            return event_loop_want_write(client->fd, control_on_writable);
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+// Execute one request frame and send its reply
+static bool control_execute(control_client_t *client, const control_header_t *req) {
+    control_server_t *srv = client->server;
+    control_header_t *rep = (control_header_t *)srv->reply;
+    control_result_t *results = (control_result_t *)(srv->reply + sizeof(control_header_t));
+    const control_op_t *ops = (const control_op_t *)((const uint8_t *)req + sizeof(control_header_t));
+    
+    memset(results, 0, req->count * sizeof(control_result_t));
+    if (req->count) {
+        srv->exec(srv->arg, ops, results, req->count);
+    }
+    srv->batches++;
+    srv->ops += req->count;
+    
+    rep->magic = CONTROL_MAGIC;
+    rep->seq = req->seq;
+    rep->count = req->count;
+    rep->status = CONTROL_OK;
+    for (uint32_t i = 0; i < req->count; i++) {
+        if (results[i].status != CONTROL_OK) {
+            rep->status = results[i].status;
+            break;
+        }
+    }
+    return control_send(client, srv->reply, sizeof(control_header_t) + req->count * sizeof(control_result_t));
+}
+
+// Execute every complete frame at the start of the buffer, stopping at a
+// reply that is still pending. Returns false if the connection must be
+// closed.
+static bool control_process(control_client_t *client) {
+    size_t done = 0;
+    
+    while (client->out_len == 0 && client->len - done >= sizeof(control_header_t)) {
+        const control_header_t *req = (const control_header_t *)(client->buf + done);
+        if (req->magic != CONTROL_MAGIC || req->count > CONTROL_MAX_OPS) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_CONTROL_ERR_FRAME, (uint32_t)(client - client->server->clients),
+                     req->magic, NULL);
+            return false;
+        }
+        
+        size_t size = sizeof(control_header_t) + req->count * sizeof(control_op_t);
+        if (client->len - done < size) {
+            break;
+        }
+        if (!control_execute(client, req)) {
+            return false;
+        }
+        done += size;
+    }
+    
+    // Keep the partial frame at the start of the buffer
+    if (done) {
+        memmove(client->buf, client->buf + done, client->len - done);
+        client->len -= done;
+    }
+    return true;
+}
+
+// Client fd readable: take everything queued, batch by batch
+static void control_on_client(int fd, void *arg) {
+    control_client_t *client = arg;
+    
+    for (;;) {
+        ssize_t n = recv(fd, client->buf + client->len, CONTROL_REQUEST_MAX - client->len, MSG_DONTWAIT);
+        if (n == 0) {
+            control_client_close(client);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                control_client_close(client);
+            }
+            return;
+        }
+        client->len += (size_t)n;
+        if (!control_process(client)) {
+            control_client_close(client);
+            return;
+        }
+        if (client->out_len) {
+            return;  // Read again once the reply is out
+        }
+    }
+}
+
+// Client fd writable while a reply is pending: send the rest, run the
+// requests that waited for it, then go back to reading
+static void control_on_writable(int fd, void *arg) {
+    control_client_t *client = arg;
+    
+    while (client->out_done < client->out_len) {
+        ssize_t n = send(fd, client->out + client->out_done, client->out_len - client->out_done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                control_client_close(client);
+            }
+            return;
+        }
+        client->out_done += (size_t)n;
+    }
+    
+    client->out_len = 0;
+    client->out_done = 0;
+    if (!control_process(client) || (client->out_len == 0 && !event_loop_want_write(fd, NULL))) {
+        control_client_close(client);
+    }
+}
+
+// Listening socket readable: accept every pending connection
+static void control_on_accept(int fd, void *arg) {
+    control_server_t *srv = arg;
+    
+    for (;;) {
+        int conn = accept(fd, NULL, NULL);
+        if (conn < 0) {
+            return;
+        }
+        fcntl(conn, F_SETFD, FD_CLOEXEC);
+        fcntl(conn, F_SETFL, fcntl(conn, F_GETFL) | O_NONBLOCK);
+        
+        control_client_t *client = NULL;
+        for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+            if (srv->clients[i].fd < 0) {
+                client = &srv->clients[i];
+                break;
+            }
+        }
+        if (client) {
+            client->buf = malloc(CONTROL_REQUEST_MAX);
+            client->out = malloc(CONTROL_REPLY_MAX);
+        }
+        if (!client || !client->buf || !client->out || !event_loop_add_fd(conn, control_on_client, client)) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_CONTROL_ERR, 0, EMFILE, srv->path);
+            if (client) {
+                free(client->buf);
+                free(client->out);
+                client->buf = NULL;
+                client->out = NULL;
+            }
+            close(conn);
+            continue;
+        }
+        
+        client->fd = conn;
+        client->len = 0;
+        client->out_len = 0;
+        client->out_done = 0;
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_CONTROL_CONNECT, (uint32_t)(client - srv->clients), 0, NULL);
+    }
+}
+
+// Listen on the socket 'path', replacing a stale one; each batch received
+// is executed with 'exec' from the event loop
+bool control_server_open(control_server_t *srv, const char *path, control_batch_fn_t exec, void *arg) {
+    struct sockaddr_un addr;
+    
+    memset(srv, 0, sizeof(*srv));
+    srv->path = path;
+    srv->exec = exec;
+    srv->arg = arg;
+    srv->listen_fd = -1;
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        srv->clients[i].server = srv;
+        srv->clients[i].fd = -1;
+    }
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_CONTROL_ERR, 0, ENAMETOOLONG, path);
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+    
+    srv->reply = malloc(CONTROL_REPLY_MAX);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (!srv->reply || fd < 0) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_CONTROL_ERR, 0, (uint64_t)errno, path);
+        free(srv->reply);
+        srv->reply = NULL;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, CONTROL_MAX_CLIENTS) != 0 ||
+        !event_loop_add_fd(fd, control_on_accept, srv)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_CONTROL_ERR, 0, (uint64_t)errno, path);
+        close(fd);
+        free(srv->reply);
+        srv->reply = NULL;
+        return false;
+    }
+    
+    srv->listen_fd = fd;
+    SIM_LOGI(SIMULATION, SIM_EVT_SIM_CONTROL_OPEN, 0, 0, path);
+    return true;
+}
+
+// Close every connection and remove the socket
+void control_server_close(control_server_t *srv) {
+    if (srv->listen_fd < 0) {
+        return;
+    }
+    
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        if (srv->clients[i].fd >= 0) {
+            control_client_close(&srv->clients[i]);
+        }
+    }
+    event_loop_remove_fd(srv->listen_fd);
+    close(srv->listen_fd);
+    unlink(srv->path);
+    free(srv->reply);
+    srv->reply = NULL;
+    srv->listen_fd = -1;
+    SIM_LOGI(SIMULATION, SIM_EVT_SIM_CONTROL_DONE, 0, srv->batches, srv->path);
+}
@@ -0,0 +1,148 @@
+#include "debounce_vc.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DEBOUNCE_VC_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Check whether the CPU can run the AVX2 kernel
+bool debounce_vc_avx2_available(void) {
+#ifdef DEBOUNCE_VC_HAVE_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// Initialize an engine for num_inputs inputs, all inactive
+// An engine may start empty and grow with debounce_vc_resize().
+bool debounce_vc_init(debounce_vc_t *vc, size_t num_inputs, uint32_t threshold) {
+    if (num_inputs > DEBOUNCE_VC_MAX_INPUTS ||
+        threshold == 0 || threshold >= (1U << DEBOUNCE_VC_PLANES)) {
+        return false;
+    }
+    
+    memset(vc, 0, sizeof(*vc));
+    vc->num_inputs = num_inputs;
+    vc->num_words = (num_inputs + 63) / 64;
+    vc->threshold = threshold;
+    for (int p = 0; p < DEBOUNCE_VC_PLANES; p++) {
+        vc->threshold_mask[p] = ((threshold >> p) & 1U) ? ~0ULL : 0;
+    }
+    vc->use_avx2 = debounce_vc_avx2_available();
+    return true;
+}
+
+// Grow the input vector, keeping the state of existing inputs
+// New inputs start inactive with cleared counters.
+bool debounce_vc_resize(debounce_vc_t *vc, size_t num_inputs) {
+    if (num_inputs < vc->num_inputs || num_inputs > DEBOUNCE_VC_MAX_INPUTS) {
+        return false;
+    }
+    vc->num_inputs = num_inputs;
+    vc->num_words = (num_inputs + 63) / 64;
+    return true;
+}
+
+// Force the scalar kernel (enable = false) or re-enable AVX2 if supported
+void debounce_vc_set_avx2(debounce_vc_t *vc, bool enable) {
+    vc->use_avx2 = enable && debounce_vc_avx2_available();
+}
+
+// Scalar kernel for one 64-input word
+static inline void debounce_vc_word(debounce_vc_t *vc, size_t w, uint64_t raw) {
+    uint64_t delta = raw ^ vc->state[w];
+    uint64_t carry = delta;
+    uint64_t hit = delta;
+    
+    // Clear counters of inputs that agree with their state, count the rest,
+    // and find inputs whose count equals the threshold
+    for (int p = 0; p < DEBOUNCE_VC_PLANES; p++) {
+        uint64_t c = vc->count[p][w] & delta;
+        uint64_t next_carry = c & carry;
+        c ^= carry;
+        carry = next_carry;
+        hit &= ~(c ^ vc->threshold_mask[p]);
+        vc->count[p][w] = c;
+    }
+    
+    // Flip the debounced inputs and restart their counters
+    for (int p = 0; p < DEBOUNCE_VC_PLANES; p++) {
+        vc->count[p][w] &= ~hit;
+    }
+    vc->state[w] ^= hit;
+    vc->pressed[w] = hit & vc->state[w];
+    vc->released[w] = hit & ~vc->state[w];
+}
+
+#ifdef DEBOUNCE_VC_HAVE_AVX2
+// AVX2 kernel: four words (256 inputs) per iteration
+__attribute__((target("avx2")))
+static size_t debounce_vc_update_avx2(debounce_vc_t *vc, const uint64_t *raw) {
+    __m256i thr[DEBOUNCE_VC_PLANES];
+    for (int p = 0; p < DEBOUNCE_VC_PLANES; p++) {
+        thr[p] = _mm256_set1_epi64x((long long)vc->threshold_mask[p]);
+    }
+    
+    size_t w = 0;
+    for (; w + 4 <= vc->num_words; w += 4) {
+        __m256i state = _mm256_load_si256((const __m256i *)&vc->state[w]);
+        __m256i delta = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&raw[w]), state);
+        __m256i carry = delta;
+        __m256i hit = delta;
+        __m256i c[DEBOUNCE_VC_PLANES];
+        
+        for (int p = 0; p < DEBOUNCE_VC_PLANES; p++) {
+            c[p] = _mm256_and_si256(_mm256_load_si256((const __m256i *)&vc->count[p][w]), delta);
+            __m256i next_carry = _mm256_and_si256(c[p], carry);
+            c[p] = _mm256_xor_si256(c[p], carry);
+            carry = next_carry;
+            hit = _mm256_andnot_si256(_mm256_xor_si256(c[p], thr[p]), hit);
+        }
+        for (int p = 0; p < DEBOUNCE_VC_PLANES; p++) {
+            _mm256_store_si256((__m256i *)&vc->count[p][w], _mm256_andnot_si256(hit, c[p]));
+        }
+        
+        state = _mm256_xor_si256(state, hit);
+        _mm256_store_si256((__m256i *)&vc->state[w], state);
+        _mm256_store_si256((__m256i *)&vc->pressed[w], _mm256_and_si256(hit, state));
+        _mm256_store_si256((__m256i *)&vc->released[w], _mm256_andnot_si256(state, hit));
+    }
+    return w;
+}
+#endif
+
+// Feed one sample of every input; raw must hold num_words words
+// Fills the pressed/released edge masks and returns true if any input flipped.
+bool debounce_vc_update(debounce_vc_t *vc, const uint64_t *raw) {
+    size_t w = 0;
+    
+#ifdef DEBOUNCE_VC_HAVE_AVX2
+    if (vc->use_avx2) {
+        w = debounce_vc_update_avx2(vc, raw);
+    }
+#endif
+    for (; w < vc->num_words; w++) {
+        debounce_vc_word(vc, w, raw[w]);
+    }
+    
+    uint64_t any = 0;
+    for (w = 0; w < vc->num_words; w++) {
+        any |= vc->pressed[w] | vc->released[w];
+    }
+    return any != 0;
+}
+
+// True while any input is counting towards a flip (needs further samples)
+bool debounce_vc_busy(const debounce_vc_t *vc) {
+    uint64_t any = 0;
+    for (size_t w = 0; w < vc->num_words; w++) {
+        any |= vc->count[0][w];
+        for (int p = 1; p < DEBOUNCE_VC_PLANES; p++) {
+            any |= vc->count[p][w];
+        }
+    }
+    return any != 0;
+}
@@ -0,0 +1,131 @@
+#include "esp_timer.h"
+#include "sim_log.h"
+#include <stdlib.h>
+
+// Software timer: one wheel timer plus the esp_timer bookkeeping
+struct esp_timer {
+    timer_wheel_t *wheel;
+    timer_wheel_timer_t timer;
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    uint64_t period_ns;           // 0 for a one-shot timer
+    bool skip_unhandled_events;
+};
+
+// Wheel callback: re-arm a periodic timer, then run the user callback
+static void esp_timer_fire(void *arg, uint64_t deadline_ns) {
+    struct esp_timer *t = arg;
+    
+    if (t->period_ns) {
+        uint64_t next = deadline_ns + t->period_ns;
+        if (t->skip_unhandled_events) {
+            // Resume on the period grid after the current time
+            uint64_t now = sim_clock_now(t->wheel->clock);
+            if (next <= now) {
+                next += (now - next) / t->period_ns * t->period_ns + t->period_ns;
+            }
+        }
+        timer_wheel_arm(t->wheel, &t->timer, next);
+    }
+    t->callback(t->arg);
+}
+
+// Arm a created timer 'timeout_us' from now
+static bool esp_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+    if (!timer || timer->timer.armed) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TIMER_ERR_STATE, 1, 0, timer ? timer->name : NULL);
+        return false;
+    }
+    
+    timer->period_ns = period_us * SIM_CLOCK_NS_PER_US;
+    timer_wheel_arm(timer->wheel, &timer->timer,
+                    sim_clock_now(timer->wheel->clock) + timeout_us * SIM_CLOCK_NS_PER_US);
+    return true;
+}
+
+// Create an idle timer on 'wheel'
+bool esp_timer_create_on(timer_wheel_t *wheel, const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle) {
+    if (!args || !args->callback || !out_handle) {
+        return false;
+    }
+    
+    struct esp_timer *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return false;
+    }
+    t->wheel = wheel;
+    t->callback = args->callback;
+    t->arg = args->arg;
+    t->name = args->name;
+    t->skip_unhandled_events = args->skip_unhandled_events;
+    timer_wheel_timer_init(&t->timer, esp_timer_fire, t);
+    *out_handle = t;
+    return true;
+}
+
+// Fire once, 'timeout_us' from now
+bool esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return esp_timer_start(timer, timeout_us, 0);
+}
+
+// Fire every 'period_us', first one period from now
+bool esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    if (period_us == 0) {
+        return false;
+    }
+    return esp_timer_start(timer, period_us, period_us);
+}
+
+// Move a running timer's next expiry to 'timeout_us' from now; a periodic
+// timer also takes 'timeout_us' as its new period
+bool esp_timer_restart(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (!timer || !timer->timer.armed) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TIMER_ERR_STATE, 0, 0, timer ? timer->name : NULL);
+        return false;
+    }
+    
+    uint64_t period_us = timer->period_ns ? timeout_us : 0;
+    timer_wheel_cancel(timer->wheel, &timer->timer);
+    return esp_timer_start(timer, timeout_us, period_us);
+}
+
+// Stop a running timer
+bool esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer || !timer->timer.armed) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TIMER_ERR_STATE, 0, 0, timer ? timer->name : NULL);
+        return false;
+    }
+    timer_wheel_cancel(timer->wheel, &timer->timer);
+    return true;
+}
+
+// Free a stopped timer
+bool esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) {
+        return false;
+    }
+    if (timer->timer.armed) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TIMER_ERR_STATE, 1, 0, timer->name);
+        return false;
+    }
+    free(timer);
+    return true;
+}
+
+// Check whether a timer is running
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    return timer && timer->timer.armed;
+}
+
+// Default-instance API
+
+// Create an idle timer on the default wheel
+bool esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle) {
+    return esp_timer_create_on(timer_wheel_default(), args, out_handle);
+}
+
+// Microseconds of the default clock
+int64_t esp_timer_get_time(void) {
+    return (int64_t)(sim_clock_now(sim_clock_default()) / SIM_CLOCK_NS_PER_US);
+}
@@ -0,0 +1,354 @@
+#include "event_loop.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+// Registered fd handlers
+static struct {
+    int fd;
+    event_loop_fd_cb_t cb;
+    void *arg;
+    event_loop_fd_cb_t write_cb;  // Set while the fd is watched for writability
+    bool always_ready;  // Regular files cannot be polled and never block
+} handlers[EVENT_LOOP_MAX_FDS];
+static int num_handlers = 0;
+static int num_always_ready = 0;
+
+// Set between a wake and the wait that consumes it, so a burst of wakes
+// from producer threads costs one write
+static bool wake_pending = false;
+
+// Find the handler slot for an fd, or -1
+static int event_loop_find(int fd) {
+    for (int i = 0; i < num_handlers; i++) {
+        if (handlers[i].fd == fd) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef __linux__
+
+static int epoll_fd = -1;
+static int timer_fd = -1;
+static int wake_fd = -1;
+
+// Register an fd with epoll, tagging it with its own number
+static bool event_loop_epoll_add(int fd) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+// Create the epoll instance and its timer / wake fds
+bool event_loop_init(void) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    
+    if (epoll_fd < 0 || timer_fd < 0 || wake_fd < 0 ||
+        !event_loop_epoll_add(timer_fd) || !event_loop_epoll_add(wake_fd)) {
+        perror("[MAIN ERROR] event loop init");
+        event_loop_deinit();
+        return false;
+    }
+    return true;
+}
+
+// Close every fd owned by the loop
+void event_loop_deinit(void) {
+    if (epoll_fd >= 0) close(epoll_fd);
+    if (timer_fd >= 0) close(timer_fd);
+    if (wake_fd >= 0) close(wake_fd);
+    epoll_fd = timer_fd = wake_fd = -1;
+    num_handlers = 0;
+    num_always_ready = 0;
+}
+
+// Watch an fd for readability
+bool event_loop_add_fd(int fd, event_loop_fd_cb_t cb, void *arg) {
+    if (num_handlers >= EVENT_LOOP_MAX_FDS || event_loop_find(fd) >= 0) {
+        return false;
+    }
+    
+    bool always_ready = false;
+    if (!event_loop_epoll_add(fd)) {
+        // epoll refuses regular files; they are always readable
+        if (errno != EPERM) {
+            return false;
+        }
+        always_ready = true;
+        num_always_ready++;
+    }
+    
+    handlers[num_handlers].fd = fd;
+    handlers[num_handlers].cb = cb;
+    handlers[num_handlers].arg = arg;
+    handlers[num_handlers].write_cb = NULL;
+    handlers[num_handlers].always_ready = always_ready;
+    num_handlers++;
+    return true;
+}
+
+// Stop watching an fd
+void event_loop_remove_fd(int fd) {
+    int i = event_loop_find(fd);
+    if (i < 0) {
+        return;
+    }
+    if (handlers[i].always_ready) {
+        num_always_ready--;
+    } else {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    }
+    handlers[i] = handlers[--num_handlers];
+}
+
+// Watch a registered fd for writability instead of readability, calling
+// 'write_cb' when it is writable; NULL goes back to reading
+bool event_loop_want_write(int fd, event_loop_fd_cb_t write_cb) {
+    int i = event_loop_find(fd);
+    if (i < 0 || handlers[i].always_ready) {
+        return false;
+    }
+    
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = write_cb ? EPOLLOUT : EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) != 0) {
+        return false;
+    }
+    handlers[i].write_cb = write_cb;
+    return true;
+}
+
+// Arm the one-shot timer for an absolute CLOCK_MONOTONIC time
+// A deadline in the past fires immediately.
+void event_loop_arm_deadline(uint64_t deadline_ns) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (deadline_ns == 0) {
+        deadline_ns = 1;  // A zero it_value would disarm
+    }
+    its.it_value.tv_sec = (time_t)(deadline_ns / 1000000000ULL);
+    its.it_value.tv_nsec = (long)(deadline_ns % 1000000000ULL);
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// Cancel the timer
+void event_loop_disarm_timer(void) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    timerfd_settime(timer_fd, 0, &its, NULL);
+}
+
+// Wake a blocked event_loop_wait(); async-signal-safe and thread-safe
+void event_loop_wake(void) {
+    if (__atomic_exchange_n(&wake_pending, true, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t ret = write(wake_fd, &one, sizeof(one));
+    (void)ret;
+}
+
+// Wait for something to happen (or just poll when !block), dispatch fd
+// callbacks, return EVENT_LOOP_* flags
+int event_loop_wait(bool block) {
+    struct epoll_event events[EVENT_LOOP_MAX_FDS + 2];
+    int flags = 0;
+    
+    bool sleep = block && num_always_ready == 0;
+    int n = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_FDS + 2, sleep ? -1 : 0);
+    if (n < 0) {
+        return (errno == EINTR) ? EVENT_LOOP_EINTR : 0;
+    }
+    
+    // Handlers may remove themselves, so walk from the end
+    for (int h = num_handlers - 1; h >= 0 && num_always_ready > 0; h--) {
+        if (h < num_handlers && handlers[h].always_ready) {
+            handlers[h].cb(handlers[h].fd, handlers[h].arg);
+            flags |= EVENT_LOOP_FD;
+        }
+    }
+    
+    for (int i = 0; i < n; i++) {
+        int fd = events[i].data.fd;
+        uint64_t count;
+        
+        if (fd == timer_fd) {
+            if (read(timer_fd, &count, sizeof(count)) > 0) {
+                flags |= EVENT_LOOP_TIMER;
+            }
+        } else if (fd == wake_fd) {
+            // Drain before clearing: a wake posted in between then
+            // writes again instead of being swallowed by this read
+            if (read(wake_fd, &count, sizeof(count)) > 0) {
+                flags |= EVENT_LOOP_WAKE;
+            }
+            __atomic_store_n(&wake_pending, false, __ATOMIC_RELEASE);
+        } else {
+            int h = event_loop_find(fd);
+            if (h >= 0) {
+                (handlers[h].write_cb ? handlers[h].write_cb : handlers[h].cb)(fd, handlers[h].arg);
+                flags |= EVENT_LOOP_FD;
+            }
+        }
+    }
+    return flags;
+}
+
+#else // !__linux__
+
+static int wake_pipe[2] = {-1, -1};
+static bool timer_armed = false;
+static uint64_t timer_deadline_ns;
+
+// Create the self-pipe used for wakeups
+bool event_loop_init(void) {
+    if (pipe(wake_pipe) != 0) {
+        perror("[MAIN ERROR] event loop init");
+        return false;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(wake_pipe[i], F_SETFL, fcntl(wake_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    return true;
+}
+
+// Close the self-pipe
+void event_loop_deinit(void) {
+    if (wake_pipe[0] >= 0) close(wake_pipe[0]);
+    if (wake_pipe[1] >= 0) close(wake_pipe[1]);
+    wake_pipe[0] = wake_pipe[1] = -1;
+    num_handlers = 0;
+}
+
+// Watch an fd for readability
+bool event_loop_add_fd(int fd, event_loop_fd_cb_t cb, void *arg) {
+    if (num_handlers >= EVENT_LOOP_MAX_FDS || event_loop_find(fd) >= 0) {
+        return false;
+    }
+    handlers[num_handlers].fd = fd;
+    handlers[num_handlers].cb = cb;
+    handlers[num_handlers].arg = arg;
+    handlers[num_handlers].write_cb = NULL;
+    num_handlers++;
+    return true;
+}
+
+// Stop watching an fd
+void event_loop_remove_fd(int fd) {
+    int i = event_loop_find(fd);
+    if (i >= 0) {
+        handlers[i] = handlers[--num_handlers];
+    }
+}
+
+// Watch a registered fd for writability instead of readability, calling
+// 'write_cb' when it is writable; NULL goes back to reading
+bool event_loop_want_write(int fd, event_loop_fd_cb_t write_cb) {
+    int i = event_loop_find(fd);
+    if (i < 0) {
+        return false;
+    }
+    handlers[i].write_cb = write_cb;
+    return true;
+}
+
+// Arm the one-shot timer for an absolute CLOCK_MONOTONIC time
+void event_loop_arm_deadline(uint64_t deadline_ns) {
+    timer_deadline_ns = deadline_ns;
+    timer_armed = true;
+}
+
+// Cancel the timer
+void event_loop_disarm_timer(void) {
+    timer_armed = false;
+}
+
+// Wake a blocked event_loop_wait(); async-signal-safe and thread-safe
+void event_loop_wake(void) {
+    if (__atomic_exchange_n(&wake_pending, true, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    char one = 1;
+    ssize_t ret = write(wake_pipe[1], &one, 1);
+    (void)ret;
+}
+
+// Milliseconds until the armed timer expires, -1 if disarmed
+static int event_loop_timeout_ms(void) {
+    if (!timer_armed) {
+        return -1;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    if (timer_deadline_ns <= now) {
+        return 0;
+    }
+    return (int)((timer_deadline_ns - now + 999999ULL) / 1000000ULL);
+}
+
+// Wait for something to happen (or just poll when !block), dispatch fd
+// callbacks, return EVENT_LOOP_* flags
+int event_loop_wait(bool block) {
+    struct pollfd fds[EVENT_LOOP_MAX_FDS + 1];
+    int flags = 0;
+    int count = num_handlers;
+    
+    for (int i = 0; i < count; i++) {
+        fds[i].fd = handlers[i].fd;
+        fds[i].events = handlers[i].write_cb ? POLLOUT : POLLIN;
+        fds[i].revents = 0;
+    }
+    fds[count].fd = wake_pipe[0];
+    fds[count].events = POLLIN;
+    fds[count].revents = 0;
+    
+    int n = poll(fds, (nfds_t)count + 1, block ? event_loop_timeout_ms() : 0);
+    if (n < 0) {
+        return (errno == EINTR) ? EVENT_LOOP_EINTR : 0;
+    }
+    
+    if (timer_armed && event_loop_timeout_ms() == 0) {
+        timer_armed = false;
+        flags |= EVENT_LOOP_TIMER;
+    }
+    if (fds[count].revents & POLLIN) {
+        char buf[64];
+        while (read(wake_pipe[0], buf, sizeof(buf)) > 0) {
+        }
+        __atomic_store_n(&wake_pending, false, __ATOMIC_RELEASE);
+        flags |= EVENT_LOOP_WAKE;
+    }
+    for (int i = 0; i < count; i++) {
+        if (fds[i].revents & (POLLIN | POLLOUT | POLLHUP | POLLERR)) {
+            int h = event_loop_find(fds[i].fd);
+            if (h >= 0) {
+                (handlers[h].write_cb ? handlers[h].write_cb : handlers[h].cb)(fds[i].fd, handlers[h].arg);
+                flags |= EVENT_LOOP_FD;
+            }
+        }
+    }
+    return flags;
+}
+
+#endif // __linux__
@@ -0,0 +1,264 @@
+#include "gpio_bounce.h"
+#include "sim_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Intervals when a model string gives only the bounce count
+#define GPIO_BOUNCE_DEFAULT_MIN_US 50
+#define GPIO_BOUNCE_DEFAULT_MAX_US 1000
+
+// Device used by the default-instance API
+static gpio_bounce_t default_device;
+
+// SplitMix64 step of a pin's generator
+static uint64_t gpio_bounce_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform value in [lo, hi]
+static uint32_t gpio_bounce_range(uint64_t *state, uint32_t lo, uint32_t hi) {
+    return lo + (uint32_t)(gpio_bounce_next(state) % ((uint64_t)hi - lo + 1));
+}
+
+// Interval before edge 'k' (1-based) of a burst of 'total' edges after the first
+static uint64_t gpio_bounce_interval(gpio_bounce_pin_t *p, uint32_t k, uint32_t total) {
+    const gpio_bounce_config_t *cfg = &p->config;
+    uint32_t hi = cfg->max_us;
+    if (cfg->dist == GPIO_BOUNCE_DECAYING) {
+        hi = cfg->min_us + (uint32_t)((uint64_t)(cfg->max_us - cfg->min_us) * (total - k + 1) / total);
+    }
+    return gpio_bounce_range(&p->rng, cfg->min_us, hi) * SIM_CLOCK_NS_PER_US;
+}
+
+// Level after edge 'k' of the burst
+static inline uint32_t gpio_bounce_edge_level(const gpio_bounce_pin_t *p, uint32_t k) {
+    return (k & 1) ? !p->level : p->level;
+}
+
+// Last edge of the burst at or before 't', starting from edge 'k'
+static inline uint32_t gpio_bounce_edge_at(const gpio_bounce_pin_t *p, uint32_t k, uint64_t t) {
+    while (k + 1 < p->count && p->times[k + 1] <= t) {
+        k++;
+    }
+    return k;
+}
+
+// GPIO level source of a bouncing pin: the level at the current time
+static uint32_t gpio_bounce_pin_level(void *arg, uint32_t gpio_num) {
+    const gpio_bounce_pin_t *p = arg;
+    (void)gpio_num;
+    uint64_t now = sim_clock_now(p->dev->clock);
+    return gpio_bounce_edge_level(p, gpio_bounce_edge_at(p, p->next - 1, now));
+}
+
+// Drop the burst of a pin; IN keeps the last level written
+static void gpio_bounce_stop(gpio_bounce_t *dev, gpio_bounce_pin_t *p) {
+    if (p->count) {
+        timer_wheel_cancel(dev->wheel, &p->timer);
+        gpio_dev_set_level_source(dev->gpio, p->pin, NULL, NULL);
+        p->count = 0;
+    }
+}
+
+// Arm the timer for the next edge to write: every edge while the pin is
+// observed, otherwise only the one the burst settles on
+static void gpio_bounce_schedule(gpio_bounce_t *dev, gpio_bounce_pin_t *p) {
+    if (p->next >= p->count) {
+        gpio_bounce_stop(dev, p);
+        return;
+    }
+    uint32_t k = gpio_dev_is_observed(dev->gpio, p->pin) ? p->next : p->count - 1;
+    timer_wheel_arm(dev->wheel, &p->timer, p->times[k]);
+}
+
+// Edge timer: write the edges due by now to IN. A late timer still
+// writes them one by one, so every edge raises its interrupt.
+static void gpio_bounce_edge_cb(void *arg, uint64_t deadline_ns) {
+    gpio_bounce_pin_t *p = arg;
+    gpio_bounce_t *dev = p->dev;
+    uint64_t bit = GPIO_PIN_SEL(p->pin);
+    uint32_t last = gpio_bounce_edge_at(p, p->next, deadline_ns);
+    
+    uint32_t k = gpio_dev_is_observed(dev->gpio, p->pin) ? p->next : last;
+    for (; k <= last; k++) {
+        gpio_dev_drive_inputs(dev->gpio, bit, gpio_bounce_edge_level(p, k) ? bit : 0);
+        dev->writes++;
+    }
+    p->next = last + 1;
+    gpio_bounce_schedule(dev, p);
+}
+
+// Input model of the device: bounce on modelled pins, clean edges elsewhere
+static bool gpio_bounce_model(void *arg, uint32_t gpio_num, uint32_t level) {
+    return gpio_bounce_dev_drive(arg, gpio_num, level);
+}
+
+// Initialize a board's bounce models, with none enabled, and route its
+// simulated button transitions through them
+void gpio_bounce_dev_init(gpio_bounce_t *dev, gpio_device_t *gpio, sim_clock_t *clock, timer_wheel_t *wheel,
+                          uint64_t seed) {
+    memset(dev, 0, sizeof(*dev));
+    dev->gpio = gpio;
+    dev->clock = clock;
+    dev->wheel = wheel;
+    dev->seed = seed;
+    for (uint32_t pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        dev->pins[pin].dev = dev;
+        dev->pins[pin].pin = pin;
+        timer_wheel_timer_init(&dev->pins[pin].timer, gpio_bounce_edge_cb, &dev->pins[pin]);
+    }
+    gpio_dev_set_input_model(gpio, gpio_bounce_model, dev);
+}
+
+// Drop every burst in flight and give the board clean edges again
+void gpio_bounce_dev_deinit(gpio_bounce_t *dev) {
+    gpio_bounce_dev_reset(dev);
+    gpio_dev_set_input_model(dev->gpio, NULL, NULL);
+}
+
+// Enable the bounce model of a pin, or disable it with a NULL 'config'
+// The pin's generator restarts from the device seed, so its bursts do
+// not depend on the activity of other pins.
+bool gpio_bounce_dev_set_pin(gpio_bounce_t *dev, uint32_t gpio_num, const gpio_bounce_config_t *config) {
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, gpio_num, 0, NULL);
+        return false;
+    }
+    if (config && (config->min_bounces > config->max_bounces || config->max_bounces > GPIO_BOUNCE_MAX_BOUNCES ||
+                   config->min_us < 1 || config->min_us > config->max_us || config->max_us > GPIO_BOUNCE_MAX_US ||
+                   config->dist > GPIO_BOUNCE_DECAYING)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_BOUNCE, gpio_num, 0, "out of range");
+        return false;
+    }
+    
+    gpio_bounce_pin_t *p = &dev->pins[gpio_num];
+    gpio_bounce_stop(dev, p);
+    p->enabled = config != NULL;
+    if (config) {
+        p->config = *config;
+        p->rng = dev->seed ^ ((uint64_t)(gpio_num + 1) * 0xd1b54a32d192ed03ULL);
+    }
+    return true;
+}
+
+// Move a modelled pin to 'level' through a bounce burst starting now
+// Returns false, driving nothing, if the pin has no model.
+bool gpio_bounce_dev_drive(gpio_bounce_t *dev, uint32_t gpio_num, uint32_t level) {
+    if (gpio_num >= GPIO_NUM_MAX || !dev->pins[gpio_num].enabled) {
+        return false;
+    }
+    
+    // A new transition cuts the chatter of the previous one short
+    gpio_bounce_pin_t *p = &dev->pins[gpio_num];
+    gpio_bounce_stop(dev, p);
+    
+    uint32_t total = 2 * gpio_bounce_range(&p->rng, p->config.min_bounces, p->config.max_bounces);
+    uint64_t t = sim_clock_now(dev->clock);
+    p->level = level ? 1u : 0u;
+    p->times[0] = t;
+    for (uint32_t k = 1; k <= total; k++) {
+        t += gpio_bounce_interval(p, k, total);
+        p->times[k] = t;
+    }
+    p->count = total + 1;
+    p->next = 1;
+    dev->transitions += total > 0;
+    dev->edges += p->count;
+    
+    // The source goes in first so the first edge's interrupt reads it
+    uint64_t bit = GPIO_PIN_SEL(gpio_num);
+    if (total) {
+        gpio_dev_set_level_source(dev->gpio, gpio_num, gpio_bounce_pin_level, p);
+        SIM_LOGD(GPIO, SIM_EVT_GPIO_BOUNCE, gpio_num, p->count, NULL);
+    }
+    gpio_dev_drive_inputs(dev->gpio, bit, p->level ? bit : 0);
+    dev->writes++;
+    if (total) {
+        gpio_bounce_schedule(dev, p);
+    } else {
+        p->count = 0;
+    }
+    return true;
+}
+
+// Drop every burst in flight, e.g. before the registers are reloaded
+void gpio_bounce_dev_reset(gpio_bounce_t *dev) {
+    for (uint32_t pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        gpio_bounce_stop(dev, &dev->pins[pin]);
+    }
+}
+
+// Parse "BOUNCES[-MAX][:MIN_US-MAX_US][:uniform|decaying]", e.g. "2-6" or
+// "4:100-2000:decaying", into a configuration
+bool gpio_bounce_parse(const char *spec, gpio_bounce_config_t *config) {
+    char *end;
+    gpio_bounce_config_t cfg = {
+        .min_us = GPIO_BOUNCE_DEFAULT_MIN_US,
+        .max_us = GPIO_BOUNCE_DEFAULT_MAX_US,
+        .dist = GPIO_BOUNCE_UNIFORM
+    };
+    
+    cfg.min_bounces = cfg.max_bounces = (uint32_t)strtoul(spec, &end, 10);
+    if (end == spec) {
+        return false;
+    }
+    if (*end == '-') {
+        spec = end + 1;
+        cfg.max_bounces = (uint32_t)strtoul(spec, &end, 10);
+        if (end == spec) {
+            return false;
+        }
+    }
+    if (*end == ':' && end[1] >= '0' && end[1] <= '9') {
+        spec = end + 1;
+        cfg.min_us = (uint32_t)strtoul(spec, &end, 10);
+        if (*end != '-') {
+            return false;
+        }
+        spec = end + 1;
+        cfg.max_us = (uint32_t)strtoul(spec, &end, 10);
+        if (end == spec) {
+            return false;
+        }
+    }
+    if (*end == ':') {
+        if (strcmp(end + 1, "uniform") == 0) {
+            cfg.dist = GPIO_BOUNCE_UNIFORM;
+        } else if (strcmp(end + 1, "decaying") == 0) {
+            cfg.dist = GPIO_BOUNCE_DECAYING;
+        } else {
+            return false;
+        }
+    } else if (*end != '\0') {
+        return false;
+    }
+    
+    if (cfg.min_bounces > cfg.max_bounces || cfg.max_bounces > GPIO_BOUNCE_MAX_BOUNCES ||
+        cfg.min_us < 1 || cfg.min_us > cfg.max_us || cfg.max_us > GPIO_BOUNCE_MAX_US) {
+        return false;
+    }
+    *config = cfg;
+    return true;
+}
+
+// Default-instance API
+
+// Get the device used by the default-instance functions
+gpio_bounce_t *gpio_bounce_default_device(void) {
+    return &default_device;
+}
+
+void gpio_bounce_init_all(uint64_t seed) {
+    gpio_bounce_dev_init(&default_device, gpio_default_device(), sim_clock_default(), timer_wheel_default(), seed);
+}
+
+bool gpio_bounce_set_pin(uint32_t gpio_num, const gpio_bounce_config_t *config) {
+    return gpio_bounce_dev_set_pin(&default_device, gpio_num, config);
+}
+
+void gpio_bounce_reset(void) {
+    gpio_bounce_dev_reset(&default_device);
+}
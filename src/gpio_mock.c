@@ -1,172 +1,638 @@
 #include "gpio_mock.h"
+#include "board.h"
+#include "sim_log.h"
 #include <stdio.h>
 #include <string.h>
 
 // Mock GPIO register simulation
-#define MAX_GPIO_PINS 40
-
-// Simulated GPIO registers
-static struct {
-    uint32_t output_level[MAX_GPIO_PINS];  // Output level register
-    uint32_t input_level[MAX_GPIO_PINS];   // Input level register
-    gpio_mode_t mode[MAX_GPIO_PINS];       // Pin mode register
-    gpio_pullup_t pullup[MAX_GPIO_PINS];   // Pull-up configuration
-    bool initialized[MAX_GPIO_PINS];       // Track initialized pins
-} gpio_registers;
-
-// Initialize the GPIO mock system
-void gpio_mock_init(void) {
+#define MAX_GPIO_PINS GPIO_NUM_MAX
+
+// Mask covering every pin that physically exists
+#define GPIO_VALID_MASK ((1ULL << MAX_GPIO_PINS) - 1)
+
+// Board used by the default-instance API
+static gpio_device_t default_device;
+
+// Register words are only touched through these atomic accessors, so
+// stimulus threads and the application share a board without a lock
+static inline uint64_t gpio_reg_load(const uint64_t *reg) {
+    return __atomic_load_n(reg, __ATOMIC_ACQUIRE);
+}
+
+// Read-modify-write helpers return the previous register value
+static inline uint64_t gpio_reg_or(uint64_t *reg, uint64_t bits) {
+    return __atomic_fetch_or(reg, bits, __ATOMIC_ACQ_REL);
+}
+
+static inline uint64_t gpio_reg_and(uint64_t *reg, uint64_t bits) {
+    return __atomic_fetch_and(reg, bits, __ATOMIC_ACQ_REL);
+}
+
+static inline uint64_t gpio_reg_xor(uint64_t *reg, uint64_t bits) {
+    return __atomic_fetch_xor(reg, bits, __ATOMIC_ACQ_REL);
+}
+
+// Pins that are initialized and configured as outputs
+static inline uint64_t gpio_output_pins(const gpio_device_t *dev) {
+    return gpio_reg_load(&dev->configured) & gpio_reg_load(&dev->enable);
+}
+
+// Report pins whose level changed to every watch covering them
+static void gpio_notify_watches(gpio_device_t *dev, uint64_t changed, uint64_t levels) {
+    uint32_t count = __atomic_load_n(&dev->num_watches, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < count; i++) {
+        gpio_watch_t fn = __atomic_load_n(&dev->watches[i].fn, __ATOMIC_ACQUIRE);
+        uint64_t hit = changed & dev->watches[i].mask;
+        if (fn && hit) {
+            fn(dev->watches[i].arg, hit, levels);
+        }
+    }
+}
+
+// Notify watches of an OUT register update; only output pins show it
+static inline void gpio_out_changed(gpio_device_t *dev, uint64_t old_out, uint64_t new_out) {
+    uint64_t changed = (old_out ^ new_out) & gpio_output_pins(dev);
+    if (changed && __atomic_load_n(&dev->num_watches, __ATOMIC_ACQUIRE)) {
+        gpio_notify_watches(dev, changed, new_out);
+    }
+}
+
+// Initialize (reset) a simulated board
+void gpio_dev_init(gpio_device_t *dev) {
     // Clear all registers
-    memset(&gpio_registers, 0, sizeof(gpio_registers));
+    memset(dev, 0, sizeof(*dev));
     
     // Set default button states (simulate buttons not pressed)
-    gpio_registers.input_level[GPIO_NUM_18] = GPIO_LEVEL_HIGH;  // Button 1
-    gpio_registers.input_level[GPIO_NUM_19] = GPIO_LEVEL_HIGH;  // Button 2
-    gpio_registers.input_level[GPIO_NUM_21] = GPIO_LEVEL_HIGH;  // Button 3
+    dev->in = BOARD_BUTTON_MASK;
     
-    printf("[GPIO] Mock GPIO system initialized\n");
+    SIM_LOGI(GPIO, SIM_EVT_GPIO_INIT, 0, 0, NULL);
 }
 
 // Configure GPIO pin
-void gpio_config_pin(gpio_config_t *gpio_conf) {
+void gpio_dev_config_pin(gpio_device_t *dev, gpio_config_t *gpio_conf) {
     if (!gpio_conf) {
-        printf("[GPIO ERROR] Invalid configuration pointer\n");
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_NULL_CONFIG, 0, 0, NULL);
         return;
     }
     
-    // Configure each pin in the bit mask
+    uint64_t invalid = gpio_conf->pin_bit_mask & ~GPIO_VALID_MASK;
+    if (invalid) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_MASK, 0, invalid, NULL);
+    }
+    
+    uint64_t mask = gpio_conf->pin_bit_mask & GPIO_VALID_MASK;
+    if (!mask) {
+        return;
+    }
+    
+    if (gpio_conf->mode == GPIO_MODE_OUTPUT) {
+        // Initialize output pins to LOW
+        gpio_reg_and(&dev->out, ~mask);
+        gpio_reg_or(&dev->enable, mask);
+    } else {
+        gpio_reg_and(&dev->enable, ~mask);
+    }
+    if (gpio_conf->pull_up_en == GPIO_PULLUP_ENABLE) {
+        gpio_reg_or(&dev->pullup, mask);
+        // An idle pulled-up input reads HIGH
+        if (gpio_conf->mode == GPIO_MODE_INPUT) {
+            gpio_reg_or(&dev->in, mask);
+        }
+    } else {
+        gpio_reg_and(&dev->pullup, ~mask);
+    }
+    gpio_reg_or(&dev->configured, mask);
+    
     for (int pin = 0; pin < MAX_GPIO_PINS; pin++) {
-        if (gpio_conf->pin_bit_mask & (1ULL << pin)) {
-            if (!GPIO_IS_VALID_GPIO(pin)) {
-                printf("[GPIO ERROR] Invalid GPIO pin: %d\n", pin);
-                continue;
-            }
-            
-            gpio_registers.mode[pin] = gpio_conf->mode;
-            gpio_registers.pullup[pin] = gpio_conf->pull_up_en;
-            gpio_registers.initialized[pin] = true;
-            
-            // Initialize output pins to LOW
-            if (gpio_conf->mode == GPIO_MODE_OUTPUT) {
-                gpio_registers.output_level[pin] = GPIO_LEVEL_LOW;
-            }
-            
-            printf("[GPIO] Pin %d configured as %s\n", 
-                   pin, 
-                   (gpio_conf->mode == GPIO_MODE_OUTPUT) ? "OUTPUT" : "INPUT");
+        if (mask & GPIO_PIN_SEL(pin)) {
+            SIM_LOGI(GPIO, SIM_EVT_GPIO_CONFIG, pin, gpio_conf->mode, NULL);
         }
     }
 }
 
-// Set GPIO output level
-void gpio_set_level(uint32_t gpio_num, uint32_t level) {
+// Validate a single pin for output access, printing the reason on failure
+static inline bool gpio_check_output(const gpio_device_t *dev, uint32_t gpio_num) {
+    // LEDs of a fixed board are outputs from start-up on
+    if (BOARD_IS_FIXED_OUTPUT(gpio_num)) {
+        return true;
+    }
+    
     if (!GPIO_IS_VALID_GPIO(gpio_num)) {
-        printf("[GPIO ERROR] Invalid GPIO pin: %d\n", gpio_num);
-        return;
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, gpio_num, 0, NULL);
+        return false;
     }
     
-    if (!gpio_registers.initialized[gpio_num]) {
-        printf("[GPIO ERROR] GPIO pin %d not initialized\n", gpio_num);
-        return;
+    if (!(gpio_reg_load(&dev->configured) & GPIO_PIN_SEL(gpio_num))) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_NOT_INIT, gpio_num, 0, NULL);
+        return false;
     }
     
-    if (gpio_registers.mode[gpio_num] != GPIO_MODE_OUTPUT) {
-        printf("[GPIO ERROR] GPIO pin %d not configured as output\n", gpio_num);
+    if (!(gpio_reg_load(&dev->enable) & GPIO_PIN_SEL(gpio_num))) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_NOT_OUTPUT, gpio_num, 0, NULL);
+        return false;
+    }
+    
+    return true;
+}
+
+// Strip pins from a batch mask that are not usable outputs
+static uint64_t gpio_check_output_mask(const gpio_device_t *dev, uint64_t mask, const char *op) {
+    uint64_t invalid = mask & ~gpio_output_pins(dev);
+    if (invalid) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_MASK_NOT_OUTPUT, 0, invalid, op);
+    }
+    return mask & gpio_output_pins(dev);
+}
+
+// Set GPIO output level
+void gpio_dev_set_level(gpio_device_t *dev, uint32_t gpio_num, uint32_t level) {
+    if (!gpio_check_output(dev, gpio_num)) {
         return;
     }
     
-    gpio_registers.output_level[gpio_num] = (level != 0) ? GPIO_LEVEL_HIGH : GPIO_LEVEL_LOW;
+    uint64_t old_out;
+    if (level != 0) {
+        old_out = gpio_reg_or(&dev->out, GPIO_PIN_SEL(gpio_num));
+        gpio_out_changed(dev, old_out, old_out | GPIO_PIN_SEL(gpio_num));
+    } else {
+        old_out = gpio_reg_and(&dev->out, ~GPIO_PIN_SEL(gpio_num));
+        gpio_out_changed(dev, old_out, old_out & ~GPIO_PIN_SEL(gpio_num));
+    }
     
-    printf("[GPIO] Pin %d set to %s\n", 
-           gpio_num, 
-           (gpio_registers.output_level[gpio_num] == GPIO_LEVEL_HIGH) ? "HIGH" : "LOW");
+    SIM_LOGI(GPIO, SIM_EVT_GPIO_SET_LEVEL, gpio_num, level != 0, NULL);
 }
 
 // Get GPIO input level
-uint32_t gpio_get_level(uint32_t gpio_num) {
-    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
-        printf("[GPIO ERROR] Invalid GPIO pin: %d\n", gpio_num);
-        return 0;
+uint32_t gpio_dev_get_level(gpio_device_t *dev, uint32_t gpio_num) {
+    // Pins of a fixed board are configured at start-up
+    if (!BOARD_IS_FIXED_PIN(gpio_num)) {
+        if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+            SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, gpio_num, 0, NULL);
+            return 0;
+        }
+        
+        if (!(gpio_reg_load(&dev->configured) & GPIO_PIN_SEL(gpio_num))) {
+            SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_NOT_INIT, gpio_num, 0, NULL);
+            return 0;
+        }
+    }
+    
+    // Only this pin's source runs, so reading a pin never evaluates the
+    // sources of other pins
+    uint64_t bit = GPIO_PIN_SEL(gpio_num);
+    if (gpio_reg_load(&dev->sourced) & bit) {
+        return dev->sources[gpio_num].fn(dev->sources[gpio_num].arg, gpio_num) ? 1U : 0U;
+    }
+    uint64_t reg = (gpio_reg_load(&dev->enable) & bit) ? gpio_reg_load(&dev->out) : gpio_reg_load(&dev->in);
+    return (uint32_t)((reg >> gpio_num) & 1U);
+}
+
+// Toggle GPIO output level
+void gpio_dev_toggle_level(gpio_device_t *dev, uint32_t gpio_num) {
+    if (!gpio_check_output(dev, gpio_num)) {
+        return;
+    }
+    
+    uint64_t old_out = gpio_reg_xor(&dev->out, GPIO_PIN_SEL(gpio_num));
+    uint64_t out = old_out ^ GPIO_PIN_SEL(gpio_num);
+    gpio_out_changed(dev, old_out, out);
+    
+    SIM_LOGI(GPIO, SIM_EVT_GPIO_TOGGLE, gpio_num,
+             (out >> gpio_num) & 1U, NULL);
+}
+
+// Drive every output pin in the mask HIGH
+void gpio_dev_set_mask(gpio_device_t *dev, uint64_t mask) {
+    mask = gpio_check_output_mask(dev, mask, "gpio_set_mask");
+    uint64_t old_out = gpio_reg_or(&dev->out, mask);
+    gpio_out_changed(dev, old_out, old_out | mask);
+    SIM_LOGI(GPIO, SIM_EVT_GPIO_SET_MASK, 0, mask, NULL);
+}
+
+// Drive every output pin in the mask LOW
+void gpio_dev_clear_mask(gpio_device_t *dev, uint64_t mask) {
+    mask = gpio_check_output_mask(dev, mask, "gpio_clear_mask");
+    uint64_t old_out = gpio_reg_and(&dev->out, ~mask);
+    gpio_out_changed(dev, old_out, old_out & ~mask);
+    SIM_LOGI(GPIO, SIM_EVT_GPIO_CLEAR_MASK, 0, mask, NULL);
+}
+
+// Invert every output pin in the mask
+void gpio_dev_toggle_mask(gpio_device_t *dev, uint64_t mask) {
+    mask = gpio_check_output_mask(dev, mask, "gpio_toggle_mask");
+    uint64_t old_out = gpio_reg_xor(&dev->out, mask);
+    gpio_out_changed(dev, old_out, old_out ^ mask);
+    SIM_LOGI(GPIO, SIM_EVT_GPIO_TOGGLE_MASK, 0, mask, NULL);
+}
+
+// Drive every output pin in the mask to the matching bit of 'levels' in
+// one OUT register update
+void gpio_dev_write_mask(gpio_device_t *dev, uint64_t mask, uint64_t levels) {
+    mask = gpio_check_output_mask(dev, mask, "gpio_write_mask");
+    uint64_t old_out = gpio_reg_load(&dev->out);
+    uint64_t new_out;
+    do {
+        new_out = (old_out & ~mask) | (levels & mask);
+    } while (new_out != old_out &&
+             !__atomic_compare_exchange_n(&dev->out, &old_out, new_out, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    gpio_out_changed(dev, old_out, new_out);
+    SIM_LOGI(GPIO, SIM_EVT_GPIO_WRITE_MASK, 0, mask, NULL);
+}
+
+// Replace the register bits of sourced pins with their computed levels
+static uint64_t gpio_apply_sources(const gpio_device_t *dev, uint64_t levels, uint64_t sourced) {
+    while (sourced) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(sourced);
+        sourced &= sourced - 1;
+        levels &= ~GPIO_PIN_SEL(pin);
+        if (dev->sources[pin].fn(dev->sources[pin].arg, pin)) {
+            levels |= GPIO_PIN_SEL(pin);
+        }
+    }
+    return levels;
+}
+
+// Read the level of every configured pin in one access
+// Input pins report the IN register, output pins the OUT register. All
+// inputs come from one atomic load, so the snapshot is consistent even
+// while stimulus threads are driving them.
+uint64_t gpio_dev_read_all(gpio_device_t *dev) {
+    uint64_t enable = gpio_reg_load(&dev->enable);
+    uint64_t levels = (gpio_reg_load(&dev->in) & ~enable) | (gpio_reg_load(&dev->out) & enable);
+    uint64_t sourced = gpio_reg_load(&dev->sourced);
+    if (sourced) {
+        levels = gpio_apply_sources(dev, levels, sourced);
     }
+    return levels & gpio_reg_load(&dev->configured);
+}
+
+// Print one pin line of the status dump
+static void gpio_print_pin(const gpio_device_t *dev, const char *name, uint32_t pin, uint64_t reg,
+                           const char *high, const char *low) {
+    printf("  %s (Pin %d): %s\n", name, pin,
+           (gpio_reg_load(&dev->configured) & GPIO_PIN_SEL(pin)) ?
+           ((reg & GPIO_PIN_SEL(pin)) ? high : low) : "NOT_INIT");
+}
+
+// Print current GPIO status (for debugging)
+void gpio_dev_print_status(gpio_device_t *dev) {
+    sim_log_flush();
+    printf("\n=== GPIO Status ===\n");
+    printf("LEDs:\n");
+    uint64_t out = gpio_reg_load(&dev->out);
+#define GPIO_PRINT_LED(n, name, pin) gpio_print_pin(dev, #name, (pin), out, "ON", "OFF");
+    BOARD_LEDS(GPIO_PRINT_LED)
     
-    if (!gpio_registers.initialized[gpio_num]) {
-        printf("[GPIO ERROR] GPIO pin %d not initialized\n", gpio_num);
-        return 0;
+    printf("Buttons:\n");
+    uint64_t in = gpio_reg_load(&dev->in);
+#define GPIO_PRINT_BUTTON(n, name, pin, led) gpio_print_pin(dev, #name, (pin), in, "RELEASED", "PRESSED");
+    BOARD_BUTTONS(GPIO_PRINT_BUTTON)
+    printf("==================\n\n");
+}
+
+// Enable interrupt dispatch on a board
+void gpio_dev_install_isr_service(gpio_device_t *dev) {
+    __atomic_store_n(&dev->isr_service, true, __ATOMIC_RELEASE);
+}
+
+// Select the edges on which a pin raises its interrupt
+bool gpio_dev_set_intr_type(gpio_device_t *dev, uint32_t gpio_num, gpio_int_type_t intr_type) {
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, gpio_num, 0, NULL);
+        return false;
     }
     
-    if (gpio_registers.mode[gpio_num] == GPIO_MODE_INPUT) {
-        return gpio_registers.input_level[gpio_num];
+    uint64_t bit = GPIO_PIN_SEL(gpio_num);
+    if (intr_type & GPIO_INTR_POSEDGE) {
+        gpio_reg_or(&dev->intr_posedge, bit);
+    } else {
+        gpio_reg_and(&dev->intr_posedge, ~bit);
+    }
+    if (intr_type & GPIO_INTR_NEGEDGE) {
+        gpio_reg_or(&dev->intr_negedge, bit);
     } else {
-        // For output pins, return the output level
-        return gpio_registers.output_level[gpio_num];
+        gpio_reg_and(&dev->intr_negedge, ~bit);
     }
+    SIM_LOGD(GPIO, SIM_EVT_GPIO_INTR_TYPE, gpio_num, intr_type, NULL);
+    return true;
 }
 
-// Toggle GPIO output level
-void gpio_toggle_level(uint32_t gpio_num) {
+// Attach the interrupt handler of a pin; requires the ISR service
+bool gpio_dev_isr_handler_add(gpio_device_t *dev, uint32_t gpio_num, gpio_isr_t isr_handler, void *args) {
     if (!GPIO_IS_VALID_GPIO(gpio_num)) {
-        printf("[GPIO ERROR] Invalid GPIO pin: %d\n", gpio_num);
-        return;
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, gpio_num, 0, NULL);
+        return false;
+    }
+    if (!__atomic_load_n(&dev->isr_service, __ATOMIC_ACQUIRE)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_NO_ISR_SERVICE, gpio_num, 0, NULL);
+        return false;
     }
     
-    if (!gpio_registers.initialized[gpio_num]) {
-        printf("[GPIO ERROR] GPIO pin %d not initialized\n", gpio_num);
-        return;
+    // Publish the argument before the handler that uses it
+    __atomic_store_n(&dev->isr_args[gpio_num], args, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->isr_handlers[gpio_num], isr_handler, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Detach the interrupt handler of a pin
+bool gpio_dev_isr_handler_remove(gpio_device_t *dev, uint32_t gpio_num) {
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, gpio_num, 0, NULL);
+        return false;
     }
     
-    if (gpio_registers.mode[gpio_num] != GPIO_MODE_OUTPUT) {
-        printf("[GPIO ERROR] GPIO pin %d not configured as output\n", gpio_num);
+    __atomic_store_n(&dev->isr_handlers[gpio_num], NULL, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Run the handlers of pins whose level change matches their trigger
+// Runs on the thread that drove the inputs.
+static void gpio_raise_edges(gpio_device_t *dev, uint64_t old_in, uint64_t new_in) {
+    if (!__atomic_load_n(&dev->isr_service, __ATOMIC_ACQUIRE)) {
         return;
     }
     
-    gpio_registers.output_level[gpio_num] = 
-        (gpio_registers.output_level[gpio_num] == GPIO_LEVEL_HIGH) ? 
-        GPIO_LEVEL_LOW : GPIO_LEVEL_HIGH;
+    uint64_t changed = old_in ^ new_in;
+    uint64_t fire = (changed & new_in & gpio_reg_load(&dev->intr_posedge)) |
+                    (changed & ~new_in & gpio_reg_load(&dev->intr_negedge));
+    while (fire) {
+        int pin = __builtin_ctzll(fire);
+        fire &= fire - 1;
+        
+        gpio_isr_t handler = __atomic_load_n(&dev->isr_handlers[pin], __ATOMIC_ACQUIRE);
+        if (handler) {
+            handler(__atomic_load_n(&dev->isr_args[pin], __ATOMIC_ACQUIRE));
+        }
+    }
+}
+
+// Drive the input level of every pin in the mask to the matching bit of
+// 'levels' and raise the resulting edges; safe from any thread
+// Returns the pins whose level changed.
+uint64_t gpio_dev_drive_inputs(gpio_device_t *dev, uint64_t mask, uint64_t levels) {
+    mask &= GPIO_VALID_MASK;
+    uint64_t old_in = gpio_reg_load(&dev->in);
+    uint64_t new_in;
+    do {
+        new_in = (old_in & ~mask) | (levels & mask);
+    } while (new_in != old_in &&
+             !__atomic_compare_exchange_n(&dev->in, &old_in, new_in, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
     
-    printf("[GPIO] Pin %d toggled to %s\n", 
-           gpio_num, 
-           (gpio_registers.output_level[gpio_num] == GPIO_LEVEL_HIGH) ? "HIGH" : "LOW");
+    uint64_t changed = old_in ^ new_in;
+    if (changed) {
+        // Only input pins show the IN register
+        uint64_t visible = changed & gpio_reg_load(&dev->configured) & ~gpio_reg_load(&dev->enable);
+        if (visible && __atomic_load_n(&dev->num_watches, __ATOMIC_ACQUIRE)) {
+            gpio_notify_watches(dev, visible, new_in);
+        }
+        gpio_raise_edges(dev, old_in, new_in);
+    }
+    return changed;
 }
 
-// Print current GPIO status (for debugging)
-void gpio_print_status(void) {
-    printf("\n=== GPIO Status ===\n");
-    printf("LEDs:\n");
-    printf("  LED1 (Pin %d): %s\n", GPIO_NUM_2, 
-           gpio_registers.initialized[GPIO_NUM_2] ? 
-           (gpio_registers.output_level[GPIO_NUM_2] ? "ON" : "OFF") : "NOT_INIT");
-    printf("  LED2 (Pin %d): %s\n", GPIO_NUM_4, 
-           gpio_registers.initialized[GPIO_NUM_4] ? 
-           (gpio_registers.output_level[GPIO_NUM_4] ? "ON" : "OFF") : "NOT_INIT");
-    printf("  LED3 (Pin %d): %s\n", GPIO_NUM_5, 
-           gpio_registers.initialized[GPIO_NUM_5] ? 
-           (gpio_registers.output_level[GPIO_NUM_5] ? "ON" : "OFF") : "NOT_INIT");
+// Peripheral output: drive the OUT bit of every output pin in the mask
+// to the matching bit of 'levels' without logging, as a PWM or other
+// on-chip peripheral routed to the pins would. Returns the pins whose
+// level changed; watches see them like any other OUT write.
+uint64_t gpio_dev_drive_outputs(gpio_device_t *dev, uint64_t mask, uint64_t levels) {
+    mask &= gpio_output_pins(dev);
+    uint64_t old_out = gpio_reg_load(&dev->out);
+    uint64_t new_out;
+    do {
+        new_out = (old_out & ~mask) | (levels & mask);
+    } while (new_out != old_out &&
+             !__atomic_compare_exchange_n(&dev->out, &old_out, new_out, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
     
-    printf("Buttons:\n");
-    printf("  BTN1 (Pin %d): %s\n", GPIO_NUM_18, 
-           gpio_registers.initialized[GPIO_NUM_18] ? 
-           (gpio_registers.input_level[GPIO_NUM_18] ? "RELEASED" : "PRESSED") : "NOT_INIT");
-    printf("  BTN2 (Pin %d): %s\n", GPIO_NUM_19, 
-           gpio_registers.initialized[GPIO_NUM_19] ? 
-           (gpio_registers.input_level[GPIO_NUM_19] ? "RELEASED" : "PRESSED") : "NOT_INIT");
-    printf("  BTN3 (Pin %d): %s\n", GPIO_NUM_21, 
-           gpio_registers.initialized[GPIO_NUM_21] ? 
-           (gpio_registers.input_level[GPIO_NUM_21] ? "RELEASED" : "PRESSED") : "NOT_INIT");
-    printf("==================\n\n");
+    gpio_out_changed(dev, old_out, new_out);
+    return old_out ^ new_out;
+}
+
+// Observe level changes of the pins in 'mask'
+// Output pins report OUT writes, input pins gpio_dev_drive_inputs(); the
+// callback runs on the writing thread. Add watches before other threads
+// drive the board.
+bool gpio_dev_add_watch(gpio_device_t *dev, uint64_t mask, gpio_watch_t fn, void *arg) {
+    uint32_t slot = 0;
+    while (slot < dev->num_watches && dev->watches[slot].fn) {
+        slot++;
+    }
+    if (slot >= GPIO_MAX_WATCHES) {
+        return false;
+    }
+    
+    dev->watches[slot].mask = mask & GPIO_VALID_MASK;
+    dev->watches[slot].arg = arg;
+    __atomic_store_n(&dev->watches[slot].fn, fn, __ATOMIC_RELEASE);
+    if (slot == dev->num_watches) {
+        __atomic_store_n(&dev->num_watches, slot + 1, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+// Stop a watch added with the same callback and argument
+void gpio_dev_remove_watch(gpio_device_t *dev, gpio_watch_t fn, void *arg) {
+    for (uint32_t i = 0; i < dev->num_watches; i++) {
+        if (dev->watches[i].fn == fn && dev->watches[i].arg == arg) {
+            __atomic_store_n(&dev->watches[i].fn, NULL, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+// Compute the level of a pin on every read instead of taking it from OUT
+// (outputs) or IN (inputs); a NULL 'fn' returns the pin to its register.
+// Register writes still reach watches and raise interrupts, so a source
+// that wants its edges observed writes them as well. Sources run on the
+// reading thread.
+bool gpio_dev_set_level_source(gpio_device_t *dev, uint32_t gpio_num, gpio_level_source_t fn, void *arg) {
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_INVALID_PIN, gpio_num, 0, NULL);
+        return false;
+    }
+    
+    if (!fn) {
+        gpio_reg_and(&dev->sourced, ~GPIO_PIN_SEL(gpio_num));
+    }
+    dev->sources[gpio_num].fn = fn;
+    dev->sources[gpio_num].arg = arg;
+    if (fn) {
+        gpio_reg_or(&dev->sourced, GPIO_PIN_SEL(gpio_num));
+    }
+    return true;
+}
+
+// Route simulated button transitions through an input model; a NULL 'fn'
+// gives clean edges again. Use from the application thread.
+void gpio_dev_set_input_model(gpio_device_t *dev, gpio_input_model_t fn, void *arg) {
+    dev->input_model.fn = fn;
+    dev->input_model.arg = arg;
+}
+
+// Check whether edges of a pin reach anyone: an armed interrupt or a
+// watch covering it
+bool gpio_dev_is_observed(gpio_device_t *dev, uint32_t gpio_num) {
+    uint64_t bit = GPIO_PIN_SEL(gpio_num);
+    if (__atomic_load_n(&dev->isr_service, __ATOMIC_ACQUIRE) &&
+        ((gpio_reg_load(&dev->intr_posedge) | gpio_reg_load(&dev->intr_negedge)) & bit)) {
+        return true;
+    }
+    uint32_t count = __atomic_load_n(&dev->num_watches, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < count; i++) {
+        if (__atomic_load_n(&dev->watches[i].fn, __ATOMIC_ACQUIRE) && (dev->watches[i].mask & bit)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Drive a simulated button transition, through the input model if any
+static void gpio_simulate_button(gpio_device_t *dev, uint32_t gpio_num, uint32_t level) {
+    if (!dev->input_model.fn || !dev->input_model.fn(dev->input_model.arg, gpio_num, level)) {
+        gpio_dev_drive_inputs(dev, GPIO_PIN_SEL(gpio_num), level ? GPIO_PIN_SEL(gpio_num) : 0);
+    }
+}
+
+// Check whether a pin can be driven by a simulated button: a default
+// board button or any configured input
+static bool gpio_is_button_input(const gpio_device_t *dev, uint32_t gpio_num) {
+    if (board_button_index(gpio_num) >= 0) {
+        return true;
+    }
+    return GPIO_IS_VALID_GPIO(gpio_num) &&
+           (gpio_reg_load(&dev->configured) & ~gpio_reg_load(&dev->enable) & GPIO_PIN_SEL(gpio_num)) != 0;
 }
 
 // Simulate button press (for testing purposes)
-void gpio_simulate_button_press(uint32_t gpio_num) {
-    if (gpio_num == GPIO_NUM_18 || gpio_num == GPIO_NUM_19 || gpio_num == GPIO_NUM_21) {
-        gpio_registers.input_level[gpio_num] = GPIO_LEVEL_LOW;
-        printf("[SIMULATION] Button on pin %d pressed\n", gpio_num);
+void gpio_dev_simulate_button_press(gpio_device_t *dev, uint32_t gpio_num) {
+    if (gpio_is_button_input(dev, gpio_num)) {
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_PRESS, gpio_num, 0, NULL);
+        gpio_simulate_button(dev, gpio_num, GPIO_LEVEL_LOW);
     }
 }
 
 // Simulate button release (for testing purposes)
-void gpio_simulate_button_release(uint32_t gpio_num) {
-    if (gpio_num == GPIO_NUM_18 || gpio_num == GPIO_NUM_19 || gpio_num == GPIO_NUM_21) {
-        gpio_registers.input_level[gpio_num] = GPIO_LEVEL_HIGH;
-        printf("[SIMULATION] Button on pin %d released\n", gpio_num);
+void gpio_dev_simulate_button_release(gpio_device_t *dev, uint32_t gpio_num) {
+    if (gpio_is_button_input(dev, gpio_num)) {
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_RELEASE, gpio_num, 0, NULL);
+        gpio_simulate_button(dev, gpio_num, GPIO_LEVEL_HIGH);
     }
-}
\ No newline at end of file
+}
+
+// Copy the register contents of a board
+void gpio_dev_save_regs(gpio_device_t *dev, gpio_regs_t *regs) {
+    regs->out = gpio_reg_load(&dev->out);
+    regs->in = gpio_reg_load(&dev->in);
+    regs->enable = gpio_reg_load(&dev->enable);
+    regs->pullup = gpio_reg_load(&dev->pullup);
+    regs->configured = gpio_reg_load(&dev->configured);
+    regs->intr_posedge = gpio_reg_load(&dev->intr_posedge);
+    regs->intr_negedge = gpio_reg_load(&dev->intr_negedge);
+    regs->isr_service = __atomic_load_n(&dev->isr_service, __ATOMIC_ACQUIRE);
+}
+
+// Pin levels as held by the registers, leaving out sourced pins
+static inline uint64_t gpio_reg_levels(const gpio_device_t *dev) {
+    uint64_t enable = gpio_reg_load(&dev->enable);
+    uint64_t levels = (gpio_reg_load(&dev->in) & ~enable) | (gpio_reg_load(&dev->out) & enable);
+    return levels & gpio_reg_load(&dev->configured) & ~gpio_reg_load(&dev->sourced);
+}
+
+// Overwrite the register contents of a board, e.g. from a snapshot
+// Watches see the pins whose level changed; interrupt handlers do not
+// run, since no input was driven. Use from the application thread while
+// no stimulus is running.
+void gpio_dev_load_regs(gpio_device_t *dev, const gpio_regs_t *regs) {
+    uint64_t old_levels = gpio_reg_levels(dev);
+    
+    __atomic_store_n(&dev->out, regs->out & GPIO_VALID_MASK, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->in, regs->in & GPIO_VALID_MASK, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->enable, regs->enable & GPIO_VALID_MASK, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->pullup, regs->pullup & GPIO_VALID_MASK, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->configured, regs->configured & GPIO_VALID_MASK, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->intr_posedge, regs->intr_posedge & GPIO_VALID_MASK, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->intr_negedge, regs->intr_negedge & GPIO_VALID_MASK, __ATOMIC_RELEASE);
+    __atomic_store_n(&dev->isr_service, regs->isr_service != 0, __ATOMIC_RELEASE);
+    
+    uint64_t levels = gpio_reg_levels(dev);
+    uint64_t changed = old_levels ^ levels;
+    if (changed && __atomic_load_n(&dev->num_watches, __ATOMIC_ACQUIRE)) {
+        gpio_notify_watches(dev, changed, levels);
+    }
+}
+
+// Default-instance API
+
+// Get the board used by the default-instance functions
+gpio_device_t *gpio_default_device(void) {
+    return &default_device;
+}
+
+void gpio_mock_init(void) {
+    gpio_dev_init(&default_device);
+}
+
+void gpio_config_pin(gpio_config_t *gpio_conf) {
+    gpio_dev_config_pin(&default_device, gpio_conf);
+}
+
+void gpio_set_level(uint32_t gpio_num, uint32_t level) {
+    gpio_dev_set_level(&default_device, gpio_num, level);
+}
+
+uint32_t gpio_get_level(uint32_t gpio_num) {
+    return gpio_dev_get_level(&default_device, gpio_num);
+}
+
+void gpio_toggle_level(uint32_t gpio_num) {
+    gpio_dev_toggle_level(&default_device, gpio_num);
+}
+
+void gpio_print_status(void) {
+    gpio_dev_print_status(&default_device);
+}
+
+void gpio_set_mask(uint64_t mask) {
+    gpio_dev_set_mask(&default_device, mask);
+}
+
+void gpio_clear_mask(uint64_t mask) {
+    gpio_dev_clear_mask(&default_device, mask);
+}
+
+void gpio_toggle_mask(uint64_t mask) {
+    gpio_dev_toggle_mask(&default_device, mask);
+}
+
+void gpio_write_mask(uint64_t mask, uint64_t levels) {
+    gpio_dev_write_mask(&default_device, mask, levels);
+}
+
+uint64_t gpio_read_all(void) {
+    return gpio_dev_read_all(&default_device);
+}
+
+void gpio_simulate_button_press(uint32_t gpio_num) {
+    gpio_dev_simulate_button_press(&default_device, gpio_num);
+}
+
+void gpio_simulate_button_release(uint32_t gpio_num) {
+    gpio_dev_simulate_button_release(&default_device, gpio_num);
+}
+
+void gpio_install_isr_service(void) {
+    gpio_dev_install_isr_service(&default_device);
+}
+
+bool gpio_set_intr_type(uint32_t gpio_num, gpio_int_type_t intr_type) {
+    return gpio_dev_set_intr_type(&default_device, gpio_num, intr_type);
+}
+
+bool gpio_isr_handler_add(uint32_t gpio_num, gpio_isr_t isr_handler, void *args) {
+    return gpio_dev_isr_handler_add(&default_device, gpio_num, isr_handler, args);
+}
+
+bool gpio_isr_handler_remove(uint32_t gpio_num) {
+    return gpio_dev_isr_handler_remove(&default_device, gpio_num);
+}
@@ -0,0 +1,275 @@
+#include "gpio_shm.h"
+#include "sim_log.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+// Without futexes the drive thread polls at this interval
+#define GPIO_SHM_POLL_NS 1000000
+
+// Relaxed atomic accessors for the shared words; ordering comes from the
+// sequence counter
+#define SHM_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define SHM_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+
+// Sleep until *addr may no longer hold 'val'
+static void gpio_shm_wait(uint32_t *addr, uint32_t val) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+#else
+    (void)addr;
+    (void)val;
+    struct timespec ts = {0, GPIO_SHM_POLL_NS};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// Wake one process sleeping on *addr
+static void gpio_shm_wake(uint32_t *addr) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+
+// Copy the board registers into the segment under the sequence counter
+static void gpio_shm_publish(gpio_shm_t *gs) {
+    gpio_shm_layout_t *shm = gs->shm;
+    gpio_device_t *dev = gs->gpio;
+    
+    pthread_mutex_lock(&gs->lock);
+    uint64_t seq = SHM_LOAD(&shm->seq);
+    SHM_STORE(&shm->seq, seq + 1);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    SHM_STORE(&shm->time_ns, sim_clock_now(gs->clock));
+    SHM_STORE(&shm->updates, SHM_LOAD(&shm->updates) + 1);
+    SHM_STORE(&shm->out, __atomic_load_n(&dev->out, __ATOMIC_ACQUIRE));
+    SHM_STORE(&shm->in, __atomic_load_n(&dev->in, __ATOMIC_ACQUIRE));
+    SHM_STORE(&shm->enable, __atomic_load_n(&dev->enable, __ATOMIC_ACQUIRE));
+    SHM_STORE(&shm->pullup, __atomic_load_n(&dev->pullup, __ATOMIC_ACQUIRE));
+    SHM_STORE(&shm->configured, __atomic_load_n(&dev->configured, __ATOMIC_ACQUIRE));
+    
+    __atomic_store_n(&shm->seq, seq + 2, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&gs->lock);
+}
+
+// Watch callback: republish after every level change
+static void gpio_shm_on_change(void *arg, uint64_t changed, uint64_t levels) {
+    (void)changed;
+    (void)levels;
+    gpio_shm_publish(arg);
+}
+
+// Apply the current drive request to the input pins
+static void gpio_shm_apply(gpio_shm_t *gs) {
+    gpio_shm_layout_t *shm = gs->shm;
+    uint64_t inputs = __atomic_load_n(&gs->gpio->configured, __ATOMIC_ACQUIRE) &
+                      ~__atomic_load_n(&gs->gpio->enable, __ATOMIC_ACQUIRE);
+    uint64_t mask = __atomic_load_n(&shm->drive_mask, __ATOMIC_ACQUIRE) & inputs;
+    uint64_t levels = __atomic_load_n(&shm->drive_levels, __ATOMIC_ACQUIRE);
+    
+    __atomic_fetch_add(&shm->drives, 1, __ATOMIC_RELAXED);
+    if (mask && gpio_dev_drive_inputs(gs->gpio, mask, levels) && gs->notify) {
+        gs->notify();
+    }
+}
+
+// Drive thread: apply each request, sleeping on drive_seq in between
+static void *gpio_shm_thread(void *arg) {
+    gpio_shm_t *gs = arg;
+    gpio_shm_layout_t *shm = gs->shm;
+    uint32_t seen = __atomic_load_n(&shm->drive_seq, __ATOMIC_ACQUIRE);
+    
+    // Requests made before the simulator started
+    gpio_shm_apply(gs);
+    
+    while (!__atomic_load_n(&gs->stop, __ATOMIC_ACQUIRE)) {
+        uint32_t seq = __atomic_load_n(&shm->drive_seq, __ATOMIC_ACQUIRE);
+        if (seq != seen) {
+            seen = seq;
+            gpio_shm_apply(gs);
+            continue;
+        }
+        
+        // Announce the sleep before the final check, so a writer either
+        // sees the flag or its increment is seen here
+        __atomic_store_n(&shm->drive_waiters, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&shm->drive_seq, __ATOMIC_SEQ_CST) == seen &&
+            !__atomic_load_n(&gs->stop, __ATOMIC_ACQUIRE)) {
+            gpio_shm_wait(&shm->drive_seq, seen);
+        }
+        __atomic_store_n(&shm->drive_waiters, 0, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Create (or reset) the segment 'name' for a board; it is published
+// from gpio_shm_start() on
+bool gpio_shm_create(gpio_shm_t *gs, const char *name, gpio_device_t *gpio, sim_clock_t *clock) {
+    memset(gs, 0, sizeof(*gs));
+    gs->gpio = gpio;
+    gs->clock = clock;
+    gs->name = name;
+    gs->fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (gs->fd < 0) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SHM_ERR, 0, (uint64_t)errno, name);
+        return false;
+    }
+    
+    // Truncating first clears a segment left behind by an earlier run
+    void *map = MAP_FAILED;
+    if (ftruncate(gs->fd, 0) == 0 && ftruncate(gs->fd, sizeof(gpio_shm_layout_t)) == 0) {
+        map = mmap(NULL, sizeof(gpio_shm_layout_t), PROT_READ | PROT_WRITE, MAP_SHARED, gs->fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SHM_ERR, 0, (uint64_t)errno, name);
+        close(gs->fd);
+        shm_unlink(name);
+        gs->fd = -1;
+        return false;
+    }
+    
+    gs->shm = map;
+    gs->shm->version = GPIO_SHM_VERSION;
+    gs->shm->size = sizeof(gpio_shm_layout_t);
+    gs->shm->num_pins = GPIO_NUM_MAX;
+    pthread_mutex_init(&gs->lock, NULL);
+    gpio_shm_publish(gs);
+    
+    // Clients check the magic last
+    __atomic_store_n(&gs->shm->magic, GPIO_SHM_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Publish every level change and start taking drive requests
+// Call before other threads drive the board.
+bool gpio_shm_start(gpio_shm_t *gs, gpio_shm_notify_t notify) {
+    if (gs->fd < 0 || gs->started) {
+        return false;
+    }
+    gs->notify = notify;
+    
+    if (!gpio_dev_add_watch(gs->gpio, ~0ULL, gpio_shm_on_change, gs)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SHM_ERR, 0, 0, gs->name);
+        return false;
+    }
+    gpio_shm_publish(gs);
+    
+    // Signals stay with the application thread
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int rc = pthread_create(&gs->thread, NULL, gpio_shm_thread, gs);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (rc != 0) {
+        gpio_dev_remove_watch(gs->gpio, gpio_shm_on_change, gs);
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SHM_ERR, 0, (uint64_t)rc, gs->name);
+        return false;
+    }
+    
+    gs->started = true;
+    SIM_LOGI(SIMULATION, SIM_EVT_SIM_SHM_OPEN, 0, sizeof(gpio_shm_layout_t), gs->name);
+    return true;
+}
+
+// Stop publishing, unmap the segment and remove its name
+void gpio_shm_close(gpio_shm_t *gs) {
+    if (gs->fd < 0) {
+        return;
+    }
+    
+    if (gs->started) {
+        __atomic_store_n(&gs->stop, true, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&gs->shm->drive_seq, 1, __ATOMIC_SEQ_CST);
+        gpio_shm_wake(&gs->shm->drive_seq);
+        pthread_join(gs->thread, NULL);
+        gpio_dev_remove_watch(gs->gpio, gpio_shm_on_change, gs);
+        gpio_shm_publish(gs);
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_SHM_DONE, 0, SHM_LOAD(&gs->shm->updates), gs->name);
+    }
+    
+    munmap(gs->shm, sizeof(gpio_shm_layout_t));
+    close(gs->fd);
+    shm_unlink(gs->name);
+    pthread_mutex_destroy(&gs->lock);
+    gs->shm = NULL;
+    gs->fd = -1;
+    gs->started = false;
+}
+
+// Client: map the segment of a running simulator, NULL if there is none
+// or its layout is not this one
+gpio_shm_layout_t *gpio_shm_attach(const char *name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(gpio_shm_layout_t)) {
+        map = mmap(NULL, sizeof(gpio_shm_layout_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    
+    gpio_shm_layout_t *shm = map;
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != GPIO_SHM_MAGIC ||
+        shm->version != GPIO_SHM_VERSION || shm->size < sizeof(gpio_shm_layout_t)) {
+        munmap(map, sizeof(gpio_shm_layout_t));
+        return NULL;
+    }
+    return shm;
+}
+
+// Client: unmap a segment
+void gpio_shm_detach(gpio_shm_layout_t *shm) {
+    munmap(shm, sizeof(gpio_shm_layout_t));
+}
+
+// Client: take a consistent snapshot of the board state
+void gpio_shm_read(const gpio_shm_layout_t *shm, gpio_shm_snapshot_t *snap) {
+    uint64_t seq;
+    do {
+        while ((seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE)) & 1) {
+        }
+        snap->time_ns = SHM_LOAD(&shm->time_ns);
+        snap->updates = SHM_LOAD(&shm->updates);
+        snap->out = SHM_LOAD(&shm->out);
+        snap->in = SHM_LOAD(&shm->in);
+        snap->enable = SHM_LOAD(&shm->enable);
+        snap->pullup = SHM_LOAD(&shm->pullup);
+        snap->configured = SHM_LOAD(&shm->configured);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (SHM_LOAD(&shm->seq) != seq);
+}
+
+// Client: drive the input pins in 'mask' to the matching bits of
+// 'levels'; only wakes the simulator with a system call if it sleeps
+void gpio_shm_drive(gpio_shm_layout_t *shm, uint64_t mask, uint64_t levels) {
+    uint64_t old = __atomic_load_n(&shm->drive_levels, __ATOMIC_RELAXED);
+    uint64_t want;
+    do {
+        want = (old & ~mask) | (levels & mask);
+    } while (!__atomic_compare_exchange_n(&shm->drive_levels, &old, want, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    __atomic_fetch_or(&shm->drive_mask, mask, __ATOMIC_RELEASE);
+    
+    __atomic_fetch_add(&shm->drive_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&shm->drive_waiters, __ATOMIC_SEQ_CST)) {
+        gpio_shm_wake(&shm->drive_seq);
+    }
+}
@@ -0,0 +1,224 @@
+#include "latency.h"
+#include "sim_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bucket holding a value
+static inline size_t latency_hist_index(uint64_t value_ns) {
+    if (value_ns < LATENCY_HIST_SUB_COUNT) {
+        return (size_t)value_ns;
+    }
+    
+    uint32_t msb = 63u - (uint32_t)__builtin_clzll(value_ns);
+    if (msb >= LATENCY_HIST_MAX_BITS) {
+        return LATENCY_HIST_BUCKETS - 1;
+    }
+    
+    // value >> shift lands in [HALF_COUNT, SUB_COUNT)
+    uint32_t shift = msb - (LATENCY_HIST_SUB_BITS - 1);
+    return LATENCY_HIST_SUB_COUNT + (size_t)(shift - 1) * LATENCY_HIST_HALF_COUNT +
+           (size_t)((value_ns >> shift) - LATENCY_HIST_HALF_COUNT);
+}
+
+// Largest value that falls into a bucket
+static uint64_t latency_hist_bucket_high(size_t index) {
+    if (index < LATENCY_HIST_SUB_COUNT) {
+        return index;
+    }
+    
+    size_t offset = index - LATENCY_HIST_SUB_COUNT;
+    uint32_t shift = (uint32_t)(offset / LATENCY_HIST_HALF_COUNT) + 1;
+    uint64_t sub = offset % LATENCY_HIST_HALF_COUNT + LATENCY_HIST_HALF_COUNT;
+    return (sub << shift) + ((1ULL << shift) - 1);
+}
+
+// Clear a histogram
+void latency_hist_reset(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+    hist->min_ns = UINT64_MAX;
+}
+
+// Record one latency
+void latency_hist_record(latency_hist_t *hist, uint64_t value_ns) {
+    hist->counts[latency_hist_index(value_ns)]++;
+    hist->count++;
+    hist->sum_ns += value_ns;
+    if (value_ns < hist->min_ns) {
+        hist->min_ns = value_ns;
+    }
+    if (value_ns > hist->max_ns) {
+        hist->max_ns = value_ns;
+    }
+}
+
+// Value below which 'percentile' percent of the recorded values fall,
+// to bucket precision; 0 for an empty histogram
+uint64_t latency_hist_percentile(const latency_hist_t *hist, double percentile) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)hist->count + 0.999999);
+    if (target < 1) {
+        target = 1;
+    }
+    if (target > hist->count) {
+        target = hist->count;
+    }
+    
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= target) {
+            uint64_t value = latency_hist_bucket_high(i);
+            if (value > hist->max_ns) {
+                value = hist->max_ns;
+            }
+            if (value < hist->min_ns) {
+                value = hist->min_ns;
+            }
+            return value;
+        }
+    }
+    return hist->max_ns;
+}
+
+// Watch callback: start measurements on press edges, finish them when
+// the output changes. Input edges may arrive from stimulus threads;
+// output changes come from the application thread.
+static void latency_on_change(void *arg, uint64_t changed, uint64_t levels) {
+    latency_tracker_t *tracker = arg;
+    uint64_t now = sim_clock_now(tracker->clock);
+    
+    uint64_t inputs = changed & tracker->in_mask;
+    while (inputs) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(inputs);
+        inputs &= inputs - 1;
+        latency_pair_t *pair = &tracker->pairs[tracker->in_index[pin]];
+        
+        if ((levels >> pin) & 1) {
+            // Released before the output reacted: nothing to measure
+            __atomic_store_n(&pair->press_ns, 0, __ATOMIC_RELAXED);
+        } else {
+            // Start timing unless a press is already pending
+            uint64_t none = 0;
+            __atomic_compare_exchange_n(&pair->press_ns, &none, now + 1, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+    }
+    
+    uint64_t outputs = changed & tracker->out_mask;
+    while (outputs) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(outputs);
+        outputs &= outputs - 1;
+        latency_pair_t *pair = &tracker->pairs[tracker->out_index[pin]];
+        
+        uint64_t press = __atomic_exchange_n(&pair->press_ns, 0, __ATOMIC_RELAXED);
+        if (press) {
+            latency_hist_record(pair->hist, now + 1 - press);
+        }
+    }
+}
+
+// Initialize an empty tracker for a board
+void latency_tracker_init(latency_tracker_t *tracker, gpio_device_t *gpio, sim_clock_t *clock) {
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->gpio = gpio;
+    tracker->clock = clock;
+    memset(tracker->in_index, -1, sizeof(tracker->in_index));
+    memset(tracker->out_index, -1, sizeof(tracker->out_index));
+}
+
+// Stop watching and free the histograms
+void latency_tracker_deinit(latency_tracker_t *tracker) {
+    latency_tracker_stop(tracker);
+    for (size_t i = 0; i < tracker->count; i++) {
+        free(tracker->pairs[i].hist);
+    }
+    tracker->count = 0;
+}
+
+// Measure the latency from presses on 'in_pin' to changes of 'out_pin'.
+// Each pin may belong to one pair; add pairs before starting the tracker.
+bool latency_tracker_add(latency_tracker_t *tracker, uint32_t in_pin, uint32_t out_pin,
+                         const char *in_name, const char *out_name) {
+    if (!GPIO_IS_VALID_GPIO(in_pin) || !GPIO_IS_VALID_GPIO(out_pin) || in_pin == out_pin ||
+        tracker->in_index[in_pin] >= 0 || tracker->out_index[out_pin] >= 0 ||
+        tracker->watching) {
+        return false;
+    }
+    
+    latency_hist_t *hist = malloc(sizeof(*hist));
+    if (!hist) {
+        return false;
+    }
+    latency_hist_reset(hist);
+    
+    latency_pair_t *pair = &tracker->pairs[tracker->count];
+    pair->in_pin = in_pin;
+    pair->out_pin = out_pin;
+    pair->in_name = in_name;
+    pair->out_name = out_name;
+    pair->press_ns = 0;
+    pair->hist = hist;
+    
+    tracker->in_index[in_pin] = (int8_t)tracker->count;
+    tracker->out_index[out_pin] = (int8_t)tracker->count;
+    tracker->in_mask |= GPIO_PIN_SEL(in_pin);
+    tracker->out_mask |= GPIO_PIN_SEL(out_pin);
+    tracker->count++;
+    return true;
+}
+
+// Begin observing the board; call before other threads drive it
+bool latency_tracker_start(latency_tracker_t *tracker) {
+    if (tracker->watching) {
+        return true;
+    }
+    tracker->watching = gpio_dev_add_watch(tracker->gpio, tracker->in_mask | tracker->out_mask,
+                                           latency_on_change, tracker);
+    return tracker->watching;
+}
+
+// Stop observing; pending presses are dropped, recorded histograms kept
+void latency_tracker_stop(latency_tracker_t *tracker) {
+    if (tracker->watching) {
+        gpio_dev_remove_watch(tracker->gpio, latency_on_change, tracker);
+        tracker->watching = false;
+    }
+    for (size_t i = 0; i < tracker->count; i++) {
+        __atomic_store_n(&tracker->pairs[i].press_ns, 0, __ATOMIC_RELAXED);
+    }
+}
+
+// Print one line per pair: samples, p50/p99/p999 and max in milliseconds
+void latency_tracker_print(const latency_tracker_t *tracker) {
+    sim_log_flush();
+    printf("\n=== Press-to-LED Latency ===\n");
+    for (size_t i = 0; i < tracker->count; i++) {
+        const latency_pair_t *pair = &tracker->pairs[i];
+        const latency_hist_t *hist = pair->hist;
+        
+        if (hist->count == 0) {
+            printf("  %s -> %s: no samples\n", pair->in_name, pair->out_name);
+            continue;
+        }
+        printf("  %s -> %s: %llu samples, p50 %.3f ms, p99 %.3f ms, p999 %.3f ms, max %.3f ms\n",
+               pair->in_name, pair->out_name, (unsigned long long)hist->count,
+               (double)latency_hist_percentile(hist, 50.0) / SIM_CLOCK_NS_PER_MS,
+               (double)latency_hist_percentile(hist, 99.0) / SIM_CLOCK_NS_PER_MS,
+               (double)latency_hist_percentile(hist, 99.9) / SIM_CLOCK_NS_PER_MS,
+               (double)hist->max_ns / SIM_CLOCK_NS_PER_MS);
+    }
+    printf("============================\n\n");
+}
+
+// Total latencies recorded over every pair
+uint64_t latency_tracker_samples(const latency_tracker_t *tracker) {
+    uint64_t samples = 0;
+    for (size_t i = 0; i < tracker->count; i++) {
+        samples += tracker->pairs[i].hist->count;
+    }
+    return samples;
+}
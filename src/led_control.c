@@ -1,115 +1,510 @@
 #include "led_control.h"
+#include "sim_log.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-// LED array for easy management
-static led_t leds[NUM_LEDS] = {
-    {LED1_PIN, LED_OFF, "LED1"},
-    {LED2_PIN, LED_OFF, "LED2"},
-    {LED3_PIN, LED_OFF, "LED3"}
+// Default board LEDs registered by led_ctrl_init_board()
+#define LED_BOARD_ROW(n, name, pin) {(pin), #name},
+static const struct {
+    uint32_t pin;
+    const char *name;
+} default_leds[NUM_LEDS] = {
+    BOARD_LEDS(LED_BOARD_ROW)
 };
 
-// Initialize all LEDs
-void led_init_all(void) {
-    printf("[LED] Initializing LEDs...\n");
+// Controller used by the default-instance API
+static led_controller_t default_controller;
+
+// O(1) pin-to-LED lookup, NULL if no LED is registered on the pin
+static inline led_t *led_find(const led_controller_t *ctrl, uint32_t led_pin) {
+#ifdef BOARD_FIXED
+    // Board LEDs sit at their row, so a constant pin needs no table
+    int row = board_led_index(led_pin);
+    if (row >= 0 && ctrl->board) {
+        return &ctrl->leds[row];
+    }
+#endif
+    if (led_pin >= GPIO_NUM_MAX || ctrl->pin_index[led_pin] < 0) {
+        return NULL;
+    }
+    return &ctrl->leds[ctrl->pin_index[led_pin]];
+}
+
+// Initialize an empty LED registry on a board
+void led_ctrl_init(led_controller_t *ctrl, gpio_device_t *gpio) {
+    ctrl->gpio = gpio;
+    ctrl->leds = NULL;
+    ctrl->count = 0;
+    ctrl->capacity = 0;
+    ctrl->pin_mask = 0;
+    ctrl->board = false;
+    ctrl->pwm_mask = 0;
+    ctrl->ledc = NULL;
+    ctrl->combine = false;
+    ctrl->shadow = 0;
+    ctrl->dirty = 0;
+    ctrl->combined_writes = 0;
+    ctrl->committed_writes = 0;
+    ctrl->commits = 0;
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        ctrl->pin_index[pin] = -1;
+    }
+}
+
+// Release registry storage
+void led_ctrl_deinit(led_controller_t *ctrl) {
+    free(ctrl->leds);
+    ctrl->leds = NULL;
+    ctrl->count = 0;
+    ctrl->capacity = 0;
+    ctrl->board = false;
+}
+
+// Register an LED on a pin and configure the pin as an output
+// Returns the dense LED index, or -1 on error. 'name' must outlive the controller.
+int led_ctrl_register(led_controller_t *ctrl, uint32_t led_pin, const char *name) {
+    if (!GPIO_IS_VALID_GPIO(led_pin) || ctrl->pin_index[led_pin] >= 0) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_REGISTER, led_pin, 0, NULL);
+        return -1;
+    }
+    
+    if (ctrl->count == ctrl->capacity) {
+        size_t capacity = ctrl->capacity ? ctrl->capacity * 2 : 8;
+        led_t *leds = realloc(ctrl->leds, capacity * sizeof(led_t));
+        if (!leds) {
+            SIM_LOGE(LED, SIM_EVT_LED_ERR_REGISTER, led_pin, 0, NULL);
+            return -1;
+        }
+        ctrl->leds = leds;
+        ctrl->capacity = capacity;
+    }
     
-    // Configure LED pins as outputs
     gpio_config_t led_config = {
-        .pin_bit_mask = GPIO_PIN_SEL(LED1_PIN) | GPIO_PIN_SEL(LED2_PIN) | GPIO_PIN_SEL(LED3_PIN),
+        .pin_bit_mask = GPIO_PIN_SEL(led_pin),
         .mode = GPIO_MODE_OUTPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE
     };
+    gpio_dev_config_pin(ctrl->gpio, &led_config);
     
-    gpio_config_pin(&led_config);
+    int index = (int)ctrl->count++;
+    ctrl->leds[index].pin = led_pin;
+    ctrl->leds[index].state = LED_OFF;
+    ctrl->leds[index].name = name;
+    ctrl->leds[index].brightness = 0;
+    ctrl->leds[index].pwm_channel = -1;
+    ctrl->pin_index[led_pin] = (int16_t)index;
+    ctrl->pin_mask |= GPIO_PIN_SEL(led_pin);
+    return index;
+}
+
+// Initialize a controller with the default board LEDs, all OFF
+void led_ctrl_init_board(led_controller_t *ctrl, gpio_device_t *gpio) {
+    SIM_LOGI(LED, SIM_EVT_LED_INIT_BEGIN, 0, 0, NULL);
+    
+    led_ctrl_init(ctrl, gpio);
+    int registered = 0;
+    for (int i = 0; i < NUM_LEDS; i++) {
+        registered += led_ctrl_register(ctrl, default_leds[i].pin, default_leds[i].name) == i;
+    }
+    ctrl->board = registered == NUM_LEDS;
     
     // Turn off all LEDs initially
-    led_all_off();
+    led_ctrl_all_off(ctrl);
+    
+    SIM_LOGI(LED, SIM_EVT_LED_INIT_DONE, 0, 0, NULL);
+}
+
+// Write-combined output: record levels of plain LED pins in the shadow
+// word; led_ctrl_commit() writes them to OUT
+static inline void led_shadow_write(led_controller_t *ctrl, uint64_t mask, uint64_t levels) {
+    ctrl->shadow = (ctrl->shadow & ~mask) | (levels & mask);
+    ctrl->dirty |= mask;
+    ctrl->combined_writes += (uint64_t)__builtin_popcountll(mask);
+}
+
+// LEDC duty for a brightness percentage
+static inline uint32_t led_percent_to_duty(const led_controller_t *ctrl, const led_t *led, uint32_t percent) {
+    return ledc_dev_get_duty_max(ctrl->ledc, (uint32_t)led->pwm_channel) * percent / 100;
+}
+
+// Route an LED through its own LEDC channel (the LED's dense index) the
+// first time it is dimmed; returns false if no PWM is attached
+static bool led_use_pwm(led_controller_t *ctrl, led_t *led) {
+    if (led->pwm_channel >= 0) {
+        return true;
+    }
+    if (!ctrl->ledc) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_NO_PWM, led->pin, 0, NULL);
+        return false;
+    }
     
-    printf("[LED] All LEDs initialized and turned OFF\n");
+    ledc_channel_config_t channel_config = {
+        .channel = (uint32_t)(led - ctrl->leds),
+        .gpio_num = (int)led->pin,
+        .timer_sel = LED_PWM_TIMER,
+        .duty = (led->state == LED_ON) ? (1u << LED_PWM_RESOLUTION) : 0
+    };
+    if (!ledc_dev_channel_config(ctrl->ledc, &channel_config)) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_NO_PWM, led->pin, 0, NULL);
+        return false;
+    }
+    led->pwm_channel = (int32_t)channel_config.channel;
+    ctrl->pwm_mask |= GPIO_PIN_SEL(led->pin);
+    // The channel drives the pin from now on
+    ctrl->dirty &= ~GPIO_PIN_SEL(led->pin);
+    return true;
+}
+
+// Set the duty of a dimmed LED at once, cancelling any fade
+static void led_apply_duty(led_controller_t *ctrl, led_t *led, uint32_t percent) {
+    ledc_dev_set_duty(ctrl->ledc, (uint32_t)led->pwm_channel, led_percent_to_duty(ctrl, led, percent));
+    ledc_dev_update_duty(ctrl->ledc, (uint32_t)led->pwm_channel);
+}
+
+// Drive a found LED to a state
+static void led_apply_state(led_controller_t *ctrl, led_t *led, led_state_t state) {
+    led->state = state;
+    led->brightness = (state == LED_ON) ? 100 : 0;
+    if (led->pwm_channel >= 0) {
+        led_apply_duty(ctrl, led, led->brightness);
+    } else if (ctrl->combine) {
+        led_shadow_write(ctrl, GPIO_PIN_SEL(led->pin), (state == LED_ON) ? GPIO_PIN_SEL(led->pin) : 0);
+    } else {
+        gpio_dev_set_level(ctrl->gpio, led->pin, (state == LED_ON) ? GPIO_LEVEL_HIGH : GPIO_LEVEL_LOW);
+    }
+    SIM_LOGI(LED, SIM_EVT_LED_STATE, led->pin, state, led->name);
 }
 
 // Set LED state
-void led_set_state(uint32_t led_pin, led_state_t state) {
-    // Find the LED in our array
-    for (int i = 0; i < NUM_LEDS; i++) {
-        if (leds[i].pin == led_pin) {
-            leds[i].state = state;
-            gpio_set_level(led_pin, (state == LED_ON) ? GPIO_LEVEL_HIGH : GPIO_LEVEL_LOW);
-            printf("[LED] %s turned %s\n", leds[i].name, (state == LED_ON) ? "ON" : "OFF");
-            return;
-        }
+void led_ctrl_set_state(led_controller_t *ctrl, uint32_t led_pin, led_state_t state) {
+    led_t *led = led_find(ctrl, led_pin);
+    if (!led) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_INVALID_PIN, led_pin, 0, NULL);
+        return;
     }
-    printf("[LED ERROR] Invalid LED pin: %d\n", led_pin);
+    led_apply_state(ctrl, led, state);
 }
 
 // Toggle LED state
-void led_toggle(uint32_t led_pin) {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        if (leds[i].pin == led_pin) {
-            led_state_t new_state = (leds[i].state == LED_ON) ? LED_OFF : LED_ON;
-            led_set_state(led_pin, new_state);
-            return;
-        }
+void led_ctrl_toggle(led_controller_t *ctrl, uint32_t led_pin) {
+    led_t *led = led_find(ctrl, led_pin);
+    if (!led) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_INVALID_TOGGLE, led_pin, 0, NULL);
+        return;
     }
-    printf("[LED ERROR] Invalid LED pin for toggle: %d\n", led_pin);
+    led_apply_state(ctrl, led, (led->state == LED_ON) ? LED_OFF : LED_ON);
 }
 
 // Turn LED on
-void led_turn_on(uint32_t led_pin) {
-    led_set_state(led_pin, LED_ON);
+void led_ctrl_turn_on(led_controller_t *ctrl, uint32_t led_pin) {
+    led_ctrl_set_state(ctrl, led_pin, LED_ON);
 }
 
 // Turn LED off
-void led_turn_off(uint32_t led_pin) {
-    led_set_state(led_pin, LED_OFF);
+void led_ctrl_turn_off(led_controller_t *ctrl, uint32_t led_pin) {
+    led_ctrl_set_state(ctrl, led_pin, LED_OFF);
 }
 
 // Get LED state
-led_state_t led_get_state(uint32_t led_pin) {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        if (leds[i].pin == led_pin) {
-            return leds[i].state;
-        }
+led_state_t led_ctrl_get_state(const led_controller_t *ctrl, uint32_t led_pin) {
+    const led_t *led = led_find(ctrl, led_pin);
+    if (!led) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_INVALID_QUERY, led_pin, 0, NULL);
+        return LED_OFF;
     }
-    printf("[LED ERROR] Invalid LED pin for state query: %d\n", led_pin);
-    return LED_OFF;
+    return led->state;
 }
 
 // Turn all LEDs off
-void led_all_off(void) {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        leds[i].state = LED_OFF;
-        gpio_set_level(leds[i].pin, GPIO_LEVEL_LOW);
+void led_ctrl_all_off(led_controller_t *ctrl) {
+    for (size_t i = 0; i < ctrl->count; i++) {
+        ctrl->leds[i].state = LED_OFF;
+        ctrl->leds[i].brightness = 0;
+        if (ctrl->leds[i].pwm_channel >= 0) {
+            led_apply_duty(ctrl, &ctrl->leds[i], 0);
+        }
     }
-    printf("[LED] All LEDs turned OFF\n");
+    if (ctrl->combine) {
+        led_shadow_write(ctrl, ctrl->pin_mask & ~ctrl->pwm_mask, 0);
+    } else {
+        gpio_dev_clear_mask(ctrl->gpio, ctrl->pin_mask & ~ctrl->pwm_mask);
+    }
+    SIM_LOGI(LED, SIM_EVT_LED_ALL, 0, LED_OFF, NULL);
 }
 
 // Turn all LEDs on
-void led_all_on(void) {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        leds[i].state = LED_ON;
-        gpio_set_level(leds[i].pin, GPIO_LEVEL_HIGH);
+void led_ctrl_all_on(led_controller_t *ctrl) {
+    for (size_t i = 0; i < ctrl->count; i++) {
+        ctrl->leds[i].state = LED_ON;
+        ctrl->leds[i].brightness = 100;
+        if (ctrl->leds[i].pwm_channel >= 0) {
+            led_apply_duty(ctrl, &ctrl->leds[i], 100);
+        }
+    }
+    if (ctrl->combine) {
+        led_shadow_write(ctrl, ctrl->pin_mask & ~ctrl->pwm_mask, ~0ULL);
+    } else {
+        gpio_dev_set_mask(ctrl->gpio, ctrl->pin_mask & ~ctrl->pwm_mask);
+    }
+    SIM_LOGI(LED, SIM_EVT_LED_ALL, 0, LED_ON, NULL);
+}
+
+// Drive the LEDs and other output pins in 'mask' to the matching bits of
+// 'levels'. Plain pins change in one OUT register update; dimmed LEDs
+// go through their PWM channel.
+void led_ctrl_write_mask(led_controller_t *ctrl, uint64_t mask, uint64_t levels) {
+    uint64_t leds = mask & ctrl->pin_mask;
+    while (leds) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(leds);
+        leds &= leds - 1;
+        led_t *led = &ctrl->leds[ctrl->pin_index[pin]];
+        led_state_t state = (levels & GPIO_PIN_SEL(pin)) ? LED_ON : LED_OFF;
+        if (led->pwm_channel >= 0) {
+            led_apply_state(ctrl, led, state);
+            continue;
+        }
+        led->state = state;
+        led->brightness = (state == LED_ON) ? 100 : 0;
+        SIM_LOGI(LED, SIM_EVT_LED_STATE, pin, state, led->name);
+    }
+    
+    mask &= ~ctrl->pwm_mask;
+    if (ctrl->combine) {
+        led_shadow_write(ctrl, mask & ctrl->pin_mask, levels);
+        mask &= ~ctrl->pin_mask;
+    }
+    if (mask) {
+        gpio_dev_write_mask(ctrl->gpio, mask, levels);
     }
-    printf("[LED] All LEDs turned ON\n");
 }
 
 // Display LED status
-void led_display_status(void) {
+void led_ctrl_display_status(const led_controller_t *ctrl) {
+    sim_log_flush();
     printf("\n=== LED Status ===\n");
-    for (int i = 0; i < NUM_LEDS; i++) {
-        printf("  %s (Pin %d): %s\n", 
-               leds[i].name, 
-               leds[i].pin, 
-               (leds[i].state == LED_ON) ? "ON" : "OFF");
+    for (size_t i = 0; i < ctrl->count; i++) {
+        const led_t *led = &ctrl->leds[i];
+        bool fading = led->pwm_channel >= 0 && ledc_dev_is_fading(ctrl->ledc, (uint32_t)led->pwm_channel);
+        printf("  %s (Pin %d): %s, brightness %u%%%s\n", 
+               led->name, 
+               led->pin, 
+               (led->state == LED_ON) ? "ON" : "OFF",
+               led_ctrl_get_brightness(ctrl, led->pin),
+               fading ? " (fading)" : "");
+    }
+    if (ctrl->combine) {
+        printf("  Write combining: %llu LED writes, %llu coalesced, %llu commits\n",
+               (unsigned long long)ctrl->combined_writes,
+               (unsigned long long)(ctrl->combined_writes - ctrl->committed_writes),
+               (unsigned long long)ctrl->commits);
     }
     printf("==================\n\n");
 }
 
 // Get LED name
-const char* led_get_name(uint32_t led_pin) {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        if (leds[i].pin == led_pin) {
-            return leds[i].name;
+const char* led_ctrl_get_name(const led_controller_t *ctrl, uint32_t led_pin) {
+    const led_t *led = led_find(ctrl, led_pin);
+    return led ? led->name : "UNKNOWN";
+}
+
+// Use an LEDC device for brightness; configures its LED_PWM_TIMER
+bool led_ctrl_attach_ledc(led_controller_t *ctrl, ledc_device_t *ledc) {
+    ledc_timer_config_t timer_config = {
+        .timer_num = LED_PWM_TIMER,
+        .freq_hz = LED_PWM_FREQ_HZ,
+        .duty_resolution = LED_PWM_RESOLUTION
+    };
+    if (!ledc_dev_timer_config(ledc, &timer_config)) {
+        return false;
+    }
+    ctrl->ledc = ledc;
+    return true;
+}
+
+// Set an LED's brightness in percent; anything above 0% counts as ON
+// Full on and off need no PWM, so an LED only takes a channel once dimmed.
+void led_ctrl_set_brightness(led_controller_t *ctrl, uint32_t led_pin, uint32_t percent) {
+    led_t *led = led_find(ctrl, led_pin);
+    if (!led) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_INVALID_PIN, led_pin, 0, NULL);
+        return;
+    }
+    if (percent > 100) {
+        percent = 100;
+    }
+    
+    if ((percent == 0 || percent == 100) && led->pwm_channel < 0) {
+        led_apply_state(ctrl, led, percent ? LED_ON : LED_OFF);
+        return;
+    }
+    if (!led_use_pwm(ctrl, led)) {
+        return;
+    }
+    led->state = percent ? LED_ON : LED_OFF;
+    led->brightness = (uint8_t)percent;
+    led_apply_duty(ctrl, led, percent);
+    SIM_LOGI(LED, SIM_EVT_LED_BRIGHTNESS, led->pin, percent, led->name);
+}
+
+// Fade an LED linearly to 'percent' over 'fade_ms'
+void led_ctrl_fade_brightness(led_controller_t *ctrl, uint32_t led_pin, uint32_t percent, uint32_t fade_ms) {
+    led_t *led = led_find(ctrl, led_pin);
+    if (!led) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_INVALID_PIN, led_pin, 0, NULL);
+        return;
+    }
+    if (percent > 100) {
+        percent = 100;
+    }
+    if (!led_use_pwm(ctrl, led)) {
+        return;
+    }
+    
+    uint32_t channel = (uint32_t)led->pwm_channel;
+    if (!ledc_dev_set_fade_with_time(ctrl->ledc, channel, led_percent_to_duty(ctrl, led, percent), fade_ms) ||
+        !ledc_dev_fade_start(ctrl->ledc, channel)) {
+        return;
+    }
+    led->state = percent ? LED_ON : LED_OFF;
+    led->brightness = (uint8_t)percent;
+    SIM_LOGI(LED, SIM_EVT_LED_FADE, fade_ms, percent, led->name);
+}
+
+// Brightness in percent right now, part way through a fade if one runs
+uint32_t led_ctrl_get_brightness(const led_controller_t *ctrl, uint32_t led_pin) {
+    const led_t *led = led_find(ctrl, led_pin);
+    if (!led) {
+        SIM_LOGE(LED, SIM_EVT_LED_ERR_INVALID_QUERY, led_pin, 0, NULL);
+        return 0;
+    }
+    if (led->pwm_channel < 0) {
+        return led->brightness;
+    }
+    
+    uint32_t channel = (uint32_t)led->pwm_channel;
+    uint32_t max = ledc_dev_get_duty_max(ctrl->ledc, channel);
+    return (ledc_dev_get_duty(ctrl->ledc, channel) * 100 + max / 2) / max;
+}
+
+// Bring the PWM in line with LED state and brightness that were written
+// directly (snapshot restore). Plain LEDs show the OUT register, which is
+// restored with the board; dimmed LEDs get their duty, ending any fade.
+void led_ctrl_reload(led_controller_t *ctrl) {
+    // OUT was restored too, so nothing written before is pending
+    ctrl->dirty = 0;
+    for (size_t i = 0; i < ctrl->count; i++) {
+        led_t *led = &ctrl->leds[i];
+        bool dimmed = led->brightness != 0 && led->brightness != 100;
+        if ((dimmed || led->pwm_channel >= 0) && led_use_pwm(ctrl, led)) {
+            led_apply_duty(ctrl, led, led->brightness);
         }
     }
-    return "UNKNOWN";
-}
\ No newline at end of file
+}
+
+// Write combining: while enabled, plain LED writes only update a shadow
+// word, and led_ctrl_commit() writes every pending change to OUT in one
+// register update. Writes that a later write overrides, or that leave a
+// pin at its level, never reach the register, and watches see all the
+// changes of a commit at once. LED state and brightness queries are
+// current at all times; OUT shows the LEDs as of the last commit.
+// Disabling commits what is pending.
+void led_ctrl_set_write_combining(led_controller_t *ctrl, bool enable) {
+    if (!enable) {
+        led_ctrl_commit(ctrl);
+    }
+    ctrl->combine = enable;
+}
+
+// Write the pending LED levels to OUT, dropping pins already at their
+// level; returns the pins that changed
+uint64_t led_ctrl_commit(led_controller_t *ctrl) {
+    uint64_t dirty = ctrl->dirty;
+    if (!dirty) {
+        return 0;
+    }
+    ctrl->dirty = 0;
+    
+    uint64_t changed = dirty & (ctrl->shadow ^ gpio_dev_read_all(ctrl->gpio));
+    if (changed) {
+        gpio_dev_write_mask(ctrl->gpio, changed, ctrl->shadow);
+        ctrl->committed_writes += (uint64_t)__builtin_popcountll(changed);
+        ctrl->commits++;
+    }
+    return changed;
+}
+
+// Default-instance API
+
+// Get the controller used by the default-instance functions
+led_controller_t *led_default_controller(void) {
+    return &default_controller;
+}
+
+void led_init_all(void) {
+    led_ctrl_init_board(&default_controller, gpio_default_device());
+}
+
+int led_register(uint32_t led_pin, const char *name) {
+    return led_ctrl_register(&default_controller, led_pin, name);
+}
+
+void led_set_state(uint32_t led_pin, led_state_t state) {
+    led_ctrl_set_state(&default_controller, led_pin, state);
+}
+
+void led_toggle(uint32_t led_pin) {
+    led_ctrl_toggle(&default_controller, led_pin);
+}
+
+void led_turn_on(uint32_t led_pin) {
+    led_ctrl_turn_on(&default_controller, led_pin);
+}
+
+void led_turn_off(uint32_t led_pin) {
+    led_ctrl_turn_off(&default_controller, led_pin);
+}
+
+led_state_t led_get_state(uint32_t led_pin) {
+    return led_ctrl_get_state(&default_controller, led_pin);
+}
+
+void led_all_off(void) {
+    led_ctrl_all_off(&default_controller);
+}
+
+void led_all_on(void) {
+    led_ctrl_all_on(&default_controller);
+}
+
+void led_write_mask(uint64_t mask, uint64_t levels) {
+    led_ctrl_write_mask(&default_controller, mask, levels);
+}
+
+void led_display_status(void) {
+    led_ctrl_display_status(&default_controller);
+}
+
+const char* led_get_name(uint32_t led_pin) {
+    return led_ctrl_get_name(&default_controller, led_pin);
+}
+
+void led_set_brightness(uint32_t led_pin, uint32_t percent) {
+    led_ctrl_set_brightness(&default_controller, led_pin, percent);
+}
+
+void led_fade_brightness(uint32_t led_pin, uint32_t percent, uint32_t fade_ms) {
+    led_ctrl_fade_brightness(&default_controller, led_pin, percent, fade_ms);
+}
+
+uint32_t led_get_brightness(uint32_t led_pin) {
+    return led_ctrl_get_brightness(&default_controller, led_pin);
+}
+
+void led_set_write_combining(bool enable) {
+    led_ctrl_set_write_combining(&default_controller, enable);
+}
+
+uint64_t led_commit(void) {
+    return led_ctrl_commit(&default_controller);
+}
@@ -0,0 +1,418 @@
+#include "led_strip.h"
+#include "sim_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Duration in ticks, rounded to the nearest tick; false if it does not
+// fit a symbol half
+static bool led_strip_ticks(uint32_t ns, uint32_t *ticks) {
+    uint32_t t = (uint32_t)(((uint64_t)ns + LED_STRIP_TICK_NS / 2) / LED_STRIP_TICK_NS);
+    if (t < 1 || t > LED_STRIP_MAX_TICKS) {
+        return false;
+    }
+    *ticks = t;
+    return true;
+}
+
+// Symbol of one data bit
+static inline led_strip_symbol_t led_strip_bit_symbol(uint32_t high, uint32_t low) {
+    led_strip_symbol_t sym = {.duration0 = high, .level0 = 1, .duration1 = low, .level1 = 0};
+    return sym;
+}
+
+// Wire word of a pixel, first byte in bits 23..16
+static inline uint32_t led_strip_pack(led_strip_order_t order, led_strip_pixel_t px) {
+    if (order == LED_STRIP_ORDER_RGB) {
+        return (uint32_t)px.r << 16 | (uint32_t)px.g << 8 | px.b;
+    }
+    return (uint32_t)px.g << 16 | (uint32_t)px.r << 8 | px.b;
+}
+
+// Pixel of a wire word
+static inline led_strip_pixel_t led_strip_unpack(led_strip_order_t order, uint32_t word) {
+    led_strip_pixel_t px = {.b = (uint8_t)word};
+    if (order == LED_STRIP_ORDER_RGB) {
+        px.r = (uint8_t)(word >> 16);
+        px.g = (uint8_t)(word >> 8);
+    } else {
+        px.g = (uint8_t)(word >> 16);
+        px.r = (uint8_t)(word >> 8);
+    }
+    return px;
+}
+
+// Encode pixels [first, end) into their symbols, one table copy per byte
+static void led_strip_encode(led_strip_t *strip, uint32_t first, uint32_t end) {
+    led_strip_symbol_t *out = strip->symbols + (size_t)first * LED_STRIP_BITS_PER_PIXEL;
+    for (uint32_t i = first; i < end; i++) {
+        uint32_t word = led_strip_pack(strip->config.order, strip->pixels[i]);
+        memcpy(out, strip->byte_symbols[(word >> 16) & 0xff], sizeof(strip->byte_symbols[0]));
+        memcpy(out + 8, strip->byte_symbols[(word >> 8) & 0xff], sizeof(strip->byte_symbols[0]));
+        memcpy(out + 16, strip->byte_symbols[word & 0xff], sizeof(strip->byte_symbols[0]));
+        out += LED_STRIP_BITS_PER_PIXEL;
+    }
+}
+
+// Data pin level at time 't': high for the first half of the symbol of
+// the bit being sent, low outside the data
+static uint32_t led_strip_level_at(const led_strip_t *strip, uint64_t t) {
+    if (t < strip->tx_start_ns || t >= strip->tx_end_ns) {
+        return 0;
+    }
+    uint64_t offset = t - strip->tx_start_ns;
+    const led_strip_symbol_t *sym = &strip->symbols[offset / strip->bit_ns];
+    return offset % strip->bit_ns < (uint64_t)sym->duration0 * LED_STRIP_TICK_NS ? 1u : 0u;
+}
+
+// GPIO level source of the data pin
+static uint32_t led_strip_pin_level(void *arg, uint32_t gpio_num) {
+    const led_strip_t *strip = arg;
+    (void)gpio_num;
+    return led_strip_level_at(strip, sim_clock_now(strip->clock));
+}
+
+// Arm the edge timer for the first level change after 't': the end of
+// the high phase of the current bit, or the start of the next bit
+static void led_strip_schedule_edge(led_strip_t *strip, uint64_t t) {
+    if (t >= strip->tx_end_ns) {
+        timer_wheel_cancel(strip->wheel, &strip->edge_timer);
+        return;
+    }
+    
+    uint64_t bit = (t - strip->tx_start_ns) / strip->bit_ns;
+    uint64_t bit_start = strip->tx_start_ns + bit * strip->bit_ns;
+    uint64_t high = (uint64_t)strip->symbols[bit].duration0 * LED_STRIP_TICK_NS;
+    uint64_t next = t - bit_start < high ? bit_start + high : bit_start + strip->bit_ns;
+    timer_wheel_arm(strip->wheel, &strip->edge_timer, next);
+}
+
+// Edge timer: write the level the pin has now, then wait for the next
+static void led_strip_edge_cb(void *arg, uint64_t deadline_ns) {
+    led_strip_t *strip = arg;
+    uint64_t bit = GPIO_PIN_SEL(strip->config.gpio_num);
+    
+    if (gpio_dev_drive_outputs(strip->gpio, bit, led_strip_level_at(strip, deadline_ns) ? bit : 0)) {
+        strip->edges++;
+    }
+    led_strip_schedule_edge(strip, deadline_ns);
+}
+
+// Widen the dirty range to cover pixels [first, end)
+static inline void led_strip_mark_dirty(led_strip_t *strip, uint32_t first, uint32_t end) {
+    if (first < strip->dirty_first) {
+        strip->dirty_first = first;
+    }
+    if (end > strip->dirty_end) {
+        strip->dirty_end = end;
+    }
+}
+
+// Set up a strip with every pixel off and route its data pin, which
+// becomes an output read through the strip's waveform
+bool led_strip_init(led_strip_t *strip, gpio_device_t *gpio, sim_clock_t *clock, timer_wheel_t *wheel,
+                    const led_strip_config_t *config) {
+    uint32_t t0h, t0l, t1h, t1l;
+    
+    memset(strip, 0, sizeof(*strip));
+    if (!config || !GPIO_IS_VALID_GPIO(config->gpio_num)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, config ? config->gpio_num : 0, 0, "invalid pin");
+        return false;
+    }
+    if (config->length < 1 || config->length > LED_STRIP_MAX_PIXELS || config->order > LED_STRIP_ORDER_RGB) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, config->gpio_num, config->length, "invalid length or order");
+        return false;
+    }
+    const led_strip_timing_t *tm = &config->timing;
+    if (!led_strip_ticks(tm->t0h_ns, &t0h) || !led_strip_ticks(tm->t0l_ns, &t0l) ||
+        !led_strip_ticks(tm->t1h_ns, &t1h) || !led_strip_ticks(tm->t1l_ns, &t1l) ||
+        t0h + t0l != t1h + t1l || t0h == t1h || tm->reset_ns == 0 ||
+        tm->reset_ns > 2ULL * LED_STRIP_MAX_TICKS * LED_STRIP_TICK_NS) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, config->gpio_num, 0, "invalid timing");
+        return false;
+    }
+    
+    strip->pixels = calloc(config->length, sizeof(*strip->pixels));
+    strip->symbols = malloc(((size_t)config->length * LED_STRIP_BITS_PER_PIXEL + 1) * sizeof(*strip->symbols));
+    if (!strip->pixels || !strip->symbols) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, config->gpio_num, config->length, "out of memory");
+        free(strip->pixels);
+        free(strip->symbols);
+        strip->pixels = NULL;
+        strip->symbols = NULL;
+        return false;
+    }
+    
+    strip->gpio = gpio;
+    strip->clock = clock;
+    strip->wheel = wheel;
+    strip->config = *config;
+    strip->bit_ns = (uint64_t)(t0h + t0l) * LED_STRIP_TICK_NS;
+    for (uint32_t value = 0; value < 256; value++) {
+        for (uint32_t k = 0; k < 8; k++) {
+            bool one = (value >> (7 - k)) & 1;
+            strip->byte_symbols[value][k] = one ? led_strip_bit_symbol(t1h, t1l) : led_strip_bit_symbol(t0h, t0l);
+        }
+    }
+    
+    // The reset closes the buffer: low for both halves, rounded up
+    uint32_t reset = (uint32_t)((tm->reset_ns + 2 * LED_STRIP_TICK_NS - 1) / (2 * LED_STRIP_TICK_NS));
+    led_strip_symbol_t latch = {.duration0 = reset, .level0 = 0, .duration1 = reset, .level1 = 0};
+    strip->symbols[(size_t)config->length * LED_STRIP_BITS_PER_PIXEL] = latch;
+    led_strip_encode(strip, 0, config->length);
+    strip->dirty_first = config->length;
+    strip->dirty_end = 0;
+    
+    timer_wheel_timer_init(&strip->edge_timer, led_strip_edge_cb, strip);
+    gpio_config_t out_config = {
+        .pin_bit_mask = GPIO_PIN_SEL(config->gpio_num),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE
+    };
+    gpio_dev_config_pin(gpio, &out_config);
+    gpio_dev_set_level_source(gpio, config->gpio_num, led_strip_pin_level, strip);
+    return true;
+}
+
+// Stop sending, return the pin to the OUT register and free the buffers
+void led_strip_deinit(led_strip_t *strip) {
+    if (!strip->pixels) {
+        return;
+    }
+    timer_wheel_cancel(strip->wheel, &strip->edge_timer);
+    gpio_dev_set_level_source(strip->gpio, strip->config.gpio_num, NULL, NULL);
+    free(strip->pixels);
+    free(strip->symbols);
+    strip->pixels = NULL;
+    strip->symbols = NULL;
+}
+
+// Draw one pixel; it is sent at the next refresh
+// Writing the color a pixel already has leaves the dirty range alone.
+bool led_strip_set_pixel(led_strip_t *strip, uint32_t index, uint8_t r, uint8_t g, uint8_t b) {
+    if (index >= strip->config.length) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, strip->config.gpio_num, index, "pixel out of range");
+        return false;
+    }
+    led_strip_pixel_t *px = &strip->pixels[index];
+    if (px->r != r || px->g != g || px->b != b) {
+        px->r = r;
+        px->g = g;
+        px->b = b;
+        led_strip_mark_dirty(strip, index, index + 1);
+    }
+    return true;
+}
+
+// Color of a pixel in the drawing buffer, off if out of range
+led_strip_pixel_t led_strip_get_pixel(const led_strip_t *strip, uint32_t index) {
+    led_strip_pixel_t off = {0, 0, 0};
+    return index < strip->config.length ? strip->pixels[index] : off;
+}
+
+// Draw 'count' pixels from 'first' in one color, clipped to the strip
+void led_strip_fill(led_strip_t *strip, uint32_t first, uint32_t count, led_strip_pixel_t pixel) {
+    uint32_t length = strip->config.length;
+    if (first >= length || count == 0) {
+        return;
+    }
+    uint32_t end = count > length - first ? length : first + count;
+    for (uint32_t i = first; i < end; i++) {
+        strip->pixels[i] = pixel;
+    }
+    led_strip_mark_dirty(strip, first, end);
+}
+
+// Turn every pixel off at the next refresh
+void led_strip_clear(led_strip_t *strip) {
+    led_strip_pixel_t off = {0, 0, 0};
+    led_strip_fill(strip, 0, strip->config.length, off);
+}
+
+// Encode the dirty range and start sending the frame now
+// Returns false, sending nothing, while the previous frame or its reset
+// time is not over; the drawing buffer is kept for the next attempt.
+bool led_strip_refresh(led_strip_t *strip) {
+    uint64_t now = sim_clock_now(strip->clock);
+    if (now < strip->ready_ns) {
+        strip->busy++;
+        return false;
+    }
+    
+    uint32_t dirty = 0;
+    if (strip->dirty_first < strip->dirty_end) {
+        dirty = strip->dirty_end - strip->dirty_first;
+        led_strip_encode(strip, strip->dirty_first, strip->dirty_end);
+        strip->encoded += dirty;
+        strip->dirty_first = strip->config.length;
+        strip->dirty_end = 0;
+    }
+    
+    size_t bits = (size_t)strip->config.length * LED_STRIP_BITS_PER_PIXEL;
+    const led_strip_symbol_t *latch = &strip->symbols[bits];
+    strip->tx_start_ns = now;
+    strip->tx_end_ns = now + bits * strip->bit_ns;
+    strip->ready_ns = strip->tx_end_ns + (uint64_t)(latch->duration0 + latch->duration1) * LED_STRIP_TICK_NS;
+    strip->frames++;
+    SIM_LOGD(GPIO, SIM_EVT_GPIO_STRIP_REFRESH, strip->config.gpio_num, dirty, NULL);
+    
+    // OUT gets the first level; while observed, the edge timer takes over
+    uint32_t pin = strip->config.gpio_num;
+    gpio_dev_drive_outputs(strip->gpio, GPIO_PIN_SEL(pin), led_strip_level_at(strip, now) ? GPIO_PIN_SEL(pin) : 0);
+    if (gpio_dev_is_observed(strip->gpio, pin)) {
+        led_strip_schedule_edge(strip, now);
+    }
+    return true;
+}
+
+// Check whether a frame or its reset time is still on the wire
+bool led_strip_is_busy(const led_strip_t *strip) {
+    return sim_clock_now(strip->clock) < strip->ready_ns;
+}
+
+// Symbols in a frame: 24 per pixel and the reset
+size_t led_strip_symbol_count(const led_strip_t *strip) {
+    return (size_t)strip->config.length * LED_STRIP_BITS_PER_PIXEL + 1;
+}
+
+// Check that a pulse of 'ticks' is within tolerance of 'ns'
+static inline bool led_strip_near(uint32_t ticks, uint32_t ns) {
+    uint64_t t = (uint64_t)ticks * LED_STRIP_TICK_NS;
+    return t + LED_STRIP_TOLERANCE_NS >= ns && t <= (uint64_t)ns + LED_STRIP_TOLERANCE_NS;
+}
+
+// Decode the first frame of a symbol stream into at most '*num_pixels'
+// pixels, storing how many were decoded in '*num_pixels'
+// A frame ends at the first low time of at least the reset time. Returns
+// false if a pulse is out of tolerance, a pixel is incomplete, the frame
+// has more pixels than room, or no reset ends it.
+bool led_strip_decode(const led_strip_config_t *config, const led_strip_symbol_t *symbols, size_t count,
+                      led_strip_pixel_t *pixels, size_t *num_pixels) {
+    const led_strip_timing_t *tm = &config->timing;
+    size_t max = *num_pixels;
+    size_t n = 0;
+    uint32_t word = 0;
+    uint32_t bits = 0;
+    bool ok = false;
+    
+    for (size_t i = 0; i < count; i++) {
+        const led_strip_symbol_t *sym = &symbols[i];
+        uint64_t low_ns = (uint64_t)sym->duration1 * LED_STRIP_TICK_NS;
+        if (!sym->level0) {
+            // Idle symbol: only a reset may follow the data
+            ok = !sym->level1 && (uint64_t)(sym->duration0 + sym->duration1) * LED_STRIP_TICK_NS >= tm->reset_ns;
+            break;
+        }
+        
+        uint32_t value;
+        if (sym->level1) {
+            break;
+        } else if (led_strip_near(sym->duration0, tm->t1h_ns)) {
+            value = 1;
+        } else if (led_strip_near(sym->duration0, tm->t0h_ns)) {
+            value = 0;
+        } else {
+            break;
+        }
+        bool latch = low_ns >= tm->reset_ns;
+        if (!latch && !led_strip_near(sym->duration1, value ? tm->t1l_ns : tm->t0l_ns)) {
+            break;
+        }
+        
+        word = word << 1 | value;
+        if (++bits == LED_STRIP_BITS_PER_PIXEL) {
+            if (n == max) {
+                break;
+            }
+            pixels[n++] = led_strip_unpack(config->order, word);
+            word = 0;
+            bits = 0;
+        }
+        if (latch) {
+            ok = true;
+            break;
+        }
+    }
+    *num_pixels = n;
+    return ok && bits == 0;
+}
+
+// Receiver watch: a rising edge closes the low phase of the open symbol
+// and opens the next, a falling edge ends its high phase
+static void led_strip_rx_on_change(void *arg, uint64_t changed, uint64_t levels) {
+    led_strip_rx_t *rx = arg;
+    uint64_t bit = GPIO_PIN_SEL(rx->gpio_num);
+    if (!(changed & bit)) {
+        return;
+    }
+    
+    uint64_t now = sim_clock_now(rx->clock);
+    if (levels & bit) {
+        if (rx->count) {
+            uint64_t ticks = (now - rx->fall_ns + LED_STRIP_TICK_NS / 2) / LED_STRIP_TICK_NS;
+            rx->symbols[rx->count - 1].duration1 = ticks < LED_STRIP_MAX_TICKS ? ticks : LED_STRIP_MAX_TICKS;
+        }
+        if (rx->count == rx->capacity) {
+            rx->overflow = true;
+            return;
+        }
+        led_strip_symbol_t open = {.duration0 = 0, .level0 = 1, .duration1 = 0, .level1 = 0};
+        rx->symbols[rx->count++] = open;
+        rx->rise_ns = now;
+        rx->high = true;
+    } else if (rx->high) {
+        uint64_t ticks = (now - rx->rise_ns + LED_STRIP_TICK_NS / 2) / LED_STRIP_TICK_NS;
+        rx->symbols[rx->count - 1].duration0 = ticks < LED_STRIP_MAX_TICKS ? ticks : LED_STRIP_MAX_TICKS;
+        rx->fall_ns = now;
+        rx->high = false;
+    }
+}
+
+// Start capturing the edges of a pin into room for 'capacity' symbols
+bool led_strip_rx_start(led_strip_rx_t *rx, gpio_device_t *gpio, sim_clock_t *clock, uint32_t gpio_num,
+                        size_t capacity) {
+    memset(rx, 0, sizeof(*rx));
+    if (!GPIO_IS_VALID_GPIO(gpio_num) || capacity == 0) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, gpio_num, capacity, "invalid receiver");
+        return false;
+    }
+    rx->symbols = malloc(capacity * sizeof(*rx->symbols));
+    if (!rx->symbols) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, gpio_num, capacity, "out of memory");
+        return false;
+    }
+    rx->gpio = gpio;
+    rx->clock = clock;
+    rx->gpio_num = gpio_num;
+    rx->capacity = capacity;
+    if (!gpio_dev_add_watch(gpio, GPIO_PIN_SEL(gpio_num), led_strip_rx_on_change, rx)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_STRIP, gpio_num, 0, "no free watch");
+        free(rx->symbols);
+        rx->symbols = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Stop capturing and free the symbols
+void led_strip_rx_stop(led_strip_rx_t *rx) {
+    if (rx->symbols) {
+        gpio_dev_remove_watch(rx->gpio, led_strip_rx_on_change, rx);
+        free(rx->symbols);
+        rx->symbols = NULL;
+    }
+}
+
+// Decode the first frame captured, as led_strip_decode(), then start
+// capturing afresh. The low phase of the last symbol lasts until now.
+bool led_strip_rx_decode(led_strip_rx_t *rx, const led_strip_config_t *config, led_strip_pixel_t *pixels,
+                         size_t *num_pixels) {
+    if (rx->count && !rx->high) {
+        uint64_t ticks = (sim_clock_now(rx->clock) - rx->fall_ns + LED_STRIP_TICK_NS / 2) / LED_STRIP_TICK_NS;
+        rx->symbols[rx->count - 1].duration1 = ticks < LED_STRIP_MAX_TICKS ? ticks : LED_STRIP_MAX_TICKS;
+    }
+    bool ok = !rx->overflow && led_strip_decode(config, rx->symbols, rx->count, pixels, num_pixels);
+    rx->count = 0;
+    rx->high = false;
+    rx->overflow = false;
+    return ok;
+}
@@ -0,0 +1,433 @@
+#include "ledc.h"
+#include "sim_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Device used by the default-instance API
+static ledc_device_t default_device;
+
+// Channel by number, NULL if it was never configured
+static inline ledc_channel_t *ledc_find(const ledc_device_t *dev, uint32_t channel) {
+    if (channel >= dev->capacity) {
+        return NULL;
+    }
+    return dev->channels[channel];
+}
+
+// Look up a channel for an API call, logging unknown channels
+static ledc_channel_t *ledc_get(const ledc_device_t *dev, uint32_t channel, const char *op) {
+    ledc_channel_t *ch = ledc_find(dev, channel);
+    if (!ch) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_LEDC, channel, 0, op);
+    }
+    return ch;
+}
+
+// Full-scale duty of a channel: 100% on
+static inline uint32_t ledc_duty_full(const ledc_device_t *dev, const ledc_channel_t *ch) {
+    return 1u << dev->timers[ch->timer_sel].duty_resolution;
+}
+
+// Duty at time 't', following a running fade
+static uint32_t ledc_duty_at(const ledc_channel_t *ch, uint64_t t) {
+    if (!ch->fading) {
+        return ch->duty;
+    }
+    if (t <= ch->fade_start_ns) {
+        return ch->fade_from;
+    }
+    if (t >= ch->fade_end_ns) {
+        return ch->fade_to;
+    }
+    
+    // Fade times and duties are bounded, so the product fits in 64 bits
+    uint64_t elapsed = t - ch->fade_start_ns;
+    uint64_t span = ch->fade_end_ns - ch->fade_start_ns;
+    if (ch->fade_to >= ch->fade_from) {
+        return ch->fade_from + (uint32_t)((ch->fade_to - ch->fade_from) * elapsed / span);
+    }
+    return ch->fade_from - (uint32_t)((ch->fade_from - ch->fade_to) * elapsed / span);
+}
+
+// High time of one cycle at a given duty
+static inline uint64_t ledc_high_ns(const ledc_timer_t *timer, uint32_t duty) {
+    if (duty >= (1u << timer->duty_resolution)) {
+        return timer->period_ns;
+    }
+    return (timer->period_ns * duty) >> timer->duty_resolution;
+}
+
+// Start of the timer cycle containing 't'
+static inline uint64_t ledc_cycle_start(const ledc_timer_t *timer, uint64_t t) {
+    if (t < timer->epoch_ns) {
+        return t;
+    }
+    return t - (t - timer->epoch_ns) % timer->period_ns;
+}
+
+// Output level at time 't'; each cycle uses the duty of its start
+static uint32_t ledc_level_at(const ledc_device_t *dev, const ledc_channel_t *ch, uint64_t t) {
+    const ledc_timer_t *timer = &dev->timers[ch->timer_sel];
+    uint64_t cycle = ledc_cycle_start(timer, t);
+    return (t - cycle) < ledc_high_ns(timer, ledc_duty_at(ch, cycle)) ? 1u : 0u;
+}
+
+// GPIO level source of a routed channel
+static uint32_t ledc_pin_level(void *arg, uint32_t gpio_num) {
+    const ledc_channel_t *ch = arg;
+    (void)gpio_num;
+    return ledc_level_at(ch->dev, ch, sim_clock_now(ch->dev->clock));
+}
+
+// Arm the edge timer for the first possible level change after 't'; a
+// channel held at 0% or 100% has none until its duty changes again
+static void ledc_schedule_edge(ledc_device_t *dev, ledc_channel_t *ch, uint64_t t) {
+    const ledc_timer_t *timer = &dev->timers[ch->timer_sel];
+    uint64_t cycle = ledc_cycle_start(timer, t);
+    uint32_t duty = ledc_duty_at(ch, cycle);
+    
+    if (!ch->fading && (duty == 0 || duty >= ledc_duty_full(dev, ch))) {
+        timer_wheel_cancel(dev->wheel, &ch->edge_timer);
+        return;
+    }
+    
+    uint64_t high = ledc_high_ns(timer, duty);
+    uint64_t next = (t - cycle < high && high < timer->period_ns) ? cycle + high : cycle + timer->period_ns;
+    timer_wheel_arm(dev->wheel, &ch->edge_timer, next);
+}
+
+// Edge timer: write the level the channel has now, then wait for the next
+static void ledc_edge_cb(void *arg, uint64_t deadline_ns) {
+    ledc_channel_t *ch = arg;
+    ledc_device_t *dev = ch->dev;
+    uint64_t bit = GPIO_PIN_SEL(ch->gpio_num);
+    
+    if (gpio_dev_drive_outputs(dev->gpio, bit, ledc_level_at(dev, ch, deadline_ns) ? bit : 0)) {
+        dev->edges++;
+    }
+    ledc_schedule_edge(dev, ch, deadline_ns);
+}
+
+// Bring the pin in line with a new duty or fade. OUT gets the current
+// level once; while observed, the edge timer takes over from there.
+static void ledc_refresh(ledc_device_t *dev, ledc_channel_t *ch) {
+    if (ch->gpio_num == LEDC_GPIO_NONE) {
+        return;
+    }
+    
+    uint64_t now = sim_clock_now(dev->clock);
+    uint64_t bit = GPIO_PIN_SEL(ch->gpio_num);
+    gpio_dev_drive_outputs(dev->gpio, bit, ledc_level_at(dev, ch, now) ? bit : 0);
+    if (dev->observed) {
+        ledc_schedule_edge(dev, ch, now);
+    }
+}
+
+// Fade timer: the fade reached its target duty
+static void ledc_fade_cb(void *arg, uint64_t deadline_ns) {
+    ledc_channel_t *ch = arg;
+    (void)deadline_ns;
+    
+    ch->duty = ch->fade_to;
+    ch->fading = false;
+    SIM_LOGD(GPIO, SIM_EVT_GPIO_LEDC_FADE_DONE, ch->index, ch->duty, NULL);
+    ledc_refresh(ch->dev, ch);
+}
+
+// Stop a running fade, keeping the duty it has reached
+static void ledc_stop_fade(ledc_device_t *dev, ledc_channel_t *ch) {
+    if (ch->fading) {
+        ch->duty = ledc_duty_at(ch, sim_clock_now(dev->clock));
+        ch->fading = false;
+        timer_wheel_cancel(dev->wheel, &ch->fade_timer);
+    }
+}
+
+// Initialize a device with no timers or channels configured
+void ledc_dev_init(ledc_device_t *dev, gpio_device_t *gpio, sim_clock_t *clock, timer_wheel_t *wheel) {
+    memset(dev, 0, sizeof(*dev));
+    dev->gpio = gpio;
+    dev->clock = clock;
+    dev->wheel = wheel;
+}
+
+// Release every channel and return their pins to the OUT register
+void ledc_dev_deinit(ledc_device_t *dev) {
+    for (size_t i = 0; i < dev->capacity; i++) {
+        ledc_channel_t *ch = dev->channels[i];
+        if (!ch) {
+            continue;
+        }
+        timer_wheel_cancel(dev->wheel, &ch->edge_timer);
+        timer_wheel_cancel(dev->wheel, &ch->fade_timer);
+        if (ch->gpio_num != LEDC_GPIO_NONE) {
+            gpio_dev_set_level_source(dev->gpio, (uint32_t)ch->gpio_num, NULL, NULL);
+        }
+        free(ch);
+    }
+    free(dev->channels);
+    dev->channels = NULL;
+    dev->capacity = 0;
+}
+
+// Configure a timer's frequency and duty resolution
+bool ledc_dev_timer_config(ledc_device_t *dev, const ledc_timer_config_t *cfg) {
+    if (!cfg || cfg->timer_num >= LEDC_TIMER_MAX || cfg->freq_hz == 0 ||
+        cfg->freq_hz > SIM_CLOCK_NS_PER_SEC || cfg->duty_resolution == 0 ||
+        cfg->duty_resolution > LEDC_DUTY_RES_MAX) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_LEDC, cfg ? cfg->timer_num : 0, 0, "ledc_timer_config");
+        return false;
+    }
+    
+    ledc_timer_t *timer = &dev->timers[cfg->timer_num];
+    timer->freq_hz = cfg->freq_hz;
+    timer->duty_resolution = cfg->duty_resolution;
+    timer->period_ns = SIM_CLOCK_NS_PER_SEC / cfg->freq_hz;
+    timer->epoch_ns = sim_clock_now(dev->clock);
+    timer->configured = true;
+    
+    // Channels already on the timer follow the new period
+    for (size_t i = 0; i < dev->capacity; i++) {
+        if (dev->channels[i] && dev->channels[i]->timer_sel == cfg->timer_num) {
+            ledc_refresh(dev, dev->channels[i]);
+        }
+    }
+    return true;
+}
+
+// Configure a channel and route it to its pin, which becomes an output
+bool ledc_dev_channel_config(ledc_device_t *dev, const ledc_channel_config_t *cfg) {
+    if (!cfg || cfg->channel >= LEDC_CHANNEL_MAX || cfg->timer_sel >= LEDC_TIMER_MAX ||
+        !dev->timers[cfg->timer_sel].configured ||
+        (cfg->gpio_num != LEDC_GPIO_NONE && (cfg->gpio_num < 0 || !GPIO_IS_VALID_GPIO((uint32_t)cfg->gpio_num))) ||
+        cfg->duty > (1u << dev->timers[cfg->timer_sel].duty_resolution)) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_LEDC, cfg ? cfg->channel : 0, 0, "ledc_channel_config");
+        return false;
+    }
+    
+    if (cfg->channel >= dev->capacity) {
+        size_t capacity = dev->capacity ? dev->capacity : 16;
+        while (capacity <= cfg->channel) {
+            capacity *= 2;
+        }
+        ledc_channel_t **channels = realloc(dev->channels, capacity * sizeof(*channels));
+        if (!channels) {
+            SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_LEDC, cfg->channel, 0, "ledc_channel_config");
+            return false;
+        }
+        memset(channels + dev->capacity, 0, (capacity - dev->capacity) * sizeof(*channels));
+        dev->channels = channels;
+        dev->capacity = capacity;
+    }
+    
+    ledc_channel_t *ch = dev->channels[cfg->channel];
+    if (!ch) {
+        ch = calloc(1, sizeof(*ch));
+        if (!ch) {
+            SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_LEDC, cfg->channel, 0, "ledc_channel_config");
+            return false;
+        }
+        ch->dev = dev;
+        ch->index = cfg->channel;
+        ch->gpio_num = LEDC_GPIO_NONE;
+        timer_wheel_timer_init(&ch->edge_timer, ledc_edge_cb, ch);
+        timer_wheel_timer_init(&ch->fade_timer, ledc_fade_cb, ch);
+        dev->channels[cfg->channel] = ch;
+    }
+    
+    // Reconfiguring: stop the old fade and release the old pin
+    ledc_stop_fade(dev, ch);
+    timer_wheel_cancel(dev->wheel, &ch->edge_timer);
+    if (ch->gpio_num != LEDC_GPIO_NONE && ch->gpio_num != cfg->gpio_num) {
+        gpio_dev_set_level_source(dev->gpio, (uint32_t)ch->gpio_num, NULL, NULL);
+    }
+    
+    ch->gpio_num = cfg->gpio_num;
+    ch->timer_sel = cfg->timer_sel;
+    ch->duty = ch->duty_pending = cfg->duty;
+    ch->fade_set = false;
+    
+    if (ch->gpio_num != LEDC_GPIO_NONE) {
+        gpio_config_t out_config = {
+            .pin_bit_mask = GPIO_PIN_SEL(ch->gpio_num),
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE
+        };
+        gpio_dev_config_pin(dev->gpio, &out_config);
+        gpio_dev_set_level_source(dev->gpio, (uint32_t)ch->gpio_num, ledc_pin_level, ch);
+    }
+    ledc_refresh(dev, ch);
+    return true;
+}
+
+// Change a timer's frequency, keeping its resolution
+bool ledc_dev_set_freq(ledc_device_t *dev, uint32_t timer_num, uint32_t freq_hz) {
+    if (timer_num >= LEDC_TIMER_MAX || !dev->timers[timer_num].configured) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_LEDC, timer_num, 0, "ledc_set_freq");
+        return false;
+    }
+    
+    ledc_timer_config_t cfg = {
+        .timer_num = timer_num,
+        .freq_hz = freq_hz,
+        .duty_resolution = dev->timers[timer_num].duty_resolution
+    };
+    return ledc_dev_timer_config(dev, &cfg);
+}
+
+// Stage a new duty; it takes effect at ledc_dev_update_duty()
+bool ledc_dev_set_duty(ledc_device_t *dev, uint32_t channel, uint32_t duty) {
+    ledc_channel_t *ch = ledc_get(dev, channel, "ledc_set_duty");
+    if (!ch) {
+        return false;
+    }
+    if (duty > ledc_duty_full(dev, ch)) {
+        duty = ledc_duty_full(dev, ch);
+    }
+    ch->duty_pending = duty;
+    return true;
+}
+
+// Apply the staged duty, stopping any fade
+bool ledc_dev_update_duty(ledc_device_t *dev, uint32_t channel) {
+    ledc_channel_t *ch = ledc_get(dev, channel, "ledc_update_duty");
+    if (!ch) {
+        return false;
+    }
+    ledc_stop_fade(dev, ch);
+    ch->duty = ch->duty_pending;
+    ledc_refresh(dev, ch);
+    return true;
+}
+
+// Duty in effect now, part way through a fade if one is running
+uint32_t ledc_dev_get_duty(const ledc_device_t *dev, uint32_t channel) {
+    const ledc_channel_t *ch = ledc_find(dev, channel);
+    if (!ch) {
+        return 0;
+    }
+    return ledc_duty_at(ch, sim_clock_now(dev->clock));
+}
+
+// Duty meaning 100% on for a channel's timer
+uint32_t ledc_dev_get_duty_max(const ledc_device_t *dev, uint32_t channel) {
+    const ledc_channel_t *ch = ledc_find(dev, channel);
+    return ch ? ledc_duty_full(dev, ch) : 0;
+}
+
+// Stage a linear fade to 'target_duty' over 'max_fade_time_ms'
+bool ledc_dev_set_fade_with_time(ledc_device_t *dev, uint32_t channel, uint32_t target_duty,
+                                 uint32_t max_fade_time_ms) {
+    ledc_channel_t *ch = ledc_get(dev, channel, "ledc_set_fade_with_time");
+    if (!ch) {
+        return false;
+    }
+    if (max_fade_time_ms > LEDC_FADE_MAX_MS) {
+        SIM_LOGE(GPIO, SIM_EVT_GPIO_ERR_LEDC, channel, max_fade_time_ms, "ledc_set_fade_with_time");
+        return false;
+    }
+    if (target_duty > ledc_duty_full(dev, ch)) {
+        target_duty = ledc_duty_full(dev, ch);
+    }
+    ch->fade_target = target_duty;
+    ch->fade_time_ms = max_fade_time_ms;
+    ch->fade_set = true;
+    return true;
+}
+
+// Start the staged fade from the duty in effect now
+// The fade is evaluated on demand; only its end needs a timer.
+bool ledc_dev_fade_start(ledc_device_t *dev, uint32_t channel) {
+    ledc_channel_t *ch = ledc_get(dev, channel, "ledc_fade_start");
+    if (!ch || !ch->fade_set) {
+        return false;
+    }
+    
+    ledc_stop_fade(dev, ch);
+    ch->fade_set = false;
+    if (ch->fade_time_ms == 0 || ch->fade_target == ch->duty) {
+        ch->duty = ch->fade_target;
+        ledc_refresh(dev, ch);
+        return true;
+    }
+    
+    uint64_t now = sim_clock_now(dev->clock);
+    ch->fade_from = ch->duty;
+    ch->fade_to = ch->fade_target;
+    ch->fade_start_ns = now;
+    ch->fade_end_ns = now + (uint64_t)ch->fade_time_ms * SIM_CLOCK_NS_PER_MS;
+    ch->fading = true;
+    timer_wheel_arm(dev->wheel, &ch->fade_timer, ch->fade_end_ns);
+    ledc_refresh(dev, ch);
+    return true;
+}
+
+// Check whether a fade is running
+bool ledc_dev_is_fading(const ledc_device_t *dev, uint32_t channel) {
+    const ledc_channel_t *ch = ledc_find(dev, channel);
+    return ch && ch->fading;
+}
+
+// Write every edge of every routed channel to OUT (true), or only the
+// level at each API call (false); pin reads are exact either way
+void ledc_dev_set_observed(ledc_device_t *dev, bool observed) {
+    dev->observed = observed;
+    for (size_t i = 0; i < dev->capacity; i++) {
+        ledc_channel_t *ch = dev->channels[i];
+        if (!ch) {
+            continue;
+        }
+        if (observed) {
+            ledc_refresh(dev, ch);
+        } else {
+            timer_wheel_cancel(dev->wheel, &ch->edge_timer);
+        }
+    }
+}
+
+// Default-instance API
+
+// Get the device used by the default-instance functions
+ledc_device_t *ledc_default_device(void) {
+    return &default_device;
+}
+
+void ledc_init_all(void) {
+    ledc_dev_init(&default_device, gpio_default_device(), sim_clock_default(), timer_wheel_default());
+}
+
+bool ledc_timer_config(const ledc_timer_config_t *cfg) {
+    return ledc_dev_timer_config(&default_device, cfg);
+}
+
+bool ledc_channel_config(const ledc_channel_config_t *cfg) {
+    return ledc_dev_channel_config(&default_device, cfg);
+}
+
+bool ledc_set_freq(uint32_t timer_num, uint32_t freq_hz) {
+    return ledc_dev_set_freq(&default_device, timer_num, freq_hz);
+}
+
+bool ledc_set_duty(uint32_t channel, uint32_t duty) {
+    return ledc_dev_set_duty(&default_device, channel, duty);
+}
+
+bool ledc_update_duty(uint32_t channel) {
+    return ledc_dev_update_duty(&default_device, channel);
+}
+
+uint32_t ledc_get_duty(uint32_t channel) {
+    return ledc_dev_get_duty(&default_device, channel);
+}
+
+bool ledc_set_fade_with_time(uint32_t channel, uint32_t target_duty, uint32_t max_fade_time_ms) {
+    return ledc_dev_set_fade_with_time(&default_device, channel, target_duty, max_fade_time_ms);
+}
+
+bool ledc_fade_start(uint32_t channel) {
+    return ledc_dev_fade_start(&default_device, channel);
+}
+
+void ledc_set_observed(bool observed) {
+    ledc_dev_set_observed(&default_device, observed);
+}
@@ -3,107 +3,547 @@
 #include <unistd.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <string.h>
+#include <strings.h>
 #include "gpio_mock.h"
+#include "sim_log.h"
 #include "led_control.h"
 #include "button_control.h"
+#include "event_loop.h"
+#include "sim_clock.h"
+#include "stimulus.h"
+#include "trace.h"
+#include "latency.h"
+#include "vcd.h"
+#include "gpio_shm.h"
+#include "control_server.h"
+#include "snapshot.h"
+#include "ledc.h"
+#include "timer_wheel.h"
+#include "gpio_bounce.h"
+#include "rule_engine.h"
+#include "rt_loop.h"
+
+// Longest command line kept from stdin
+#define INPUT_LINE_MAX 64
+
+// Button events taken from the queue at a time
+#define BUTTON_EVENT_BATCH 16
 
 // Global flag for graceful shutdown
 static volatile bool running = true;
 
+// Threaded stimulus generators (--stimulus)
+static stimulus_t stimuli[STIMULUS_MAX_THREADS];
+static int num_stimuli = 0;
+static uint32_t stimulus_rate_hz = 0;
+
+// Trace replay (--replay) and recording (--record)
+static const char *replay_path = NULL;
+static bool replay_max_speed = true;
+static const char *replay_out_path = NULL;
+static trace_reader_t replay;
+static FILE *replay_out = NULL;
+static uint64_t replay_base_ns = 0;
+static const char *record_path = NULL;
+static trace_writer_t recorder;
+static uint64_t record_base_ns = 0;
+
+// Press-to-LED latency of each button
+static latency_tracker_t latency;
+
+// Waveform export (--vcd)
+static const char *vcd_path = NULL;
+static vcd_writer_t vcd;
+
+// Shared-memory register file (--shm)
+static const char *shm_name = NULL;
+static gpio_shm_t gpio_shm;
+
+// Binary control socket (--control)
+static const char *control_path = NULL;
+static control_server_t control;
+
+// Contact bounce on the board buttons (--bounce, --bounce-seed)
+static bool bounce_enabled = false;
+static gpio_bounce_config_t bounce_config;
+static uint64_t bounce_seed = 1;
+
+// Input-to-output rules (--rules, 'm <file>'); the board table by default
+static const char *rules_path = NULL;
+static rule_engine_t rules;
+
+// Write-combined LED output, committed once per tick (--write-combine)
+static bool write_combine = false;
+
+// Fixed-period real-time ticks (--rt)
+static bool rt_enabled = false;
+static rt_loop_config_t rt_config;
+static rt_loop_t rt;
+
+// Debounced presses acted upon
+static uint64_t button_actions = 0;
+
+// Checkpoints held for control clients (CONTROL_OP_SNAPSHOT / RESTORE)
+static void *checkpoints[CONTROL_SNAPSHOT_SLOTS];
+static size_t checkpoint_lens[CONTROL_SNAPSHOT_SLOTS];   // Checkpoint size, 0 = empty slot
+static size_t checkpoint_caps[CONTROL_SNAPSHOT_SLOTS];   // Bytes allocated
+static void *checkpoint_scratch;                         // Saves go here first
+static size_t checkpoint_scratch_cap;
+
 // Signal handler for graceful shutdown
 void signal_handler(int sig) {
-    printf("\n[MAIN] Received signal %d, shutting down...\n", sig);
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_SIGNAL, 0, (uint64_t)sig, NULL);
     running = false;
+    event_loop_wake();
 }
 
 // Display help menu
 void display_help(void) {
+    sim_log_flush();
     printf("\n=== ESP32 LED Control Simulation ===\n");
     printf("Commands:\n");
-    printf("  1, 2, 3    - Simulate button press on BTN1, BTN2, BTN3\n");
-    printf("  r1, r2, r3 - Simulate button release on BTN1, BTN2, BTN3\n");
+#define HELP_BUTTON(n, name, pin, led) printf("  %d, r%d      - Simulate button press, release on %s\n", n, n, #name);
+    BOARD_BUTTONS(HELP_BUTTON)
     printf("  s          - Show status of all LEDs and buttons\n");
+    printf("  t <ms>     - Advance the virtual clock (virtual/warp clock only)\n");
+    printf("  b<n> <pct> - Set the brightness of LED n (e.g. b2 25)\n");
+    printf("  f<n> <pct> <ms> - Fade LED n to a brightness (e.g. f1 0 2000)\n");
+    printf("  w <file>   - Write a checkpoint of the board (virtual/warp clock only)\n");
+    printf("  l <file>   - Load a checkpoint written by 'w'\n");
+    printf("  m <file>   - Load a rule table, replacing the current one\n");
     printf("  h          - Show this help menu\n");
     printf("  q          - Quit program\n");
-    printf("\nButton-LED mapping:\n");
-    printf("  BTN1 (Pin 18) -> LED1 (Pin 2)\n");
-    printf("  BTN2 (Pin 19) -> LED2 (Pin 4)\n");
-    printf("  BTN3 (Pin 21) -> LED3 (Pin 5)\n");
+    printf("\n");
+    rule_engine_print(&rules);
     printf("=====================================\n\n");
 }
 
-// Process button events and control LEDs
+// Process button events through the rule table
+// Drains the debounced event queue, so nothing runs when no button changed.
 void process_button_events(void) {
-    // Check each button for press events
-    if (button_was_pressed(BUTTON1_PIN)) {
-        printf("[MAIN] Button 1 pressed - Toggling LED1\n");
-        led_toggle(LED1_PIN);
+    button_event_t events[BUTTON_EVENT_BATCH];
+    size_t n;
+    
+    while ((n = button_get_events(events, BUTTON_EVENT_BATCH)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            button_actions += events[i].state == BUTTON_PRESSED;
+        }
+        rule_engine_process(&rules, events, n);
     }
+}
+
+// Sample inputs and react to debounced button events
+void service_inputs(void) {
+    // Fire due peripheral timers (PWM edges and fade ends)
+    timer_wheel_run(timer_wheel_default());
+    
+    // Update button states
+    button_update_all();
+    
+    // Process button events and control LEDs
+    process_button_events();
+    
+    // With write combining, the LED changes of the tick reach OUT together
+    led_commit();
+}
+
+// Earliest button debounce or peripheral timer deadline
+bool next_deadline(uint64_t *deadline_ns) {
+    uint64_t timer_deadline;
+    bool pending = button_next_deadline(deadline_ns);
     
-    if (button_was_pressed(BUTTON2_PIN)) {
-        printf("[MAIN] Button 2 pressed - Toggling LED2\n");
-        led_toggle(LED2_PIN);
+    if (timer_wheel_next_deadline(timer_wheel_default(), &timer_deadline) &&
+        (!pending || timer_deadline < *deadline_ns)) {
+        *deadline_ns = timer_deadline;
+        pending = true;
+    }
+    return pending;
+}
+
+// LED addressed by the digit after a command letter, -1 if none
+static int command_led(const char *input) {
+    switch (input[1]) {
+#define COMMAND_LED(n, name, pin) case '0' + (n): return (pin);
+        BOARD_LEDS(COMMAND_LED)
+        default:
+            return -1;
+    }
+}
+
+// Advance the virtual clock, stopping at every debounce deadline on the
+// way so events are handled at the time they are due
+void advance_clock(uint64_t delta_ns) {
+    if (!sim_clock_is_virtual()) {
+        SIM_LOGI(MAIN, SIM_EVT_MAIN_UNKNOWN_COMMAND, 0, 0, NULL);
+        return;
     }
     
-    if (button_was_pressed(BUTTON3_PIN)) {
-        printf("[MAIN] Button 3 pressed - Toggling LED3\n");
-        led_toggle(LED3_PIN);
+    uint64_t target = sim_clock_now_ns() + delta_ns;
+    uint64_t deadline;
+    while (next_deadline(&deadline) && deadline <= target) {
+        sim_clock_set_ns(deadline);
+        service_inputs();
     }
+    sim_clock_set_ns(target);
 }
 
-// Handle user input for simulation
-void handle_user_input(void) {
-    // Check if input is available (non-blocking)
-    fd_set readfds;
-    struct timeval timeout;
-    FD_ZERO(&readfds);
-    FD_SET(STDIN_FILENO, &readfds);
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 0;
+// Press or release a simulated button, recording it when --record is on
+void simulate_button(uint32_t button_pin, bool press) {
+    if (press) {
+        button_simulate_press(button_pin);
+    } else {
+        button_simulate_release(button_pin);
+    }
     
-    if (select(STDIN_FILENO + 1, &readfds, NULL, NULL, &timeout) > 0) {
-        char input[10];
-        if (fgets(input, sizeof(input), stdin) != NULL) {
-            switch (input[0]) {
-                case '1':
-                    button_simulate_press(BUTTON1_PIN);
-                    break;
-                case '2':
-                    button_simulate_press(BUTTON2_PIN);
-                    break;
-                case '3':
-                    button_simulate_press(BUTTON3_PIN);
+    if (record_path) {
+        trace_writer_append(&recorder, sim_clock_now_ns() - record_base_ns, button_pin, press);
+    }
+}
+
+// Save the board into 'buf' once every queued input has been handled
+// Returns the checkpoint size, 0 on error.
+size_t checkpoint_save(void *buf, size_t capacity) {
+    service_inputs();
+    return snapshot_take(buf, capacity);
+}
+
+// Roll the board back to a checkpoint. Not while stimulus threads drive
+// inputs or a waveform is written, which cannot go back in time; pending
+// latency measurements belong to the abandoned run and are dropped.
+bool checkpoint_restore(const void *buf, size_t len) {
+    if (num_stimuli > 0 || vcd_path) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, 0, num_stimuli > 0 ? "stimulus running" : "waveform dump running");
+        return false;
+    }
+    
+    // Chatter in flight belongs to the abandoned timeline
+    latency_tracker_stop(&latency);
+    gpio_bounce_reset();
+    rule_engine_reset(&rules);
+    uint64_t from_ns = sim_clock_now_ns();
+    bool ok = snapshot_load(buf, len);
+    latency_tracker_start(&latency);
+    
+    // LEDC fades and software timers are not part of a checkpoint: they
+    // keep the time they had left, counted from the restored time
+    if (ok) {
+        timer_wheel_rebase(timer_wheel_default(), from_ns);
+    }
+    return ok;
+}
+
+// Write a checkpoint file
+static void checkpoint_write(const char *path) {
+    snapshot_board_t board;
+    snapshot_default_board(&board);
+    size_t capacity = snapshot_size(&board);
+    void *buf = malloc(capacity);
+    size_t len = buf ? checkpoint_save(buf, capacity) : 0;
+    if (len && snapshot_write_file(path, buf, len)) {
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_SNAPSHOT_SAVE, 0, len, path);
+    }
+    free(buf);
+}
+
+// Roll back to a checkpoint file
+static void checkpoint_read(const char *path) {
+    size_t len;
+    void *buf = snapshot_read_file(path, &len);
+    if (buf && checkpoint_restore(buf, len)) {
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_SNAPSHOT_RESTORE, 0, sim_clock_now_ns(), path);
+    }
+    free(buf);
+}
+
+// File name after a one-letter command, trimmed; false if missing
+static bool command_path(const char *input, char *path, size_t size) {
+    input += strspn(input + 1, " ") + 1;
+    size_t len = strcspn(input, "\r\n");
+    while (len > 0 && input[len - 1] == ' ') {
+        len--;
+    }
+    if (len == 0 || len >= size) {
+        return false;
+    }
+    memcpy(path, input, len);
+    path[len] = '\0';
+    return true;
+}
+
+// Execute one command line typed at the prompt
+void handle_command(const char *input) {
+    switch (input[0]) {
+#define COMMAND_PRESS(n, name, pin, led) case '0' + (n): simulate_button((pin), true); break;
+        BOARD_BUTTONS(COMMAND_PRESS)
+        case 'r':
+            switch (input[1]) {
+#define COMMAND_RELEASE(n, name, pin, led) case '0' + (n): simulate_button((pin), false); break;
+                BOARD_BUTTONS(COMMAND_RELEASE)
+            }
+            break;
+        case 's':
+            led_display_status();
+            button_display_status();
+            latency_tracker_print(&latency);
+            if (rt_enabled) {
+                rt_loop_print(&rt);
+            }
+            break;
+        case 't':
+            advance_clock((uint64_t)strtoull(input + 1, NULL, 10) * SIM_CLOCK_NS_PER_MS);
+            break;
+        case 'b':
+        case 'f': {
+            int led = command_led(input);
+            if (led < 0) {
+                SIM_LOGI(MAIN, SIM_EVT_MAIN_UNKNOWN_COMMAND, 0, 0, NULL);
+                break;
+            }
+            char *end;
+            uint32_t percent = (uint32_t)strtoul(input + 2, &end, 10);
+            if (input[0] == 'b') {
+                led_set_brightness((uint32_t)led, percent);
+            } else {
+                led_fade_brightness((uint32_t)led, percent, (uint32_t)strtoul(end, NULL, 10));
+            }
+            break;
+        }
+        case 'w':
+        case 'l':
+        case 'm': {
+            char path[INPUT_LINE_MAX];
+            if (!command_path(input, path, sizeof(path))) {
+                SIM_LOGI(MAIN, SIM_EVT_MAIN_UNKNOWN_COMMAND, 0, 0, NULL);
+                break;
+            }
+            if (input[0] == 'w') {
+                checkpoint_write(path);
+            } else if (input[0] == 'l') {
+                checkpoint_read(path);
+            } else {
+                rule_engine_load_file(&rules, path);
+            }
+            // Log records point at 'path'
+            sim_log_flush();
+            break;
+        }
+        case 'h':
+            display_help();
+            break;
+        case 'q':
+            running = false;
+            break;
+        default:
+            SIM_LOGI(MAIN, SIM_EVT_MAIN_UNKNOWN_COMMAND, 0, 0, NULL);
+            break;
+    }
+}
+
+// Handle user input for simulation (called when stdin is readable)
+// Reads raw bytes so that several queued lines are all handled in one
+// wakeup instead of hiding in the stdio buffer.
+void handle_user_input(int fd, void *arg) {
+    static char line[INPUT_LINE_MAX];
+    static size_t line_len = 0;
+    char buf[256];
+    (void)arg;
+    
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) {
+        // EOF or error: stop watching stdin, keep running until a signal
+        event_loop_remove_fd(fd);
+        return;
+    }
+    
+    for (ssize_t i = 0; i < n && running; i++) {
+        if (buf[i] != '\n') {
+            if (line_len < sizeof(line) - 1) {
+                line[line_len++] = buf[i];
+            }
+            continue;
+        }
+        line[line_len++] = '\n';
+        line[line_len] = '\0';
+        line_len = 0;
+        
+        // Each command is a stimulus: sample it before the next one
+        handle_command(line);
+        service_inputs();
+    }
+}
+
+// Value of a counter readable over the control socket
+static bool control_counter(uint64_t counter, uint64_t *value) {
+    const button_controller_t *buttons = button_default_controller();
+    
+    switch (counter) {
+        case CONTROL_COUNTER_TIME_NS:
+            *value = sim_clock_now_ns();
+            return true;
+        case CONTROL_COUNTER_BATCHES:
+            *value = control.batches;
+            return true;
+        case CONTROL_COUNTER_OPS:
+            *value = control.ops;
+            return true;
+        case CONTROL_COUNTER_BUTTON_ACTIONS:
+            *value = button_actions;
+            return true;
+        case CONTROL_COUNTER_EDGE_OVERFLOWS:
+            *value = __atomic_load_n(&buttons->edge_overflows, __ATOMIC_RELAXED);
+            return true;
+        case CONTROL_COUNTER_EVENT_OVERFLOWS:
+            *value = buttons->event_overflows;
+            return true;
+        case CONTROL_COUNTER_LATENCY_SAMPLES:
+            *value = latency_tracker_samples(&latency);
+            return true;
+        case CONTROL_COUNTER_COALESCED_WRITES: {
+            const led_controller_t *leds = led_default_controller();
+            *value = leds->combined_writes - leds->committed_writes;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Drive input pins from a control batch, recording each edge when
+// --record is on; returns the pins that changed
+static uint64_t control_drive_inputs(uint64_t mask, bool high) {
+    uint64_t changed = gpio_dev_drive_inputs(gpio_default_device(), mask, high ? mask : 0);
+    
+    if (record_path) {
+        uint64_t t = sim_clock_now_ns() - record_base_ns;
+        for (uint64_t work = changed; work; work &= work - 1) {
+            trace_writer_append(&recorder, t, (uint32_t)__builtin_ctzll(work), !high);
+        }
+    }
+    return changed;
+}
+
+// Save into or restore from a checkpoint slot; the value is the
+// checkpoint size after a save and the restored time after a restore
+// A save goes to a scratch buffer that replaces the slot's only once it
+// succeeded, so a failed save keeps the previous checkpoint.
+static uint32_t control_checkpoint(uint32_t opcode, size_t slot, uint64_t *value) {
+    if (opcode == CONTROL_OP_RESTORE) {
+        if (!checkpoint_lens[slot] || !checkpoint_restore(checkpoints[slot], checkpoint_lens[slot])) {
+            return CONTROL_ERR_STATE;
+        }
+        *value = sim_clock_now_ns();
+        return CONTROL_OK;
+    }
+    
+    snapshot_board_t board;
+    snapshot_default_board(&board);
+    size_t capacity = snapshot_size(&board);
+    if (checkpoint_scratch_cap < capacity) {
+        void *buf = realloc(checkpoint_scratch, capacity);
+        if (!buf) {
+            return CONTROL_ERR_STATE;
+        }
+        checkpoint_scratch = buf;
+        checkpoint_scratch_cap = capacity;
+    }
+    size_t len = checkpoint_save(checkpoint_scratch, capacity);
+    if (!len) {
+        return CONTROL_ERR_STATE;
+    }
+    
+    void *old = checkpoints[slot];
+    size_t old_cap = checkpoint_caps[slot];
+    checkpoints[slot] = checkpoint_scratch;
+    checkpoint_caps[slot] = checkpoint_scratch_cap;
+    checkpoint_lens[slot] = len;
+    checkpoint_scratch = old;
+    checkpoint_scratch_cap = old_cap;
+    *value = len;
+    return CONTROL_OK;
+}
+
+// Execute one control batch as a single tick: its input changes are
+// sampled together once the batch is done. An advance first samples the
+// inputs driven so far, so their debounce deadlines fall on the way.
+static void control_batch(void *arg, const control_op_t *ops, control_result_t *results, size_t count) {
+    gpio_device_t *gpio = gpio_default_device();
+    const led_controller_t *leds = led_default_controller();
+    bool driven = false;
+    (void)arg;
+    
+    for (size_t i = 0; i < count; i++) {
+        const control_op_t *op = &ops[i];
+        control_result_t *res = &results[i];
+        uint64_t inputs = __atomic_load_n(&gpio->configured, __ATOMIC_ACQUIRE) &
+                          ~__atomic_load_n(&gpio->enable, __ATOMIC_ACQUIRE);
+        
+        switch (op->opcode) {
+            case CONTROL_OP_NOP:
+                break;
+            case CONTROL_OP_SET_INPUTS:
+            case CONTROL_OP_CLEAR_INPUTS:
+                if (op->a & ~inputs) {
+                    res->status = CONTROL_ERR_ARG;
                     break;
-                case 'r':
-                    if (input[1] == '1') {
-                        button_simulate_release(BUTTON1_PIN);
-                    } else if (input[1] == '2') {
-                        button_simulate_release(BUTTON2_PIN);
-                    } else if (input[1] == '3') {
-                        button_simulate_release(BUTTON3_PIN);
+                }
+                res->value = control_drive_inputs(op->a, op->opcode == CONTROL_OP_SET_INPUTS);
+                driven |= res->value != 0;
+                break;
+            case CONTROL_OP_READ_LEVELS:
+                res->value = gpio_dev_read_all(gpio);
+                break;
+            case CONTROL_OP_LED_STATES:
+                for (size_t k = 0; k < leds->count; k++) {
+                    if (leds->leds[k].state == LED_ON) {
+                        res->value |= GPIO_PIN_SEL(leds->leds[k].pin);
                     }
+                }
+                break;
+            case CONTROL_OP_LED_BRIGHTNESS:
+                if (op->a >= GPIO_NUM_MAX || leds->pin_index[op->a] < 0) {
+                    res->status = CONTROL_ERR_ARG;
                     break;
-                case 's':
-                    led_display_status();
-                    button_display_status();
-                    break;
-                case 'h':
-                    display_help();
-                    break;
-                case 'q':
-                    running = false;
+                }
+                res->value = led_get_brightness((uint32_t)op->a);
+                break;
+            case CONTROL_OP_READ_COUNTER:
+                if (!control_counter(op->a, &res->value)) {
+                    res->status = CONTROL_ERR_ARG;
+                }
+                break;
+            case CONTROL_OP_ADVANCE:
+                if (!sim_clock_is_virtual()) {
+                    res->status = CONTROL_ERR_STATE;
                     break;
-                default:
-                    printf("[MAIN] Unknown command. Type 'h' for help.\n");
+                }
+                if (driven) {
+                    service_inputs();
+                    driven = false;
+                }
+                advance_clock(op->a);
+                res->value = sim_clock_now_ns();
+                break;
+            case CONTROL_OP_SNAPSHOT:
+            case CONTROL_OP_RESTORE:
+                if (op->a >= CONTROL_SNAPSHOT_SLOTS) {
+                    res->status = CONTROL_ERR_ARG;
                     break;
-            }
+                }
+                res->status = control_checkpoint(op->opcode, (size_t)op->a, &res->value);
+                driven = false;
+                break;
+            default:
+                res->status = CONTROL_ERR_OPCODE;
+                break;
         }
     }
+    service_inputs();
 }
 
 // Initialize all systems
 void system_init(void) {
-    printf("[MAIN] Starting ESP32 LED Control Simulation...\n");
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_STARTING, 0, 0, NULL);
     
     // Initialize GPIO mock system
     gpio_mock_init();
@@ -114,59 +554,553 @@ void system_init(void) {
     // Initialize buttons
     button_init_all();
     
-    printf("[MAIN] System initialization complete!\n\n");
+    // LED brightness comes from the LEDC peripheral on the shared timer wheel
+    ledc_init_all();
+    led_ctrl_attach_ledc(led_default_controller(), ledc_default_device());
+    led_set_write_combining(write_combine);
+    
+    // Simulated presses and releases of the buttons bounce, if requested
+    if (bounce_enabled) {
+        gpio_bounce_init_all(bounce_seed);
+#define BOUNCE_BUTTON(n, name, pin, led) gpio_bounce_set_pin((pin), &bounce_config);
+        BOARD_BUTTONS(BOUNCE_BUTTON)
+    }
+    
+    // Time every press until its LED changes
+    latency_tracker_init(&latency, gpio_default_device(), sim_clock_default());
+#define LATENCY_PAIR(n, name, pin, led) \
+    latency_tracker_add(&latency, (pin), BOARD_PIN_##led, button_get_name(pin), led_get_name(BOARD_PIN_##led));
+    BOARD_BUTTONS(LATENCY_PAIR)
+    latency_tracker_start(&latency);
+    
+    // Button presses toggle their LEDs until a rule table is loaded
+    rule_engine_init(&rules, led_default_controller(), timer_wheel_default());
+    rule_engine_load_board(&rules);
+    
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_INIT_DONE, 0, 0, NULL);
+    sim_log_flush();
+}
+
+// Print LED transitions seen during a replay, one "<ms> <LED> ON|OFF" line each
+static void replay_emit_leds(void *arg, uint64_t changed, uint64_t levels) {
+    FILE *out = arg;
+    uint64_t t = sim_clock_now_ns() - replay_base_ns;
+    
+    while (changed) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(changed);
+        changed &= changed - 1;
+        fprintf(out, "%llu.%06llu %s %s\n",
+                (unsigned long long)(t / SIM_CLOCK_NS_PER_MS),
+                (unsigned long long)(t % SIM_CLOCK_NS_PER_MS),
+                led_get_name(pin), ((levels >> pin) & 1) ? "ON" : "OFF");
+    }
+}
+
+// Open the trace and the transition output, returns false on failure
+bool replay_start(void) {
+    if (!trace_open(&replay, replay_path)) {
+        return false;
+    }
+    
+    replay_out = replay_out_path ? fopen(replay_out_path, "w") : stdout;
+    if (!replay_out) {
+        perror("[MAIN ERROR] replay output");
+        trace_close(&replay);
+        return false;
+    }
+    
+    replay_base_ns = sim_clock_now_ns();
+    if (!gpio_dev_add_watch(gpio_default_device(), led_default_controller()->pin_mask,
+                            replay_emit_leds, replay_out)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TRACE_ERR_WATCH, 0, 0, replay_path);
+        if (replay_out != stdout) {
+            fclose(replay_out);
+        }
+        trace_close(&replay);
+        return false;
+    }
+    return true;
+}
+
+// Feed every trace event that is due, each as its own stimulus
+void replay_feed_due(void) {
+    uint64_t now = sim_clock_now_ns();
+    const trace_record_t *ev;
+    
+    while ((ev = trace_peek(&replay)) && replay_base_ns + ev->time_ns <= now) {
+        simulate_button(ev->pin, ev->press != 0);
+        trace_next(&replay);
+        service_inputs();
+    }
+}
+
+// Time of the next trace event; false once the trace is exhausted
+bool replay_next_time(uint64_t *time_ns) {
+    const trace_record_t *ev = trace_peek(&replay);
+    if (!ev) {
+        return false;
+    }
+    *time_ns = replay_base_ns + ev->time_ns;
+    return true;
+}
+
+// Detach the transition output before shutdown turns the LEDs off
+void replay_finish(void) {
+    SIM_LOGI(SIMULATION, SIM_EVT_SIM_REPLAY_DONE, 0, replay.index, NULL);
+    gpio_dev_remove_watch(gpio_default_device(), replay_emit_leds, replay_out);
+    if (replay_out != stdout) {
+        fclose(replay_out);
+    } else {
+        fflush(stdout);
+    }
+    trace_close(&replay);
 }
 
 // Main application loop
+// Sleeps until stdin is readable, a wakeup is posted, or the next button
+// debounce or trace event deadline expires; there is no fixed polling period.
+// A replay ends once the trace is exhausted and every button has settled.
 void app_loop(void) {
-    printf("[MAIN] Entering main loop. Type 'h' for help, 'q' to quit.\n\n");
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_LOOP_ENTER, 0, 0, NULL);
+    
+    if (!replay_path && !event_loop_add_fd(STDIN_FILENO, handle_user_input, NULL)) {
+        printf("[MAIN ERROR] Cannot watch stdin\n");
+    }
+    if (rt_enabled) {
+        rt_loop_start(&rt, &rt_config);
+    }
     
     while (running) {
-        // Update button states
-        button_update_all();
+        // Service edges and expired debounce deadlines
+        service_inputs();
+        if (replay_path) {
+            replay_feed_due();
+        }
         
-        // Process button events and control LEDs
-        process_button_events();
+        // Write out everything logged during this tick in one batch
+        sim_log_flush();
         
-        // Handle user input for simulation
-        handle_user_input();
+        uint64_t deadline;
+        bool pending = button_next_deadline(&deadline);
         
-        // Small delay to prevent excessive CPU usage
-        usleep(10000); // 10ms delay
+        if (replay_path) {
+            uint64_t event_time;
+            if (replay_next_time(&event_time)) {
+                if (!pending || event_time < deadline) {
+                    deadline = event_time;
+                }
+                pending = true;
+            } else if (!pending) {
+                break;
+            }
+        }
+        
+        // PWM timers run for as long as a channel is dimmed, so they do
+        // not keep a finished replay alive
+        uint64_t timer_deadline;
+        if (timer_wheel_next_deadline(timer_wheel_default(), &timer_deadline) &&
+            (!pending || timer_deadline < deadline)) {
+            deadline = timer_deadline;
+            pending = true;
+        }
+        
+        // Real-time mode: take whatever input is queued, then sleep to the
+        // next absolute tick deadline whatever is pending
+        if (rt_enabled) {
+            event_loop_wait(false);
+            rt_loop_wait(&rt);
+            continue;
+        }
+        
+        switch (sim_clock_get_mode()) {
+            case SIM_CLOCK_REALTIME:
+                // Sleep until the earliest deadline, or indefinitely
+                if (pending) {
+                    event_loop_arm_deadline(deadline);
+                } else {
+                    event_loop_disarm_timer();
+                }
+                event_loop_wait(true);
+                break;
+            case SIM_CLOCK_VIRTUAL:
+                // Time only moves with the 't' command
+                event_loop_wait(true);
+                break;
+            case SIM_CLOCK_WARP:
+                // Take any queued input first, then jump to the deadline;
+                // a replay has no other input to wait for
+                if (!pending) {
+                    event_loop_wait(true);
+                } else if (replay_path || event_loop_wait(false) == 0) {
+                    sim_clock_warp_to(deadline);
+                }
+                break;
+        }
     }
 }
 
+// Start the stimulus threads on every button pin
+// They wake the event loop after each edge; bursts coalesce into one wakeup.
+void stimulus_start_all(void) {
+    if (num_stimuli == 0) {
+        return;
+    }
+    
+    stimulus_config_t cfg = {
+        .gpio = gpio_default_device(),
+        .pins = button_default_controller()->pin_mask,
+        .rate_hz = stimulus_rate_hz,
+        .max_edges = 0,
+        .seed = 0,
+        .notify = event_loop_wake
+    };
+    for (int i = 0; i < num_stimuli; i++) {
+        cfg.seed = 0x9E3779B9u * (uint32_t)(i + 1);
+        if (!stimulus_start(&stimuli[i], &cfg)) {
+            printf("[MAIN ERROR] Cannot start stimulus thread %d\n", i);
+        }
+    }
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_STIMULUS_START, (uint32_t)num_stimuli, stimulus_rate_hz, NULL);
+}
+
+// Open the waveform dump, naming each LED and button signal
+bool vcd_start(void) {
+    if (!vcd_writer_open(&vcd, vcd_path, gpio_default_device(), sim_clock_default())) {
+        return false;
+    }
+    
+    for (uint64_t pins = BOARD_PIN_MASK; pins; pins &= pins - 1) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(pins);
+        vcd_writer_label(&vcd, pin, board_pin_name(pin));
+    }
+    
+    if (!vcd_writer_start(&vcd)) {
+        vcd_writer_close(&vcd);
+        return false;
+    }
+    
+    // Every PWM edge belongs in the waveform
+    ledc_set_observed(true);
+    return true;
+}
+
+// Stop the stimulus threads and report how many edges they drove
+void stimulus_stop_all(void) {
+    if (num_stimuli == 0) {
+        return;
+    }
+    
+    uint64_t edges = 0;
+    for (int i = 0; i < num_stimuli; i++) {
+        stimulus_stop(&stimuli[i]);
+        edges += stimulus_edges(&stimuli[i]);
+    }
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_STIMULUS_DONE, 0, edges, NULL);
+    
+    // Take the edges still queued so the final status is settled
+    service_inputs();
+}
+
 // Cleanup and shutdown
 void system_shutdown(void) {
-    printf("\n[MAIN] Shutting down system...\n");
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_SHUTDOWN_BEGIN, 0, 0, NULL);
+    
+    // Turning the LEDs off is not a response to a press
+    latency_tracker_stop(&latency);
     
     // Turn off all LEDs
     led_all_off();
+    led_commit();
     
     // Display final status
     printf("\n=== Final System Status ===\n");
     led_display_status();
     button_display_status();
+    latency_tracker_print(&latency);
+    latency_tracker_deinit(&latency);
+    if (rt_enabled) {
+        rt_loop_print(&rt);
+        rt_loop_stop(&rt);
+    }
+    
+    SIM_LOGI(MAIN, SIM_EVT_MAIN_SHUTDOWN_DONE, 0, 0, NULL);
+    sim_log_flush();
+}
+
+// Print command line usage
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --log-level LEVEL         Set all modules to off|error|info|debug\n");
+    printf("  --log-level MODULE=LEVEL  Set one module (gpio, led, button, main, simulation)\n");
+    printf("  --log-timestamps          Prefix log lines with the simulation timestamp\n");
+    printf("  --clock real|virtual|warp Select the time source (default: real)\n");
+    printf("  --debounce timestamp|vertical\n");
+    printf("                            Select the button debounce engine (default: timestamp)\n");
+    printf("  --write-combine           Batch LED writes in a shadow register, committed once per tick\n");
+    printf("  --rt PERIOD_US[:fifo=PRIO][:cpu=N][:lock]\n");
+    printf("                            Tick every PERIOD_US on absolute deadlines (real clock only),\n");
+    printf("                            optionally SCHED_FIFO, pinned to a CPU, memory locked\n");
+    printf("  --stimulus THREADS[:RATE] Drive random button edges from THREADS threads,\n");
+    printf("                            RATE edges/s each (default: unpaced)\n");
+    printf("  --bounce N[-M][:MIN-MAX][:uniform|decaying]\n");
+    printf("                            Bounce simulated presses/releases: N to M away-and-back\n");
+    printf("                            pairs, MIN-MAX us apart (default 50-1000, uniform)\n");
+    printf("  --bounce-seed SEED        Seed of the bounce generators (default: 1)\n");
+    printf("  --rules FILE              Map inputs to outputs with the rule table in FILE\n");
+    printf("                            (default: each button press toggles its LED)\n");
+    printf("  --replay FILE             Replay a binary or text trace headless, printing LED transitions\n");
+    printf("  --replay-speed max|recorded\n");
+    printf("                            Replay as fast as possible (default) or at the recorded pace\n");
+    printf("  --replay-out FILE         Write replayed LED transitions to FILE instead of stdout\n");
+    printf("  --record FILE             Record simulated presses/releases as a binary trace\n");
+    printf("  --vcd FILE                Dump every GPIO level change to FILE as a VCD waveform\n");
+    printf("  --shm NAME                Publish the GPIO registers in POSIX shared memory NAME\n");
+    printf("                            (e.g. /esp32_led_sim) and take input drives from it\n");
+    printf("  --control PATH            Accept binary control batches on Unix socket PATH\n");
+    printf("  --help                    Show this message\n");
+}
+
+// Apply a --log-level argument, returns false if it cannot be parsed
+static bool apply_log_level(const char *arg) {
+    static const char *const modules[SIM_LOG_MODULE_COUNT] = {
+        "gpio", "led", "button", "main", "simulation"
+    };
+    const char *eq = strchr(arg, '=');
     
-    printf("[MAIN] System shutdown complete. Goodbye!\n");
+    if (!eq) {
+        int level = sim_log_parse_level(arg);
+        if (level < 0) {
+            return false;
+        }
+        sim_log_set_level_all(level);
+        return true;
+    }
+    
+    int level = sim_log_parse_level(eq + 1);
+    if (level < 0) {
+        return false;
+    }
+    for (int i = 0; i < SIM_LOG_MODULE_COUNT; i++) {
+        if (strlen(modules[i]) == (size_t)(eq - arg) &&
+            strncasecmp(arg, modules[i], (size_t)(eq - arg)) == 0) {
+            sim_log_set_level((sim_log_module_t)i, level);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Apply a --stimulus argument, returns false if it cannot be parsed
+static bool apply_stimulus(const char *arg) {
+    char *end;
+    long threads = strtol(arg, &end, 10);
+    if (end == arg || threads < 1 || threads > STIMULUS_MAX_THREADS) {
+        return false;
+    }
+    
+    unsigned long rate = 0;
+    if (*end == ':') {
+        const char *rate_str = end + 1;
+        rate = strtoul(rate_str, &end, 10);
+        if (end == rate_str || rate > UINT32_MAX) {
+            return false;
+        }
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    
+    num_stimuli = (int)threads;
+    stimulus_rate_hz = (uint32_t)rate;
+    return true;
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
+    sim_clock_mode_t clock_mode = SIM_CLOCK_REALTIME;
+    
+    // Parse command line options
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            if (!apply_log_level(argv[++i])) {
+                fprintf(stderr, "Invalid log level: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--log-timestamps") == 0) {
+            sim_log_set_timestamps(true);
+        } else if (strcmp(argv[i], "--clock") == 0 && i + 1 < argc) {
+            int mode = sim_clock_parse_mode(argv[++i]);
+            if (mode < 0) {
+                fprintf(stderr, "Invalid clock: %s\n", argv[i]);
+                return 1;
+            }
+            clock_mode = (sim_clock_mode_t)mode;
+        } else if (strcmp(argv[i], "--debounce") == 0 && i + 1 < argc) {
+            int engine = button_parse_engine(argv[++i]);
+            if (engine < 0) {
+                fprintf(stderr, "Invalid debounce engine: %s\n", argv[i]);
+                return 1;
+            }
+            button_set_default_engine((button_debounce_engine_t)engine);
+        } else if (strcmp(argv[i], "--write-combine") == 0) {
+            write_combine = true;
+        } else if (strcmp(argv[i], "--rt") == 0 && i + 1 < argc) {
+            if (!rt_loop_parse(argv[++i], &rt_config)) {
+                fprintf(stderr, "Invalid real-time settings: %s\n", argv[i]);
+                return 1;
+            }
+            rt_enabled = true;
+        } else if (strcmp(argv[i], "--stimulus") == 0 && i + 1 < argc) {
+            if (!apply_stimulus(argv[++i])) {
+                fprintf(stderr, "Invalid stimulus: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bounce") == 0 && i + 1 < argc) {
+            if (!gpio_bounce_parse(argv[++i], &bounce_config)) {
+                fprintf(stderr, "Invalid bounce model: %s\n", argv[i]);
+                return 1;
+            }
+            bounce_enabled = true;
+        } else if (strcmp(argv[i], "--bounce-seed") == 0 && i + 1 < argc) {
+            bounce_seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            rules_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "max") == 0) {
+                replay_max_speed = true;
+            } else if (strcmp(argv[i], "recorded") == 0) {
+                replay_max_speed = false;
+            } else {
+                fprintf(stderr, "Invalid replay speed: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--replay-out") == 0 && i + 1 < argc) {
+            replay_out_path = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--vcd") == 0 && i + 1 < argc) {
+            vcd_path = argv[++i];
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--control") == 0 && i + 1 < argc) {
+            control_path = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    // A replay picks its own time source: warp for maximum speed, the
+    // wall clock for the recorded pace
+    if (replay_path) {
+        clock_mode = replay_max_speed ? SIM_CLOCK_WARP : SIM_CLOCK_REALTIME;
+    }
+    
+    // Tick deadlines are wall-clock times
+    if (rt_enabled && clock_mode != SIM_CLOCK_REALTIME) {
+        fprintf(stderr, "--rt needs the real clock\n");
+        return 1;
+    }
+    
+    // Select the time source and start logging before anything runs
+    sim_clock_init(clock_mode);
+    sim_log_init();
+    
+    if (!event_loop_init()) {
+        return 1;
+    }
+    
     // Set up signal handlers for graceful shutdown
     signal(SIGINT, signal_handler);   // Ctrl+C
     signal(SIGTERM, signal_handler);  // Termination signal
     
     // Initialize system
     system_init();
+    if (rules_path && !rule_engine_load_file(&rules, rules_path)) {
+        rule_engine_deinit(&rules);
+        event_loop_deinit();
+        sim_log_shutdown();
+        return 1;
+    }
+    
+    // Headless replay, or the interactive prompt
+    if (replay_path) {
+        if (!replay_start()) {
+            event_loop_deinit();
+            sim_log_shutdown();
+            return 1;
+        }
+    } else {
+        display_help();
+    }
     
-    // Show help menu
-    display_help();
+    if (record_path) {
+        record_base_ns = sim_clock_now_ns();
+        if (!trace_writer_open(&recorder, record_path)) {
+            record_path = NULL;
+        }
+    }
+    
+    if (vcd_path && !vcd_start()) {
+        vcd_path = NULL;
+    }
+    
+    // External drives wake the loop like stimulus edges
+    if (shm_name) {
+        if (!gpio_shm_create(&gpio_shm, shm_name, gpio_default_device(), sim_clock_default())) {
+            shm_name = NULL;
+        } else if (!gpio_shm_start(&gpio_shm, event_loop_wake)) {
+            gpio_shm_close(&gpio_shm);
+            shm_name = NULL;
+        }
+    }
+    
+    if (control_path && !control_server_open(&control, control_path, control_batch, NULL)) {
+        control_path = NULL;
+    }
+    
+    // Start concurrent input sources, if requested
+    stimulus_start_all();
     
     // Run main application loop
     app_loop();
     
     // Cleanup and shutdown
+    if (control_path) {
+        control_server_close(&control);
+    }
+    for (int i = 0; i < CONTROL_SNAPSHOT_SLOTS; i++) {
+        free(checkpoints[i]);
+    }
+    free(checkpoint_scratch);
+    stimulus_stop_all();
+    if (replay_path) {
+        replay_finish();
+    }
+    if (record_path) {
+        trace_writer_close(&recorder);
+    }
     system_shutdown();
+    if (vcd_path) {
+        ledc_set_observed(false);
+        vcd_writer_close(&vcd);
+    }
+    if (shm_name) {
+        gpio_shm_close(&gpio_shm);
+    }
+    if (bounce_enabled) {
+        gpio_bounce_dev_deinit(gpio_bounce_default_device());
+    }
+    rule_engine_deinit(&rules);
+    ledc_dev_deinit(ledc_default_device());
+    
+    event_loop_deinit();
+    sim_log_shutdown();
     
     return 0;
 }
\ No newline at end of file
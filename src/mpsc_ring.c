@@ -0,0 +1,116 @@
+#include "mpsc_ring.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Bounded MPSC queue after Dmitry Vyukov's per-slot sequence design.
+// Each slot carries a sequence number: seq == pos means free for the
+// producer claiming pos, seq == pos + 1 means filled and ready to pop.
+
+// Slot header preceding the payload
+typedef struct {
+    size_t seq;
+} mpsc_slot_t;
+
+// Address of the slot used for a ring position
+static inline mpsc_slot_t *mpsc_slot_at(const mpsc_ring_t *ring, size_t pos) {
+    return (mpsc_slot_t *)(ring->slots + (pos & ring->mask) * ring->slot_size);
+}
+
+// Round capacity up to the next power of two
+static size_t mpsc_round_pow2(size_t n) {
+    size_t cap = 2;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+// Allocate storage for a ring of at least 'capacity' elements
+bool mpsc_ring_init(mpsc_ring_t *ring, size_t capacity, size_t elem_size) {
+    if (!ring || elem_size == 0) {
+        return false;
+    }
+    
+    memset(ring, 0, sizeof(*ring));
+    capacity = mpsc_round_pow2(capacity);
+    ring->mask = capacity - 1;
+    ring->elem_size = elem_size;
+    ring->slot_size = (sizeof(mpsc_slot_t) + elem_size + 7) & ~(size_t)7;
+    ring->slots = malloc(capacity * ring->slot_size);
+    if (!ring->slots) {
+        return false;
+    }
+    
+    for (size_t pos = 0; pos < capacity; pos++) {
+        mpsc_slot_at(ring, pos)->seq = pos;
+    }
+    return true;
+}
+
+// Release ring storage
+void mpsc_ring_free(mpsc_ring_t *ring) {
+    if (ring) {
+        free(ring->slots);
+        ring->slots = NULL;
+    }
+}
+
+// Push one element; safe to call from any number of threads
+bool mpsc_ring_push(mpsc_ring_t *ring, const void *elem) {
+    size_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    mpsc_slot_t *slot;
+    
+    for (;;) {
+        slot = mpsc_slot_at(ring, pos);
+        size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            // Consumer has not freed this slot yet: ring is full
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+    
+    memcpy(slot + 1, elem, ring->elem_size);
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Pop one element; only one thread may consume
+bool mpsc_ring_pop(mpsc_ring_t *ring, void *elem) {
+    size_t pos = ring->head;
+    mpsc_slot_t *slot = mpsc_slot_at(ring, pos);
+    
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+        return false;
+    }
+    
+    memcpy(elem, slot + 1, ring->elem_size);
+    __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+    ring->head = pos + 1;
+    return true;
+}
+
+// Pop up to 'max' elements into a contiguous array
+size_t mpsc_ring_pop_batch(mpsc_ring_t *ring, void *elems, size_t max) {
+    unsigned char *out = elems;
+    size_t count = 0;
+    
+    while (count < max && mpsc_ring_pop(ring, out + count * ring->elem_size)) {
+        count++;
+    }
+    return count;
+}
+
+// Check whether the consumer has anything to pop
+bool mpsc_ring_is_empty(const mpsc_ring_t *ring) {
+    const mpsc_slot_t *slot = mpsc_slot_at(ring, ring->head);
+    return __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ring->head + 1;
+}
@@ -0,0 +1,167 @@
+#define _GNU_SOURCE  // sched_setaffinity(), CPU_SET()
+#include "rt_loop.h"
+#include "sim_clock.h"
+#include "sim_log.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// Parse "PERIOD_US[:fifo=PRIO][:cpu=N][:lock]", e.g. "1000:fifo=80:cpu=2:lock"
+bool rt_loop_parse(const char *spec, rt_loop_config_t *config) {
+    char *end;
+    rt_loop_config_t cfg = {.priority = 0, .cpu = -1, .lock_memory = false};
+    
+    unsigned long period_us = strtoul(spec, &end, 10);
+    if (end == spec || period_us < RT_LOOP_MIN_PERIOD_US || period_us > RT_LOOP_MAX_PERIOD_US) {
+        return false;
+    }
+    cfg.period_ns = (uint64_t)period_us * SIM_CLOCK_NS_PER_US;
+    
+    while (*end == ':') {
+        const char *opt = end + 1;
+        if (strncmp(opt, "fifo=", 5) == 0) {
+            long prio = strtol(opt + 5, &end, 10);
+            if (end == opt + 5 || prio < sched_get_priority_min(SCHED_FIFO) ||
+                prio > sched_get_priority_max(SCHED_FIFO)) {
+                return false;
+            }
+            cfg.priority = (int)prio;
+        } else if (strncmp(opt, "cpu=", 4) == 0) {
+            long cpu = strtol(opt + 4, &end, 10);
+            if (end == opt + 4 || cpu < 0 || cpu >= CPU_SETSIZE) {
+                return false;
+            }
+            cfg.cpu = (int)cpu;
+        } else if (strncmp(opt, "lock", 4) == 0) {
+            cfg.lock_memory = true;
+            end = (char *)opt + 4;
+        } else {
+            return false;
+        }
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    *config = cfg;
+    return true;
+}
+
+// Apply the scheduling, affinity and memory settings to the calling
+// thread and set the first deadline one period from now. A setting the
+// process may not use (e.g. SCHED_FIFO without CAP_SYS_NICE) is logged
+// and left out; rt_loop_print() shows what is in effect.
+void rt_loop_start(rt_loop_t *rt, const rt_loop_config_t *config) {
+    memset(rt, 0, sizeof(*rt));
+    rt->config = *config;
+    latency_hist_reset(&rt->exec);
+    latency_hist_reset(&rt->jitter);
+    
+    if (config->lock_memory) {
+        rt->locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+        if (!rt->locked) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_RT_ERR, 0, (uint64_t)errno, "mlockall");
+        }
+    }
+    if (config->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(config->cpu, &set);
+        rt->pinned = sched_setaffinity(0, sizeof(set), &set) == 0;
+        if (!rt->pinned) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_RT_ERR, (uint32_t)config->cpu, (uint64_t)errno, "CPU affinity");
+        }
+    }
+    if (config->priority > 0) {
+        struct sched_param param = {.sched_priority = config->priority};
+        rt->fifo = sched_setscheduler(0, SCHED_FIFO, &param) == 0;
+        if (!rt->fifo) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_RT_ERR, (uint32_t)config->priority, (uint64_t)errno, "SCHED_FIFO");
+        }
+    }
+    
+    rt->wake_ns = sim_clock_monotonic_ns();
+    rt->deadline_ns = rt->wake_ns;
+    SIM_LOGI(SIMULATION, SIM_EVT_SIM_RT_START, (uint32_t)config->priority, config->period_ns, NULL);
+}
+
+// Go back to the normal policy and unlock memory
+void rt_loop_stop(rt_loop_t *rt) {
+    if (rt->fifo) {
+        struct sched_param param = {.sched_priority = 0};
+        sched_setscheduler(0, SCHED_OTHER, &param);
+        rt->fifo = false;
+    }
+    if (rt->locked) {
+        munlockall();
+        rt->locked = false;
+    }
+}
+
+// End the current tick and sleep until the next deadline
+// Returns false if a signal cut the sleep short; the tick is then not
+// counted and the next call sleeps to the same deadline.
+bool rt_loop_wait(rt_loop_t *rt) {
+    uint64_t period = rt->config.period_ns;
+    uint64_t now = sim_clock_monotonic_ns();
+    
+    if (rt->wake_ns) {
+        latency_hist_record(&rt->exec, now - rt->wake_ns);
+        rt->wake_ns = 0;
+        rt->deadline_ns += period;
+        if (now > rt->deadline_ns) {
+            uint64_t skipped = (now - rt->deadline_ns) / period + 1;
+            rt->overruns++;
+            rt->missed += skipped;
+            rt->deadline_ns += skipped * period;
+        }
+    }
+    
+    struct timespec ts = {
+        .tv_sec = (time_t)(rt->deadline_ns / SIM_CLOCK_NS_PER_SEC),
+        .tv_nsec = (long)(rt->deadline_ns % SIM_CLOCK_NS_PER_SEC)
+    };
+    int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    if (err != 0) {
+        return false;
+    }
+    
+    rt->wake_ns = sim_clock_monotonic_ns();
+    latency_hist_record(&rt->jitter, rt->wake_ns > rt->deadline_ns ? rt->wake_ns - rt->deadline_ns : 0);
+    rt->ticks++;
+    return true;
+}
+
+// Print the settings in effect and the tick statistics in microseconds
+void rt_loop_print(const rt_loop_t *rt) {
+    sim_log_flush();
+    printf("\n=== Real-Time Loop ===\n");
+    printf("  Period %.3f ms, %s, CPU %s, memory %s\n",
+           (double)rt->config.period_ns / SIM_CLOCK_NS_PER_MS,
+           rt->fifo ? "SCHED_FIFO" : "normal scheduling",
+           rt->pinned ? "pinned" : "not pinned",
+           rt->locked ? "locked" : "not locked");
+    printf("  Ticks %llu, overruns %llu, missed deadlines %llu\n",
+           (unsigned long long)rt->ticks, (unsigned long long)rt->overruns, (unsigned long long)rt->missed);
+    
+    const struct {
+        const char *name;
+        const latency_hist_t *hist;
+    } rows[] = {{"Execution", &rt->exec}, {"Wake-up jitter", &rt->jitter}};
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+        const latency_hist_t *hist = rows[i].hist;
+        if (hist->count == 0) {
+            printf("  %s: no samples\n", rows[i].name);
+            continue;
+        }
+        printf("  %s: p50 %.1f us, p99 %.1f us, p999 %.1f us, max %.1f us\n", rows[i].name,
+               (double)latency_hist_percentile(hist, 50.0) / SIM_CLOCK_NS_PER_US,
+               (double)latency_hist_percentile(hist, 99.0) / SIM_CLOCK_NS_PER_US,
+               (double)latency_hist_percentile(hist, 99.9) / SIM_CLOCK_NS_PER_US,
+               (double)hist->max_ns / SIM_CLOCK_NS_PER_US);
+    }
+    printf("======================\n\n");
+}
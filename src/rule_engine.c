@@ -0,0 +1,506 @@
+#include "rule_engine.h"
+#include "board.h"
+#include "sim_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// Longest table line
+#define RULE_LINE_MAX 256
+
+// Mask covering every pin that physically exists
+#define RULE_PIN_MASK ((1ULL << GPIO_NUM_MAX) - 1)
+
+// Effect of no rule at all
+static const rule_effect_t rule_identity = {~0ULL, 0};
+
+// One hold rule on one pin, sorted into groups while compiling
+typedef struct {
+    uint32_t pin;
+    uint32_t hold_ms;
+    uint32_t rule;
+} rule_hold_entry_t;
+
+// Effect of one rule on its outputs
+static rule_effect_t rule_effect_of(const rule_t *rule) {
+    uint64_t outs = rule->outputs;
+    switch (rule->action) {
+        case RULE_ACTION_TOGGLE:
+            return (rule_effect_t){~0ULL, outs};
+        case RULE_ACTION_CLEAR:
+            return (rule_effect_t){~outs, 0};
+        default:
+            return (rule_effect_t){~outs, outs};
+    }
+}
+
+// Effect of 'a' followed by 'b'
+static inline rule_effect_t rule_compose(rule_effect_t a, rule_effect_t b) {
+    return (rule_effect_t){a.keep & b.keep, (a.flip & b.keep) ^ b.flip};
+}
+
+// Write the outputs an effect touches in one register update
+static void rule_apply(rule_engine_t *engine, rule_effect_t effect) {
+    uint64_t touched = ~effect.keep | effect.flip;
+    if (!touched) {
+        return;
+    }
+    
+    // Current levels: LED state for LEDs (dimmed ones included), OUT otherwise
+    led_controller_t *leds = engine->leds;
+    uint64_t levels = gpio_dev_read_all(leds->gpio) & touched & ~leds->pin_mask;
+    uint64_t lit = touched & leds->pin_mask;
+    while (lit) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(lit);
+        lit &= lit - 1;
+        if (leds->leds[leds->pin_index[pin]].state == LED_ON) {
+            levels |= GPIO_PIN_SEL(pin);
+        }
+    }
+    
+    led_ctrl_write_mask(leds, touched, (levels & effect.keep) ^ effect.flip);
+    engine->writes++;
+}
+
+// Log the rules of a slot and start their pulses
+// With nothing to log and no pulse the rules are not visited at all.
+static void rule_fire(rule_engine_t *engine, const rule_slot_t *slot, uint32_t pin, uint64_t time_ns) {
+    const rule_table_t *table = &engine->table;
+    engine->fired += slot->count;
+    if (!slot->pulses && !(SIM_LOG_INFO <= SIM_LOG_LEVEL_MAIN && sim_log_enabled(SIM_LOG_MODULE_MAIN, SIM_LOG_INFO))) {
+        return;
+    }
+    for (uint32_t i = slot->first; i < slot->first + slot->count; i++) {
+        const rule_t *rule = &table->rules[table->order[i]];
+        SIM_LOGI(MAIN, SIM_EVT_MAIN_RULE, pin, 0, rule->label);
+        if (rule->action == RULE_ACTION_PULSE) {
+            timer_wheel_arm(engine->wheel, &table->pulses[table->order[i]].timer,
+                            time_ns + (uint64_t)rule->pulse_ms * SIM_CLOCK_NS_PER_MS);
+        }
+    }
+}
+
+// Pulse timer: clear the outputs of the pulse
+static void rule_pulse_cb(void *arg, uint64_t deadline_ns) {
+    rule_pulse_t *pulse = arg;
+    (void)deadline_ns;
+    rule_apply(pulse->engine, (rule_effect_t){~pulse->outputs, 0});
+}
+
+// Arm a pin's hold timer for its next hold group
+static void rule_hold_arm(rule_engine_t *engine, rule_hold_timer_t *hold) {
+    const rule_table_t *table = &engine->table;
+    const rule_slot_t *group = &table->holds[table->hold_first[hold->pin] + hold->next];
+    timer_wheel_arm(engine->wheel, &hold->timer, hold->press_ns + (uint64_t)group->hold_ms * SIM_CLOCK_NS_PER_MS);
+}
+
+// Hold timer: the input has been down for the next hold duration
+static void rule_hold_cb(void *arg, uint64_t deadline_ns) {
+    rule_hold_timer_t *hold = arg;
+    rule_engine_t *engine = hold->engine;
+    const rule_table_t *table = &engine->table;
+    const rule_slot_t *group = &table->holds[table->hold_first[hold->pin] + hold->next];
+    
+    rule_fire(engine, group, hold->pin, deadline_ns);
+    rule_apply(engine, group->effect);
+    if (++hold->next < table->hold_count[hold->pin]) {
+        rule_hold_arm(engine, hold);
+    }
+}
+
+// Free a compiled table
+static void rule_table_free(rule_table_t *table) {
+    free(table->rules);
+    free(table->order);
+    free(table->holds);
+    free(table->pulses);
+    memset(table, 0, sizeof(*table));
+}
+
+// Order hold entries by pin, then duration, then table position
+static int rule_hold_compare(const void *a, const void *b) {
+    const rule_hold_entry_t *x = a;
+    const rule_hold_entry_t *y = b;
+    if (x->pin != y->pin) {
+        return (x->pin > y->pin) - (x->pin < y->pin);
+    }
+    if (x->hold_ms != y->hold_ms) {
+        return (x->hold_ms > y->hold_ms) - (x->hold_ms < y->hold_ms);
+    }
+    return (x->rule > y->rule) - (x->rule < y->rule);
+}
+
+// Check the fields of one rule
+static bool rule_valid(const rule_t *rule) {
+    if (!rule->inputs || (rule->inputs & ~RULE_PIN_MASK) || !rule->outputs || (rule->outputs & ~RULE_PIN_MASK)) {
+        return false;
+    }
+    if (rule->trigger > RULE_TRIGGER_HOLD || rule->action > RULE_ACTION_PULSE) {
+        return false;
+    }
+    if (rule->trigger == RULE_TRIGGER_HOLD && (rule->hold_ms < 1 || rule->hold_ms > RULE_MAX_MS)) {
+        return false;
+    }
+    return rule->action != RULE_ACTION_PULSE || (rule->pulse_ms >= 1 && rule->pulse_ms <= RULE_MAX_MS);
+}
+
+// Compile rules into a table; 'engine' is only referenced by the timers
+static bool rule_table_build(rule_table_t *table, rule_engine_t *engine, const rule_t *rules, size_t count) {
+    size_t entries = 0;
+    size_t hold_entries = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t pins = (size_t)__builtin_popcountll(rules[i].inputs);
+        entries += pins;
+        hold_entries += rules[i].trigger == RULE_TRIGGER_HOLD ? pins : 0;
+    }
+    
+    memset(table, 0, sizeof(*table));
+    table->rules = malloc((count ? count : 1) * sizeof(rule_t));
+    table->order = malloc((entries ? entries : 1) * sizeof(uint32_t));
+    table->holds = malloc((hold_entries ? hold_entries : 1) * sizeof(rule_slot_t));
+    table->pulses = calloc(count ? count : 1, sizeof(rule_pulse_t));
+    rule_hold_entry_t *sorted = malloc((hold_entries ? hold_entries : 1) * sizeof(rule_hold_entry_t));
+    if (!table->rules || !table->order || !table->holds || !table->pulses || !sorted) {
+        free(sorted);
+        rule_table_free(table);
+        return false;
+    }
+    if (count) {
+        memcpy(table->rules, rules, count * sizeof(rule_t));
+    }
+    table->count = count;
+    
+    // Press and release slots: count, place, then fill in table order
+    size_t hold_n = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (uint64_t in = rules[i].inputs; in; in &= in - 1) {
+            uint32_t pin = (uint32_t)__builtin_ctzll(in);
+            if (rules[i].trigger == RULE_TRIGGER_HOLD) {
+                sorted[hold_n++] = (rule_hold_entry_t){pin, rules[i].hold_ms, (uint32_t)i};
+            } else {
+                table->edges[rules[i].trigger][pin].count++;
+            }
+        }
+    }
+    uint32_t next = 0;
+    for (int trigger = RULE_TRIGGER_PRESS; trigger <= RULE_TRIGGER_RELEASE; trigger++) {
+        for (uint32_t pin = 0; pin < GPIO_NUM_MAX; pin++) {
+            rule_slot_t *slot = &table->edges[trigger][pin];
+            slot->first = next;
+            next += slot->count;
+            slot->count = 0;
+            slot->effect = rule_identity;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (rules[i].trigger == RULE_TRIGGER_HOLD) {
+            continue;
+        }
+        rule_effect_t effect = rule_effect_of(&rules[i]);
+        for (uint64_t in = rules[i].inputs; in; in &= in - 1) {
+            rule_slot_t *slot = &table->edges[rules[i].trigger][__builtin_ctzll(in)];
+            table->order[slot->first + slot->count++] = (uint32_t)i;
+            slot->pulses += rules[i].action == RULE_ACTION_PULSE;
+            slot->effect = rule_compose(slot->effect, effect);
+        }
+    }
+    
+    // Hold groups: one per (pin, duration), in increasing duration
+    qsort(sorted, hold_n, sizeof(*sorted), rule_hold_compare);
+    size_t groups = 0;
+    for (size_t i = 0; i < hold_n; i++) {
+        const rule_hold_entry_t *e = &sorted[i];
+        if (i == 0 || e->pin != sorted[i - 1].pin || e->hold_ms != sorted[i - 1].hold_ms) {
+            if (table->hold_count[e->pin] == 0) {
+                table->hold_first[e->pin] = (uint32_t)groups;
+            }
+            table->hold_count[e->pin]++;
+            table->holds[groups++] = (rule_slot_t){rule_identity, next, 0, 0, e->hold_ms};
+        }
+        rule_slot_t *group = &table->holds[groups - 1];
+        table->order[next++] = e->rule;
+        group->count++;
+        group->pulses += rules[e->rule].action == RULE_ACTION_PULSE;
+        group->effect = rule_compose(group->effect, rule_effect_of(&rules[e->rule]));
+    }
+    free(sorted);
+    
+    for (size_t i = 0; i < count; i++) {
+        table->pulses[i].engine = engine;
+        table->pulses[i].outputs = rules[i].outputs;
+        timer_wheel_timer_init(&table->pulses[i].timer, rule_pulse_cb, &table->pulses[i]);
+    }
+    return true;
+}
+
+// Initialize an engine with an empty table
+void rule_engine_init(rule_engine_t *engine, led_controller_t *leds, timer_wheel_t *wheel) {
+    memset(engine, 0, sizeof(*engine));
+    engine->leds = leds;
+    engine->wheel = wheel;
+    for (uint32_t pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        engine->hold_timers[pin].engine = engine;
+        engine->hold_timers[pin].pin = pin;
+        timer_wheel_timer_init(&engine->hold_timers[pin].timer, rule_hold_cb, &engine->hold_timers[pin]);
+    }
+    rule_engine_set_rules(engine, NULL, 0);
+}
+
+// Stop every hold and pulse in flight, e.g. before the board is rolled back
+void rule_engine_reset(rule_engine_t *engine) {
+    for (uint32_t pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        timer_wheel_cancel(engine->wheel, &engine->hold_timers[pin].timer);
+    }
+    for (size_t i = 0; i < engine->table.count; i++) {
+        timer_wheel_cancel(engine->wheel, &engine->table.pulses[i].timer);
+    }
+}
+
+// Drop the table, with any hold or pulse in flight
+void rule_engine_deinit(rule_engine_t *engine) {
+    rule_engine_reset(engine);
+    // Queued log records point at the labels
+    sim_log_flush();
+    rule_table_free(&engine->table);
+}
+
+// Replace the table with 'rules', compiled
+// Holds and pulses in flight are dropped; outputs keep their levels. On
+// error the current table stays.
+bool rule_engine_set_rules(rule_engine_t *engine, const rule_t *rules, size_t count) {
+    if (count > RULE_MAX_RULES) {
+        SIM_LOGE(MAIN, SIM_EVT_MAIN_RULES_ERR, 0, count, "table");
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!rule_valid(&rules[i])) {
+            SIM_LOGE(MAIN, SIM_EVT_MAIN_RULES_ERR, (uint32_t)(i + 1), 0, "table");
+            return false;
+        }
+    }
+    
+    rule_table_t table;
+    if (!rule_table_build(&table, engine, rules, count)) {
+        SIM_LOGE(MAIN, SIM_EVT_MAIN_RULES_ERR, 0, count, "table");
+        return false;
+    }
+    rule_engine_deinit(engine);
+    engine->table = table;
+    return true;
+}
+
+// Parse a comma-separated pin list into a mask
+static bool rule_parse_pins(const char *text, uint64_t *mask) {
+    char buf[RULE_LINE_MAX];
+    char *save;
+    
+    snprintf(buf, sizeof(buf), "%s", text);
+    *mask = 0;
+    for (char *item = strtok_r(buf, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *end;
+        uint64_t bits = 0;
+        if (strncasecmp(item, "0x", 2) == 0) {
+            bits = strtoull(item + 2, &end, 16);
+            if (end == item + 2 || *end) {
+                return false;
+            }
+        } else {
+            const char *num = strncasecmp(item, "GPIO", 4) == 0 ? item + 4 : item;
+            unsigned long pin = GPIO_NUM_MAX;
+            if (*num >= '0' && *num <= '9') {
+                pin = strtoul(num, &end, 10);
+                if (*end) {
+                    return false;
+                }
+            } else {
+                for (uint32_t p = 0; p < GPIO_NUM_MAX && pin == GPIO_NUM_MAX; p++) {
+                    const char *name = board_pin_name(p);
+                    pin = (name && strcasecmp(name, item) == 0) ? p : GPIO_NUM_MAX;
+                }
+            }
+            if (pin >= GPIO_NUM_MAX) {
+                return false;
+            }
+            bits = GPIO_PIN_SEL(pin);
+        }
+        if (!bits || (bits & ~RULE_PIN_MASK)) {
+            return false;
+        }
+        *mask |= bits;
+    }
+    return *mask != 0;
+}
+
+// Parse "<word>" or "<word>:<ms>"; returns the index of the word in
+// 'words' and sets 'ms' (0 if absent), or -1
+static int rule_parse_word(const char *text, const char *const *words, int count, uint32_t *ms) {
+    size_t len = strcspn(text, ":");
+    *ms = 0;
+    for (int i = 0; i < count; i++) {
+        if (strlen(words[i]) == len && strncasecmp(text, words[i], len) == 0) {
+            if (text[len] == ':') {
+                char *end;
+                unsigned long value = strtoul(text + len + 1, &end, 10);
+                if (end == text + len + 1 || *end || value > RULE_MAX_MS) {
+                    return -1;
+                }
+                *ms = (uint32_t)value;
+            }
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Parse one rule, "<trigger> <inputs> <action> <outputs>", without a comment
+bool rule_engine_parse(const char *line, rule_t *rule) {
+    static const char *const triggers[] = {"press", "release", "hold"};
+    static const char *const actions[] = {"toggle", "set", "clear", "pulse"};
+    static const char *const trigger_text[] = {"pressed", "released", "held"};
+    static const char *const action_text[] = {"Toggling", "Setting", "Clearing", "Pulsing"};
+    char buf[RULE_LINE_MAX];
+    char *field[5];
+    char *save;
+    int n = 0;
+    
+    snprintf(buf, sizeof(buf), "%s", line);
+    for (char *tok = strtok_r(buf, " \t\r\n", &save); tok && n < 5; tok = strtok_r(NULL, " \t\r\n", &save)) {
+        field[n++] = tok;
+    }
+    if (n != 4) {
+        return false;
+    }
+    
+    memset(rule, 0, sizeof(*rule));
+    int trigger = rule_parse_word(field[0], triggers, 3, &rule->hold_ms);
+    int action = rule_parse_word(field[2], actions, 4, &rule->pulse_ms);
+    if (trigger < 0 || action < 0 || (trigger == RULE_TRIGGER_HOLD) != (rule->hold_ms != 0) ||
+        (action == RULE_ACTION_PULSE) != (rule->pulse_ms != 0) ||
+        !rule_parse_pins(field[1], &rule->inputs) || !rule_parse_pins(field[3], &rule->outputs)) {
+        return false;
+    }
+    rule->trigger = (rule_trigger_t)trigger;
+    rule->action = (rule_action_t)action;
+    
+    if (trigger == RULE_TRIGGER_HOLD) {
+        snprintf(rule->label, sizeof(rule->label), "%.20s held %u ms - %s %.20s",
+                 field[1], rule->hold_ms, action_text[action], field[3]);
+    } else {
+        snprintf(rule->label, sizeof(rule->label), "%.20s %s - %s %.20s",
+                 field[1], trigger_text[trigger], action_text[action], field[3]);
+    }
+    return true;
+}
+
+// Load a table file, replacing the current table if it is valid
+bool rule_engine_load_file(rule_engine_t *engine, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        SIM_LOGE(MAIN, SIM_EVT_MAIN_RULES_ERR, 0, 0, path);
+        return false;
+    }
+    
+    char line[RULE_LINE_MAX];
+    rule_t *rules = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    uint32_t number = 0;
+    bool ok = true;
+    
+    while (ok && fgets(line, sizeof(line), file)) {
+        number++;
+        line[strcspn(line, "#")] = '\0';
+        if (line[strspn(line, " \t\r\n")] == '\0') {
+            continue;
+        }
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 64;
+            rule_t *more = grown <= RULE_MAX_RULES ? realloc(rules, grown * sizeof(rule_t)) : NULL;
+            if (!more) {
+                ok = false;
+                break;
+            }
+            rules = more;
+            capacity = grown;
+        }
+        ok = rule_engine_parse(line, &rules[count]);
+        count += ok;
+    }
+    fclose(file);
+    
+    if (!ok) {
+        SIM_LOGE(MAIN, SIM_EVT_MAIN_RULES_ERR, number, 0, path);
+    } else if ((ok = rule_engine_set_rules(engine, rules, count))) {
+        SIM_LOGI(MAIN, SIM_EVT_MAIN_RULES_LOADED, 0, count, path);
+    }
+    free(rules);
+    return ok;
+}
+
+// Load the board's own table: each button press toggles its LED
+bool rule_engine_load_board(rule_engine_t *engine) {
+    static const struct {
+        const char *button;
+        uint32_t pin;
+        const char *led;
+        uint32_t led_pin;
+    } board_rules[NUM_BUTTONS] = {
+#define RULE_BOARD_ROW(n, name, pin, led) {#name, (pin), #led, BOARD_PIN_##led},
+        BOARD_BUTTONS(RULE_BOARD_ROW)
+    };
+    rule_t rules[NUM_BUTTONS];
+    
+    memset(rules, 0, sizeof(rules));
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        rules[i].trigger = RULE_TRIGGER_PRESS;
+        rules[i].action = RULE_ACTION_TOGGLE;
+        rules[i].inputs = GPIO_PIN_SEL(board_rules[i].pin);
+        rules[i].outputs = GPIO_PIN_SEL(board_rules[i].led_pin);
+        snprintf(rules[i].label, sizeof(rules[i].label), "%s pressed - Toggling %s",
+                 board_rules[i].button, board_rules[i].led);
+    }
+    return rule_engine_set_rules(engine, rules, NUM_BUTTONS);
+}
+
+// Act on a batch of debounced button events
+// Each event costs one lookup and one composition; the output changes of
+// the whole batch go out in one write.
+void rule_engine_process(rule_engine_t *engine, const button_event_t *events, size_t count) {
+    const rule_table_t *table = &engine->table;
+    rule_effect_t effect = rule_identity;
+    
+    for (size_t i = 0; i < count; i++) {
+        uint32_t pin = events[i].pin;
+        if (pin >= GPIO_NUM_MAX) {
+            continue;
+        }
+        bool pressed = events[i].state == BUTTON_PRESSED;
+        const rule_slot_t *slot = &table->edges[pressed ? RULE_TRIGGER_PRESS : RULE_TRIGGER_RELEASE][pin];
+        if (slot->count) {
+            rule_fire(engine, slot, pin, events[i].time_ns);
+            effect = rule_compose(effect, slot->effect);
+        }
+        
+        if (table->hold_count[pin]) {
+            rule_hold_timer_t *hold = &engine->hold_timers[pin];
+            if (pressed) {
+                hold->next = 0;
+                hold->press_ns = events[i].time_ns;
+                rule_hold_arm(engine, hold);
+            } else {
+                timer_wheel_cancel(engine->wheel, &hold->timer);
+            }
+        }
+    }
+    rule_apply(engine, effect);
+}
+
+// Print the table
+void rule_engine_print(const rule_engine_t *engine) {
+    sim_log_flush();
+    printf("Rules:\n");
+    for (size_t i = 0; i < engine->table.count; i++) {
+        printf("  %s\n", engine->table.rules[i].label);
+    }
+}
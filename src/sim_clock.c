@@ -0,0 +1,119 @@
+#include "sim_clock.h"
+#include <string.h>
+#include <time.h>
+
+// Clock used by the default-instance functions
+static sim_clock_t default_clock = { SIM_CLOCK_REALTIME, 0 };
+
+static const char *const mode_names[] = {
+    "real", "virtual", "warp"
+};
+
+// Read CLOCK_MONOTONIC in nanoseconds
+uint64_t sim_clock_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * SIM_CLOCK_NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+// Select the clock backend; virtual clocks restart at zero
+void sim_clock_configure(sim_clock_t *clk, sim_clock_mode_t mode) {
+    clk->mode = mode;
+    __atomic_store_n(&clk->virtual_now_ns, 0, __ATOMIC_RELEASE);
+}
+
+// Current simulation time in nanoseconds
+uint64_t sim_clock_now(const sim_clock_t *clk) {
+    if (clk->mode == SIM_CLOCK_REALTIME) {
+        return sim_clock_monotonic_ns();
+    }
+    return __atomic_load_n(&clk->virtual_now_ns, __ATOMIC_ACQUIRE);
+}
+
+// Move virtual time forward (no effect on the real-time clock)
+void sim_clock_advance(sim_clock_t *clk, uint64_t delta_ns) {
+    if (clk->mode != SIM_CLOCK_REALTIME) {
+        __atomic_fetch_add(&clk->virtual_now_ns, delta_ns, __ATOMIC_ACQ_REL);
+    }
+}
+
+// Set virtual time; the clock never moves backwards
+void sim_clock_set(sim_clock_t *clk, uint64_t time_ns) {
+    if (clk->mode == SIM_CLOCK_REALTIME) {
+        return;
+    }
+    uint64_t now = __atomic_load_n(&clk->virtual_now_ns, __ATOMIC_ACQUIRE);
+    while (time_ns > now &&
+           !__atomic_compare_exchange_n(&clk->virtual_now_ns, &now, time_ns, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+// Move a virtual clock to any time, backwards included (snapshot restore)
+void sim_clock_rewind(sim_clock_t *clk, uint64_t time_ns) {
+    if (clk->mode == SIM_CLOCK_REALTIME) {
+        return;
+    }
+    __atomic_store_n(&clk->virtual_now_ns, time_ns, __ATOMIC_RELEASE);
+}
+
+// In WARP mode, jump to a pending deadline instead of waiting for it
+// Returns true if the clock moved.
+bool sim_clock_warp(sim_clock_t *clk, uint64_t deadline_ns) {
+    if (clk->mode != SIM_CLOCK_WARP || deadline_ns <= sim_clock_now(clk)) {
+        return false;
+    }
+    sim_clock_set(clk, deadline_ns);
+    return true;
+}
+
+// Default-instance API
+
+// Get the clock used by the default-instance functions
+sim_clock_t *sim_clock_default(void) {
+    return &default_clock;
+}
+
+void sim_clock_init(sim_clock_mode_t mode) {
+    sim_clock_configure(&default_clock, mode);
+}
+
+sim_clock_mode_t sim_clock_get_mode(void) {
+    return default_clock.mode;
+}
+
+// True when time only moves under program control
+bool sim_clock_is_virtual(void) {
+    return default_clock.mode != SIM_CLOCK_REALTIME;
+}
+
+uint64_t sim_clock_now_ns(void) {
+    return sim_clock_now(&default_clock);
+}
+
+void sim_clock_advance_ns(uint64_t delta_ns) {
+    sim_clock_advance(&default_clock, delta_ns);
+}
+
+void sim_clock_set_ns(uint64_t time_ns) {
+    sim_clock_set(&default_clock, time_ns);
+}
+
+bool sim_clock_warp_to(uint64_t deadline_ns) {
+    return sim_clock_warp(&default_clock, deadline_ns);
+}
+
+// Name of a backend ("real", "virtual", "warp")
+const char* sim_clock_mode_name(sim_clock_mode_t mode) {
+    return ((unsigned)mode < sizeof(mode_names) / sizeof(mode_names[0])) ? mode_names[mode] : "unknown";
+}
+
+// Parse a backend name; returns -1 if unknown
+int sim_clock_parse_mode(const char *name) {
+    for (int i = 0; i < (int)(sizeof(mode_names) / sizeof(mode_names[0])); i++) {
+        if (strcmp(name, mode_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,364 @@
+#include "sim_log.h"
+#include "mpsc_ring.h"
+#include "sim_clock.h"
+#include <stdio.h>
+#include <string.h>
+
+// Queued records; formatting happens in sim_log_flush()
+#define SIM_LOG_RING_CAPACITY 8192
+// Records formatted per batch
+#define SIM_LOG_FLUSH_BATCH 256
+// Longest formatted line, longer ones are truncated
+#define SIM_LOG_LINE_MAX 160
+// Output buffer for one batch
+#define SIM_LOG_FLUSH_BUFFER (SIM_LOG_FLUSH_BATCH * SIM_LOG_LINE_MAX)
+
+uint8_t sim_log_levels[SIM_LOG_MODULE_COUNT] = {
+    SIM_LOG_LEVEL_GPIO,
+    SIM_LOG_LEVEL_LED,
+    SIM_LOG_LEVEL_BUTTON,
+    SIM_LOG_LEVEL_MAIN,
+    SIM_LOG_LEVEL_SIMULATION
+};
+
+static const char *const module_tags[SIM_LOG_MODULE_COUNT] = {
+    "GPIO", "LED", "BUTTON", "MAIN", "SIMULATION"
+};
+
+static const char *const level_names[] = {
+    "off", "error", "info", "debug"
+};
+
+static mpsc_ring_t log_ring;
+static bool log_ready = false;
+static bool log_timestamps = false;
+static uint64_t log_dropped = 0;
+static uint64_t log_dropped_reported = 0;
+
+// Initialize the logging backend
+void sim_log_init(void) {
+    if (log_ready) {
+        return;
+    }
+    log_ready = mpsc_ring_init(&log_ring, SIM_LOG_RING_CAPACITY, sizeof(sim_log_record_t));
+    if (!log_ready) {
+        fprintf(stderr, "[LOG ERROR] Failed to allocate log ring\n");
+    }
+}
+
+// Flush pending records and release the ring
+void sim_log_shutdown(void) {
+    if (!log_ready) {
+        return;
+    }
+    sim_log_flush();
+    mpsc_ring_free(&log_ring);
+    log_ready = false;
+}
+
+// Set the runtime level of one module
+void sim_log_set_level(sim_log_module_t module, int level) {
+    if (module < SIM_LOG_MODULE_COUNT) {
+        __atomic_store_n(&sim_log_levels[module], (uint8_t)level, __ATOMIC_RELAXED);
+    }
+}
+
+// Set the runtime level of every module
+void sim_log_set_level_all(int level) {
+    for (int i = 0; i < SIM_LOG_MODULE_COUNT; i++) {
+        sim_log_set_level((sim_log_module_t)i, level);
+    }
+}
+
+// Get the runtime level of one module
+int sim_log_get_level(sim_log_module_t module) {
+    return (module < SIM_LOG_MODULE_COUNT) ? sim_log_levels[module] : SIM_LOG_OFF;
+}
+
+// Parse "off", "error", "info" or "debug"; returns -1 if unknown
+int sim_log_parse_level(const char *name) {
+    for (int i = 0; i < (int)(sizeof(level_names) / sizeof(level_names[0])); i++) {
+        if (strcmp(name, level_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Prefix flushed lines with the record timestamp
+void sim_log_set_timestamps(bool enable) {
+    log_timestamps = enable;
+}
+
+// Queue one record (hot path: no formatting, no syscalls besides the clock)
+void sim_log_write(sim_log_module_t module, int level, sim_log_event_t event,
+                   uint32_t pin, uint64_t value, const char *name) {
+    if (!log_ready) {
+        return;
+    }
+    
+    sim_log_record_t rec = {
+        .timestamp_ns = sim_clock_now_ns(),
+        .value = value,
+        .name = name,
+        .pin = pin,
+        .event = (uint16_t)event,
+        .module = (uint8_t)module,
+        .level = (uint8_t)level
+    };
+    
+    if (!mpsc_ring_push(&log_ring, &rec)) {
+        __atomic_fetch_add(&log_dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Number of records dropped because the ring was full
+uint64_t sim_log_dropped(void) {
+    return __atomic_load_n(&log_dropped, __ATOMIC_RELAXED);
+}
+
+// Render the message body of one record
+static int sim_log_format_body(const sim_log_record_t *rec, char *buf, size_t size) {
+    const char *name = rec->name ? rec->name : "?";
+    unsigned long long value = (unsigned long long)rec->value;
+    
+    switch ((sim_log_event_t)rec->event) {
+        case SIM_EVT_GPIO_INIT:
+            return snprintf(buf, size, "Mock GPIO system initialized");
+        case SIM_EVT_GPIO_CONFIG:
+            return snprintf(buf, size, "Pin %u configured as %s",
+                            rec->pin, value ? "OUTPUT" : "INPUT");
+        case SIM_EVT_GPIO_SET_LEVEL:
+            return snprintf(buf, size, "Pin %u set to %s", rec->pin, value ? "HIGH" : "LOW");
+        case SIM_EVT_GPIO_TOGGLE:
+            return snprintf(buf, size, "Pin %u toggled to %s", rec->pin, value ? "HIGH" : "LOW");
+        case SIM_EVT_GPIO_SET_MASK:
+            return snprintf(buf, size, "Mask 0x%016llx set to HIGH", value);
+        case SIM_EVT_GPIO_CLEAR_MASK:
+            return snprintf(buf, size, "Mask 0x%016llx set to LOW", value);
+        case SIM_EVT_GPIO_TOGGLE_MASK:
+            return snprintf(buf, size, "Mask 0x%016llx toggled", value);
+        case SIM_EVT_GPIO_WRITE_MASK:
+            return snprintf(buf, size, "Mask 0x%016llx written", value);
+        case SIM_EVT_GPIO_ERR_NULL_CONFIG:
+            return snprintf(buf, size, "Invalid configuration pointer");
+        case SIM_EVT_GPIO_ERR_INVALID_MASK:
+            return snprintf(buf, size, "Invalid GPIO pin mask: 0x%016llx", value);
+        case SIM_EVT_GPIO_ERR_INVALID_PIN:
+            return snprintf(buf, size, "Invalid GPIO pin: %u", rec->pin);
+        case SIM_EVT_GPIO_ERR_NOT_INIT:
+            return snprintf(buf, size, "GPIO pin %u not initialized", rec->pin);
+        case SIM_EVT_GPIO_ERR_NOT_OUTPUT:
+            return snprintf(buf, size, "GPIO pin %u not configured as output", rec->pin);
+        case SIM_EVT_GPIO_ERR_MASK_NOT_OUTPUT:
+            return snprintf(buf, size, "%s: pins not configured as output: 0x%016llx", name, value);
+        case SIM_EVT_GPIO_INTR_TYPE:
+            return snprintf(buf, size, "Pin %u interrupt type %llu", rec->pin, value);
+        case SIM_EVT_GPIO_ERR_NO_ISR_SERVICE:
+            return snprintf(buf, size, "ISR service not installed, cannot add handler for pin %u", rec->pin);
+        case SIM_EVT_GPIO_ERR_LEDC:
+            return snprintf(buf, size, "%s failed for LEDC channel/timer %u", name, rec->pin);
+        case SIM_EVT_GPIO_LEDC_FADE_DONE:
+            return snprintf(buf, size, "LEDC channel %u fade done at duty %llu", rec->pin, value);
+        case SIM_EVT_GPIO_BOUNCE:
+            return snprintf(buf, size, "Pin %u bounces: %llu edges", rec->pin, value);
+        case SIM_EVT_GPIO_ERR_BOUNCE:
+            return snprintf(buf, size, "Invalid bounce model for pin %u: %s", rec->pin, name);
+        case SIM_EVT_GPIO_STRIP_REFRESH:
+            return snprintf(buf, size, "LED strip on pin %u refreshed, %llu pixels encoded", rec->pin, value);
+        case SIM_EVT_GPIO_ERR_STRIP:
+            return snprintf(buf, size, "LED strip on pin %u: %s (%llu)", rec->pin, name, value);
+        case SIM_EVT_SIM_PRESS:
+            return snprintf(buf, size, "Button on pin %u pressed", rec->pin);
+        case SIM_EVT_SIM_RELEASE:
+            return snprintf(buf, size, "Button on pin %u released", rec->pin);
+        case SIM_EVT_SIM_TRACE_OPEN:
+            if (rec->pin) {
+                return snprintf(buf, size, "Replaying binary trace %s (%llu events)", name, value);
+            }
+            return snprintf(buf, size, "Replaying text trace %s", name);
+        case SIM_EVT_SIM_TRACE_ERR_OPEN:
+            return snprintf(buf, size, "Cannot open trace %s", name);
+        case SIM_EVT_SIM_TRACE_ERR_FORMAT:
+            if (rec->pin) {
+                return snprintf(buf, size, "Malformed trace %s at line %u", name, rec->pin);
+            }
+            return snprintf(buf, size, "Malformed trace header in %s", name);
+        case SIM_EVT_SIM_TRACE_ERR_WRITE:
+            return snprintf(buf, size, "Cannot write trace %s", name);
+        case SIM_EVT_SIM_TRACE_ERR_WATCH:
+            return snprintf(buf, size, "No GPIO watch left to report LED transitions of trace %s", name);
+        case SIM_EVT_SIM_REPLAY_DONE:
+            return snprintf(buf, size, "Replay finished after %llu events", value);
+        case SIM_EVT_SIM_VCD_OPEN:
+            return snprintf(buf, size, "Recording %llu pins to VCD %s", value, name);
+        case SIM_EVT_SIM_VCD_ERR_WRITE:
+            return snprintf(buf, size, "Cannot write VCD %s", name);
+        case SIM_EVT_SIM_VCD_DONE:
+            return snprintf(buf, size, "VCD %s written (%llu value changes)", name, value);
+        case SIM_EVT_SIM_TIMER_ERR_STATE:
+            return snprintf(buf, size, "Timer %s is %s", name,
+                            rec->pin ? "already running" : "not running");
+        case SIM_EVT_SIM_SHM_OPEN:
+            return snprintf(buf, size, "Publishing GPIO registers in shared memory %s (%llu bytes)", name, value);
+        case SIM_EVT_SIM_SHM_ERR:
+            return snprintf(buf, size, "Shared memory %s failed (errno %llu)", name, value);
+        case SIM_EVT_SIM_SHM_DONE:
+            return snprintf(buf, size, "Shared memory %s closed (%llu updates)", name, value);
+        case SIM_EVT_SIM_CONTROL_OPEN:
+            return snprintf(buf, size, "Control server listening on %s", name);
+        case SIM_EVT_SIM_CONTROL_ERR:
+            return snprintf(buf, size, "Control socket %s failed (errno %llu)", name, value);
+        case SIM_EVT_SIM_CONTROL_ERR_FRAME:
+            return snprintf(buf, size, "Control client %u sent a bad frame (magic 0x%08llx)", rec->pin, value);
+        case SIM_EVT_SIM_CONTROL_CONNECT:
+            return snprintf(buf, size, "Control client %u connected", rec->pin);
+        case SIM_EVT_SIM_CONTROL_DISCONNECT:
+            return snprintf(buf, size, "Control client %u disconnected", rec->pin);
+        case SIM_EVT_SIM_CONTROL_DONE:
+            return snprintf(buf, size, "Control server %s closed (%llu batches)", name, value);
+        case SIM_EVT_SIM_SNAPSHOT_SAVE:
+            return snprintf(buf, size, "Snapshot saved (%llu bytes)", value);
+        case SIM_EVT_SIM_SNAPSHOT_RESTORE:
+            return snprintf(buf, size, "Snapshot restored at %llu ns", value);
+        case SIM_EVT_SIM_SNAPSHOT_ERR:
+            return snprintf(buf, size, "Snapshot rejected: %s", name);
+        case SIM_EVT_SIM_SNAPSHOT_ERR_FILE:
+            return snprintf(buf, size, "Snapshot file %s failed (errno %llu)", name, value);
+        case SIM_EVT_SIM_RT_START:
+            return snprintf(buf, size, "Real-time loop: %llu us period", value / 1000);
+        case SIM_EVT_SIM_RT_ERR:
+            return snprintf(buf, size, "Real-time loop: cannot apply %s (errno %llu)", name, value);
+        case SIM_EVT_LED_INIT_BEGIN:
+            return snprintf(buf, size, "Initializing LEDs...");
+        case SIM_EVT_LED_INIT_DONE:
+            return snprintf(buf, size, "All LEDs initialized and turned OFF");
+        case SIM_EVT_LED_STATE:
+            return snprintf(buf, size, "%s turned %s", name, value ? "ON" : "OFF");
+        case SIM_EVT_LED_ALL:
+            return snprintf(buf, size, "All LEDs turned %s", value ? "ON" : "OFF");
+        case SIM_EVT_LED_ERR_INVALID_PIN:
+            return snprintf(buf, size, "Invalid LED pin: %u", rec->pin);
+        case SIM_EVT_LED_ERR_INVALID_TOGGLE:
+            return snprintf(buf, size, "Invalid LED pin for toggle: %u", rec->pin);
+        case SIM_EVT_LED_ERR_INVALID_QUERY:
+            return snprintf(buf, size, "Invalid LED pin for state query: %u", rec->pin);
+        case SIM_EVT_LED_ERR_REGISTER:
+            return snprintf(buf, size, "Cannot register LED on pin %u", rec->pin);
+        case SIM_EVT_LED_BRIGHTNESS:
+            return snprintf(buf, size, "%s brightness %llu%%", name, value);
+        case SIM_EVT_LED_FADE:
+            return snprintf(buf, size, "%s fading to %llu%% over %u ms", name, value, rec->pin);
+        case SIM_EVT_LED_ERR_NO_PWM:
+            return snprintf(buf, size, "No PWM channel for LED on pin %u", rec->pin);
+        case SIM_EVT_BUTTON_INIT_BEGIN:
+            return snprintf(buf, size, "Initializing buttons...");
+        case SIM_EVT_BUTTON_INIT_DONE:
+            return snprintf(buf, size, "All buttons initialized");
+        case SIM_EVT_BUTTON_TRANSITION:
+            return snprintf(buf, size, "%s %s", name, value ? "PRESSED" : "RELEASED");
+        case SIM_EVT_BUTTON_ERR_INVALID_PIN:
+            return snprintf(buf, size, "Invalid button pin: %u", rec->pin);
+        case SIM_EVT_BUTTON_ERR_REGISTER:
+            return snprintf(buf, size, "Cannot register button on pin %u", rec->pin);
+        case SIM_EVT_BUTTON_ERR_QUEUE:
+            return snprintf(buf, size, "Cannot allocate button event queues");
+        case SIM_EVT_BUTTON_EDGE_OVERFLOW:
+            return snprintf(buf, size, "Edge queue overflow, resynced pins 0x%016llx", value);
+        case SIM_EVT_MAIN_STARTING:
+            return snprintf(buf, size, "Starting ESP32 LED Control Simulation...");
+        case SIM_EVT_MAIN_INIT_DONE:
+            return snprintf(buf, size, "System initialization complete!\n");
+        case SIM_EVT_MAIN_LOOP_ENTER:
+            return snprintf(buf, size, "Entering main loop. Type 'h' for help, 'q' to quit.\n");
+        case SIM_EVT_MAIN_SIGNAL:
+            return snprintf(buf, size, "Received signal %llu, shutting down...", value);
+        case SIM_EVT_MAIN_RULE:
+            return snprintf(buf, size, "%s", name);
+        case SIM_EVT_MAIN_RULES_LOADED:
+            return snprintf(buf, size, "Loaded %llu rules from %s", value, name);
+        case SIM_EVT_MAIN_RULES_ERR:
+            if (rec->pin) {
+                return snprintf(buf, size, "Invalid rule at %s:%u", name, rec->pin);
+            }
+            return snprintf(buf, size, "Cannot load rules from %s", name);
+        case SIM_EVT_MAIN_UNKNOWN_COMMAND:
+            return snprintf(buf, size, "Unknown command. Type 'h' for help.");
+        case SIM_EVT_MAIN_SHUTDOWN_BEGIN:
+            return snprintf(buf, size, "Shutting down system...");
+        case SIM_EVT_MAIN_SHUTDOWN_DONE:
+            return snprintf(buf, size, "System shutdown complete. Goodbye!");
+        case SIM_EVT_MAIN_STIMULUS_START:
+            if (value) {
+                return snprintf(buf, size, "Started %u stimulus threads at %llu edges/s each", rec->pin, value);
+            }
+            return snprintf(buf, size, "Started %u unpaced stimulus threads", rec->pin);
+        case SIM_EVT_MAIN_STIMULUS_DONE:
+            return snprintf(buf, size, "Stimulus threads drove %llu edges", value);
+        default:
+            return snprintf(buf, size, "event %u pin %u value 0x%llx",
+                            (unsigned)rec->event, rec->pin, value);
+    }
+}
+
+// Clamp an snprintf result to the space that was actually available
+static size_t sim_log_clamp(int n, size_t size) {
+    if (n < 0) {
+        return 0;
+    }
+    return ((size_t)n < size) ? (size_t)n : size - 1;
+}
+
+// Render one full line into buf (at least SIM_LOG_LINE_MAX bytes), returns bytes written
+static size_t sim_log_format(const sim_log_record_t *rec, char *buf) {
+    const size_t size = SIM_LOG_LINE_MAX - 1;  // Keep room for the newline
+    size_t len = 0;
+    
+    if (log_timestamps) {
+        len += sim_log_clamp(snprintf(buf, size, "%llu.%06llu ",
+                             (unsigned long long)(rec->timestamp_ns / 1000000000ULL),
+                             (unsigned long long)((rec->timestamp_ns / 1000ULL) % 1000000ULL)),
+                             size);
+    }
+    
+    const char *tag = (rec->module < SIM_LOG_MODULE_COUNT) ? module_tags[rec->module] : "LOG";
+    len += sim_log_clamp(snprintf(buf + len, size - len,
+                                  (rec->level == SIM_LOG_ERROR) ? "[%s ERROR] " : "[%s] ", tag),
+                         size - len);
+    len += sim_log_clamp(sim_log_format_body(rec, buf + len, size - len), size - len);
+    buf[len++] = '\n';
+    return len;
+}
+
+// Format and write every queued record in batches, returns record count
+size_t sim_log_flush(void) {
+    static sim_log_record_t batch[SIM_LOG_FLUSH_BATCH];
+    static char out[SIM_LOG_FLUSH_BUFFER];
+    size_t total = 0;
+    size_t count;
+    
+    if (!log_ready) {
+        return 0;
+    }
+    
+    while ((count = mpsc_ring_pop_batch(&log_ring, batch, SIM_LOG_FLUSH_BATCH)) > 0) {
+        size_t len = 0;
+        for (size_t i = 0; i < count; i++) {
+            len += sim_log_format(&batch[i], out + len);
+        }
+        fwrite(out, 1, len, stdout);
+        total += count;
+    }
+    
+    uint64_t dropped = sim_log_dropped();
+    if (dropped != log_dropped_reported) {
+        printf("[LOG] %llu records dropped (ring full)\n",
+               (unsigned long long)(dropped - log_dropped_reported));
+        log_dropped_reported = dropped;
+    }
+    
+    if (total > 0) {
+        fflush(stdout);
+    }
+    return total;
+}
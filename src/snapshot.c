@@ -0,0 +1,257 @@
+#include "snapshot.h"
+#include "sim_log.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Vertical counter words saved for a controller, 0 for the timestamp engine
+static size_t snapshot_vc_words(const button_controller_t *ctrl) {
+    return ctrl->engine == BUTTON_DEBOUNCE_VERTICAL ? ctrl->vc.num_words : 0;
+}
+
+// Blob size for a given shape
+static size_t snapshot_blob_size(size_t num_leds, size_t num_buttons, size_t vc_words) {
+    return sizeof(snapshot_header_t) +
+           num_leds * sizeof(snapshot_led_t) +
+           num_buttons * sizeof(snapshot_button_t) +
+           (DEBOUNCE_VC_PLANES + 1) * vc_words * sizeof(uint64_t);
+}
+
+// Bytes snapshot_save() needs for a board
+size_t snapshot_size(const snapshot_board_t *board) {
+    return snapshot_blob_size(board->leds->count, board->buttons->count, snapshot_vc_words(board->buttons));
+}
+
+// Serialize a board into 'buf'
+// Returns the blob size, or 0 if the buffer is too small or the board
+// cannot be saved right now.
+size_t snapshot_save(const snapshot_board_t *board, void *buf, size_t capacity) {
+    const led_controller_t *leds = board->leds;
+    const button_controller_t *buttons = board->buttons;
+    size_t vc_words = snapshot_vc_words(buttons);
+    size_t size = snapshot_size(board);
+    
+    if (board->clock->mode == SIM_CLOCK_REALTIME) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, 0, "wall clock");
+        return 0;
+    }
+    if ((buttons->edges.slots && !mpsc_ring_is_empty(&buttons->edges)) || button_ctrl_has_events(buttons)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, 0, "inputs pending");
+        return 0;
+    }
+    if (size > capacity) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, size, "buffer too small");
+        return 0;
+    }
+    
+    uint8_t *pos = buf;
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.size = (uint32_t)size;
+    header.time_ns = sim_clock_now(board->clock);
+    gpio_dev_save_regs(board->gpio, &header.gpio);
+    header.num_leds = (uint32_t)leds->count;
+    header.num_buttons = (uint32_t)buttons->count;
+    header.engine = (uint32_t)buttons->engine;
+    header.vc_words = (uint32_t)vc_words;
+    header.event_buttons = buttons->event_buttons;
+    header.next_sample_time = buttons->next_sample_time;
+    memcpy(pos, &header, sizeof(header));
+    pos += sizeof(header);
+    
+    for (size_t i = 0; i < leds->count; i++) {
+        // A fading LED is saved at its brightness of the moment
+        snapshot_led_t led = {
+            .pin = leds->leds[i].pin,
+            .state = (uint8_t)leds->leds[i].state,
+            .brightness = (uint8_t)led_ctrl_get_brightness(leds, leds->leds[i].pin)
+        };
+        memcpy(pos, &led, sizeof(led));
+        pos += sizeof(led);
+    }
+    
+    for (size_t i = 0; i < buttons->count; i++) {
+        const button_t *b = &buttons->buttons[i];
+        snapshot_button_t button = {
+            .last_debounce_time = b->last_debounce_time,
+            .pin = b->pin,
+            .current_state = (uint8_t)b->current_state,
+            .last_state = (uint8_t)b->last_state,
+            .state_changed = b->state_changed
+        };
+        memcpy(pos, &button, sizeof(button));
+        pos += sizeof(button);
+    }
+    
+    for (int plane = 0; plane < DEBOUNCE_VC_PLANES; plane++) {
+        memcpy(pos, buttons->vc.count[plane], vc_words * sizeof(uint64_t));
+        pos += vc_words * sizeof(uint64_t);
+    }
+    memcpy(pos, buttons->vc.state, vc_words * sizeof(uint64_t));
+    
+    SIM_LOGD(SIMULATION, SIM_EVT_SIM_SNAPSHOT_SAVE, 0, size, NULL);
+    return size;
+}
+
+// Check that a blob fits the board before anything is overwritten
+static bool snapshot_check(const snapshot_board_t *board, const uint8_t *buf, size_t len,
+                           const snapshot_header_t *header) {
+    const led_controller_t *leds = board->leds;
+    const button_controller_t *buttons = board->buttons;
+    
+    if (len < sizeof(*header) || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, 0, "not a snapshot");
+        return false;
+    }
+    if (header->version != SNAPSHOT_VERSION) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, header->version, "unsupported version");
+        return false;
+    }
+    if (header->size != len ||
+        len != snapshot_blob_size(header->num_leds, header->num_buttons, header->vc_words)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, len, "truncated");
+        return false;
+    }
+    if (board->clock->mode == SIM_CLOCK_REALTIME) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, 0, "wall clock");
+        return false;
+    }
+    if (header->num_leds != leds->count || header->num_buttons != buttons->count ||
+        header->engine != (uint32_t)buttons->engine || header->vc_words != snapshot_vc_words(buttons)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, 0, 0, "different board");
+        return false;
+    }
+    
+    // Records may sit at any offset of a caller's buffer, so read by copy
+    const uint8_t *pos = buf + sizeof(*header);
+    for (size_t i = 0; i < leds->count; i++, pos += sizeof(snapshot_led_t)) {
+        snapshot_led_t led;
+        memcpy(&led, pos, sizeof(led));
+        if (led.pin != leds->leds[i].pin || led.brightness > 100) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, led.pin, 0, "different board");
+            return false;
+        }
+    }
+    for (size_t i = 0; i < buttons->count; i++, pos += sizeof(snapshot_button_t)) {
+        snapshot_button_t button;
+        memcpy(&button, pos, sizeof(button));
+        if (button.pin != buttons->buttons[i].pin) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR, button.pin, 0, "different board");
+            return false;
+        }
+    }
+    return true;
+}
+
+// Restore a board from a blob made by snapshot_save()
+// The board is left untouched if the blob does not fit it.
+bool snapshot_restore(const snapshot_board_t *board, const void *buf, size_t len) {
+    led_controller_t *leds = board->leds;
+    button_controller_t *buttons = board->buttons;
+    snapshot_header_t header;
+    
+    memset(&header, 0, sizeof(header));
+    memcpy(&header, buf, len < sizeof(header) ? len : sizeof(header));
+    if (!snapshot_check(board, buf, len, &header)) {
+        return false;
+    }
+    
+    // Time first: everything below is relative to it
+    sim_clock_rewind(board->clock, header.time_ns);
+    gpio_dev_load_regs(board->gpio, &header.gpio);
+    
+    const uint8_t *pos = (const uint8_t *)buf + sizeof(header);
+    for (size_t i = 0; i < leds->count; i++) {
+        snapshot_led_t led;
+        memcpy(&led, pos, sizeof(led));
+        pos += sizeof(led);
+        leds->leds[i].state = led.state ? LED_ON : LED_OFF;
+        leds->leds[i].brightness = led.brightness;
+    }
+    led_ctrl_reload(leds);
+    
+    for (size_t i = 0; i < buttons->count; i++) {
+        snapshot_button_t button;
+        memcpy(&button, pos, sizeof(button));
+        pos += sizeof(button);
+        buttons->buttons[i].last_debounce_time = button.last_debounce_time;
+        buttons->buttons[i].current_state = button.current_state ? BUTTON_PRESSED : BUTTON_RELEASED;
+        buttons->buttons[i].last_state = button.last_state ? BUTTON_PRESSED : BUTTON_RELEASED;
+        buttons->buttons[i].state_changed = button.state_changed != 0;
+    }
+    buttons->event_buttons = header.event_buttons;
+    buttons->next_sample_time = header.next_sample_time;
+    
+    for (int plane = 0; plane < DEBOUNCE_VC_PLANES; plane++) {
+        memcpy(buttons->vc.count[plane], pos, header.vc_words * sizeof(uint64_t));
+        pos += header.vc_words * sizeof(uint64_t);
+    }
+    memcpy(buttons->vc.state, pos, header.vc_words * sizeof(uint64_t));
+    button_ctrl_reload(buttons);
+    
+    SIM_LOGD(SIMULATION, SIM_EVT_SIM_SNAPSHOT_RESTORE, 0, header.time_ns, NULL);
+    return true;
+}
+
+// Describe the default board
+void snapshot_default_board(snapshot_board_t *board) {
+    board->gpio = gpio_default_device();
+    board->leds = led_default_controller();
+    board->buttons = button_default_controller();
+    board->clock = sim_clock_default();
+}
+
+// Save the default board
+size_t snapshot_take(void *buf, size_t capacity) {
+    snapshot_board_t board;
+    snapshot_default_board(&board);
+    return snapshot_save(&board, buf, capacity);
+}
+
+// Restore the default board
+bool snapshot_load(const void *buf, size_t len) {
+    snapshot_board_t board;
+    snapshot_default_board(&board);
+    return snapshot_restore(&board, buf, len);
+}
+
+// Store a blob in a file
+bool snapshot_write_file(const char *path, const void *buf, size_t len) {
+    FILE *file = fopen(path, "wb");
+    bool ok = file && fwrite(buf, 1, len, file) == len;
+    int err = errno;
+    if (file && fclose(file) != 0) {
+        ok = false;
+        err = errno;
+    }
+    if (!ok) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR_FILE, 0, (uint64_t)err, path);
+    }
+    return ok;
+}
+
+// Read a whole file into a malloc()ed buffer, NULL on error
+void *snapshot_read_file(const char *path, size_t *len) {
+    FILE *file = fopen(path, "rb");
+    void *buf = NULL;
+    long size = -1;
+    
+    if (file && fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        buf = malloc(size ? (size_t)size : 1);
+        if (buf && fread(buf, 1, (size_t)size, file) != (size_t)size) {
+            free(buf);
+            buf = NULL;
+        }
+    }
+    if (!buf) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_SNAPSHOT_ERR_FILE, 0, (uint64_t)errno, path);
+    }
+    if (file) {
+        fclose(file);
+    }
+    *len = buf ? (size_t)size : 0;
+    return buf;
+}
@@ -0,0 +1,104 @@
+#include "stimulus.h"
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+// xorshift32: cheap per-thread pseudo-random sequence
+static inline uint32_t stimulus_next_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Sleep until an absolute CLOCK_MONOTONIC time in nanoseconds
+static void stimulus_sleep_until(uint64_t deadline_ns) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000ULL),
+        .tv_nsec = (long)(deadline_ns % 1000000000ULL)
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+// Current CLOCK_MONOTONIC time in nanoseconds
+static uint64_t stimulus_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Generator thread: pick a pin and a level, drive it, repeat
+static void *stimulus_thread(void *arg) {
+    stimulus_t *st = arg;
+    const stimulus_config_t *cfg = &st->cfg;
+    uint32_t rng = cfg->seed ? cfg->seed : 1;
+    uint64_t period_ns = cfg->rate_hz ? 1000000000ULL / cfg->rate_hz : 0;
+    uint64_t next_ns = stimulus_now_ns();
+    
+    // Dense list of the pins to drive
+    uint32_t pins[GPIO_NUM_MAX];
+    int num_pins = 0;
+    for (uint64_t work = cfg->pins; work; work &= work - 1) {
+        pins[num_pins++] = (uint32_t)__builtin_ctzll(work);
+    }
+    if (num_pins == 0) {
+        return NULL;
+    }
+    
+    while (!__atomic_load_n(&st->stop, __ATOMIC_ACQUIRE)) {
+        if (cfg->max_edges && __atomic_load_n(&st->edges, __ATOMIC_RELAXED) >= cfg->max_edges) {
+            break;
+        }
+        
+        uint32_t r = stimulus_next_random(&rng);
+        uint64_t bit = GPIO_PIN_SEL(pins[(r >> 1) % (uint32_t)num_pins]);
+        uint64_t changed = gpio_dev_drive_inputs(cfg->gpio, bit, (r & 1) ? bit : 0);
+        if (changed) {
+            __atomic_fetch_add(&st->edges, 1, __ATOMIC_RELAXED);
+            if (cfg->notify) {
+                cfg->notify();
+            }
+        }
+        
+        // Absolute pacing: a late edge shortens the next wait instead of
+        // drifting the rate
+        if (period_ns) {
+            next_ns += period_ns;
+            stimulus_sleep_until(next_ns);
+        }
+    }
+    return NULL;
+}
+
+// Start a generator thread
+// Signals stay with the application thread: the generator blocks them all.
+bool stimulus_start(stimulus_t *st, const stimulus_config_t *cfg) {
+    memset(st, 0, sizeof(*st));
+    st->cfg = *cfg;
+    
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    st->started = pthread_create(&st->thread, NULL, stimulus_thread, st) == 0;
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    return st->started;
+}
+
+// Ask a generator to stop and wait for its thread
+void stimulus_stop(stimulus_t *st) {
+    if (!st->started) {
+        return;
+    }
+    __atomic_store_n(&st->stop, true, __ATOMIC_RELEASE);
+    pthread_join(st->thread, NULL);
+    st->started = false;
+}
+
+// Edges driven by a generator so far
+uint64_t stimulus_edges(const stimulus_t *st) {
+    return __atomic_load_n(&st->edges, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,302 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_LEVEL_SLOTS - 1)
+
+// Wheel used by the default-instance peripherals
+static timer_wheel_t default_wheel;
+
+// Slot of 'tick' on 'level'
+static inline uint32_t timer_wheel_slot(uint64_t tick, uint32_t level) {
+    return (uint32_t)(tick >> (level * TIMER_WHEEL_LEVEL_BITS)) & TIMER_WHEEL_MASK;
+}
+
+// Head of the list a timer is linked into
+static inline timer_wheel_timer_t **timer_wheel_head(timer_wheel_t *wheel, const timer_wheel_timer_t *timer) {
+    if (timer->level == TIMER_WHEEL_LEVELS) {
+        return &wheel->expired;
+    }
+    return &wheel->slots[timer->level][timer_wheel_slot(timer->expires_tick, timer->level)];
+}
+
+// Put a timer on the lowest level whose slot holds only ticks after the
+// current one; level 0 also takes the current tick itself
+static void timer_wheel_link(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    uint64_t diff = timer->expires_tick ^ wheel->current_tick;
+    uint32_t level = diff ? (uint32_t)(63 - __builtin_clzll(diff)) / TIMER_WHEEL_LEVEL_BITS : 0;
+    uint32_t slot = timer_wheel_slot(timer->expires_tick, level);
+    timer_wheel_timer_t **head = &wheel->slots[level][slot];
+    
+    timer->level = (uint8_t)level;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (timer->next) {
+        timer->next->prev = timer;
+    }
+    *head = timer;
+    wheel->occupied[level] |= 1ULL << slot;
+}
+
+// Take a timer off its list, keeping the occupancy bitmap in step
+static void timer_wheel_unlink(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    timer_wheel_timer_t **head = timer_wheel_head(wheel, timer);
+    
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        *head = timer->next;
+    }
+    if (timer->next) {
+        timer->next->prev = timer->prev;
+    }
+    if (!*head && timer->level < TIMER_WHEEL_LEVELS) {
+        wheel->occupied[timer->level] &= ~(1ULL << timer_wheel_slot(timer->expires_tick, timer->level));
+    }
+    timer->next = timer->prev = NULL;
+}
+
+// Next slot the wheel must visit and the tick it starts at
+// All occupied slots of a level lie ahead of the current tick within one
+// turn of that level, and every one of them comes before any slot of the
+// levels above, so the first slot of the lowest occupied level is next.
+static bool timer_wheel_next_slot(const timer_wheel_t *wheel, uint32_t *level, uint32_t *slot,
+                                  uint64_t *tick) {
+    for (uint32_t l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+        if (!wheel->occupied[l]) {
+            continue;
+        }
+        uint32_t s = (uint32_t)__builtin_ctzll(wheel->occupied[l]);
+        uint32_t shift = l * TIMER_WHEEL_LEVEL_BITS;
+        uint32_t above = shift + TIMER_WHEEL_LEVEL_BITS;
+        uint64_t base = above < 64 ? wheel->current_tick & (~0ULL << above) : 0;
+        
+        *level = l;
+        *slot = s;
+        *tick = base | ((uint64_t)s << shift);
+        return true;
+    }
+    return false;
+}
+
+// Sort a NULL-terminated timer chain by deadline (stable merge sort);
+// only the next links are maintained
+static timer_wheel_timer_t *timer_wheel_sort(timer_wheel_timer_t *list) {
+    if (!list || !list->next) {
+        return list;
+    }
+    
+    timer_wheel_timer_t *slow = list;
+    for (timer_wheel_timer_t *fast = list->next; fast && fast->next; fast = fast->next->next) {
+        slow = slow->next;
+    }
+    timer_wheel_timer_t *right = slow->next;
+    slow->next = NULL;
+    
+    timer_wheel_timer_t *a = timer_wheel_sort(list);
+    timer_wheel_timer_t *b = timer_wheel_sort(right);
+    timer_wheel_timer_t *head = NULL;
+    timer_wheel_timer_t **tail = &head;
+    while (a && b) {
+        if (b->deadline_ns < a->deadline_ns) {
+            *tail = b;
+            b = b->next;
+        } else {
+            *tail = a;
+            a = a->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = a ? a : b;
+    return head;
+}
+
+// Move the timers of a level 0 slot that are due at 'now' to the expired
+// list, in deadline order. Returns false if none is due yet.
+static bool timer_wheel_expire_slot(timer_wheel_t *wheel, uint32_t slot, uint64_t now) {
+    timer_wheel_timer_t *due = NULL;
+    timer_wheel_timer_t *timer = wheel->slots[0][slot];
+    
+    while (timer) {
+        timer_wheel_timer_t *next = timer->next;
+        if (timer->deadline_ns <= now) {
+            timer_wheel_unlink(wheel, timer);
+            timer->next = due;
+            due = timer;
+        }
+        timer = next;
+    }
+    if (!due) {
+        return false;
+    }
+    
+    wheel->expired = timer_wheel_sort(due);
+    timer_wheel_timer_t *prev = NULL;
+    for (timer = wheel->expired; timer; prev = timer, timer = timer->next) {
+        timer->prev = prev;
+        timer->level = TIMER_WHEEL_LEVELS;
+    }
+    return true;
+}
+
+// Re-file the timers of a higher-level slot the wheel has just reached
+static void timer_wheel_cascade(timer_wheel_t *wheel, uint32_t level, uint32_t slot) {
+    timer_wheel_timer_t *timer = wheel->slots[level][slot];
+    
+    wheel->slots[level][slot] = NULL;
+    wheel->occupied[level] &= ~(1ULL << slot);
+    while (timer) {
+        timer_wheel_timer_t *next = timer->next;
+        timer_wheel_link(wheel, timer);
+        timer = next;
+    }
+}
+
+// Initialize an empty wheel starting at the clock's current time
+void timer_wheel_init(timer_wheel_t *wheel, sim_clock_t *clock) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->clock = clock;
+    wheel->current_tick = sim_clock_now(clock) / TIMER_WHEEL_TICK_NS;
+}
+
+// Prepare a timer; it stays idle until armed
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_cb_t cb, void *arg) {
+    memset(timer, 0, sizeof(*timer));
+    timer->cb = cb;
+    timer->arg = arg;
+}
+
+// Fire 'timer' at 'deadline_ns', replacing any earlier arming. A deadline
+// in the past fires on the next timer_wheel_run().
+void timer_wheel_arm(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint64_t deadline_ns) {
+    if (timer->armed) {
+        timer_wheel_cancel(wheel, timer);
+    }
+    
+    uint64_t tick = deadline_ns / TIMER_WHEEL_TICK_NS;
+    if (tick < wheel->current_tick) {
+        tick = wheel->current_tick;
+    }
+    
+    timer->deadline_ns = deadline_ns;
+    timer->expires_tick = tick;
+    timer_wheel_link(wheel, timer);
+    timer->armed = true;
+    wheel->count++;
+}
+
+// Disarm a timer; harmless if it is not armed
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    if (!timer->armed) {
+        return;
+    }
+    timer_wheel_unlink(wheel, timer);
+    timer->armed = false;
+    wheel->count--;
+}
+
+// Restart the wheel at the clock's current time after the clock was set
+// back or forward (e.g. by a checkpoint restore). Every armed timer is
+// re-armed with the time it had left at 'from_ns'; one already due then
+// fires on the next timer_wheel_run().
+void timer_wheel_rebase(timer_wheel_t *wheel, uint64_t from_ns) {
+    timer_wheel_timer_t *pending = NULL;
+    
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        while (wheel->occupied[level]) {
+            uint32_t slot = (uint32_t)__builtin_ctzll(wheel->occupied[level]);
+            timer_wheel_timer_t *timer = wheel->slots[level][slot];
+            timer_wheel_cancel(wheel, timer);
+            timer->next = pending;
+            pending = timer;
+        }
+    }
+    while (wheel->expired) {
+        timer_wheel_timer_t *timer = wheel->expired;
+        timer_wheel_cancel(wheel, timer);
+        timer->next = pending;
+        pending = timer;
+    }
+    
+    uint64_t now = sim_clock_now(wheel->clock);
+    wheel->current_tick = now / TIMER_WHEEL_TICK_NS;
+    while (pending) {
+        timer_wheel_timer_t *timer = pending;
+        pending = timer->next;
+        uint64_t left = timer->deadline_ns > from_ns ? timer->deadline_ns - from_ns : 0;
+        timer_wheel_arm(wheel, timer, now + left);
+    }
+}
+
+// Time by which timer_wheel_run() must be called next; false if no timer
+// is armed. Exact for timers due within the current level 0 turn, else
+// the time the wheel cascades the earliest timers one level down.
+bool timer_wheel_next_deadline(const timer_wheel_t *wheel, uint64_t *deadline_ns) {
+    uint32_t level, slot;
+    uint64_t tick;
+    
+    if (wheel->expired) {
+        *deadline_ns = wheel->expired->deadline_ns;
+        return true;
+    }
+    if (!timer_wheel_next_slot(wheel, &level, &slot, &tick)) {
+        return false;
+    }
+    if (level > 0) {
+        *deadline_ns = tick * TIMER_WHEEL_TICK_NS;
+        return true;
+    }
+    
+    uint64_t earliest = UINT64_MAX;
+    for (const timer_wheel_timer_t *t = wheel->slots[0][slot]; t; t = t->next) {
+        if (t->deadline_ns < earliest) {
+            earliest = t->deadline_ns;
+        }
+    }
+    *deadline_ns = earliest;
+    return true;
+}
+
+// Fire every timer that is due, in deadline order, and return how many
+// fired. Callbacks may arm or cancel any timer, including ones already due.
+size_t timer_wheel_run(timer_wheel_t *wheel) {
+    uint64_t now = sim_clock_now(wheel->clock);
+    uint64_t now_tick = now / TIMER_WHEEL_TICK_NS;
+    size_t fired = 0;
+    
+    for (;;) {
+        timer_wheel_timer_t *timer = wheel->expired;
+        if (timer) {
+            timer_wheel_cancel(wheel, timer);
+            timer->cb(timer->arg, timer->deadline_ns);
+            fired++;
+            continue;
+        }
+        
+        uint32_t level, slot;
+        uint64_t tick;
+        if (!timer_wheel_next_slot(wheel, &level, &slot, &tick) || tick > now_tick) {
+            break;
+        }
+        wheel->current_tick = tick;
+        if (level > 0) {
+            timer_wheel_cascade(wheel, level, slot);
+        } else if (!timer_wheel_expire_slot(wheel, slot, now)) {
+            break;
+        }
+    }
+    
+    // No slot starts before the next one found above, so moving up to
+    // 'now' keeps every armed timer on its level
+    if (now_tick > wheel->current_tick) {
+        wheel->current_tick = now_tick;
+    }
+    return fired;
+}
+
+// Get the wheel shared by the default-instance peripherals
+timer_wheel_t *timer_wheel_default(void) {
+    if (!default_wheel.clock) {
+        timer_wheel_init(&default_wheel, sim_clock_default());
+    }
+    return &default_wheel;
+}
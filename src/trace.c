@@ -0,0 +1,265 @@
+#include "trace.h"
+#include "sim_log.h"
+#include "sim_clock.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Map a whole file read-only; an empty file maps to NULL
+static bool trace_map_file(trace_reader_t *tr) {
+    int fd = open(tr->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+    
+    tr->size = (size_t)st.st_size;
+    if (tr->size > 0) {
+        void *map = mmap(NULL, tr->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        // Replay reads front to back exactly once
+        madvise(map, tr->size, MADV_SEQUENTIAL);
+        tr->map = map;
+    }
+    close(fd);
+    return true;
+}
+
+// Validate a binary header and locate its records
+static bool trace_open_binary(trace_reader_t *tr) {
+    trace_header_t header;
+    memcpy(&header, tr->map, sizeof(header));
+    
+    if (header.version != TRACE_VERSION || header.record_size != sizeof(trace_record_t) ||
+        header.count > (tr->size - sizeof(header)) / sizeof(trace_record_t)) {
+        return false;
+    }
+    tr->binary = true;
+    tr->records = (const trace_record_t *)(tr->map + sizeof(header));
+    tr->count = (size_t)header.count;
+    return true;
+}
+
+// Open a trace, detecting binary or text from the first bytes
+bool trace_open(trace_reader_t *tr, const char *path) {
+    memset(tr, 0, sizeof(*tr));
+    tr->path = path;
+    
+    if (!trace_map_file(tr)) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TRACE_ERR_OPEN, 0, 0, path);
+        return false;
+    }
+    
+    if (tr->size >= sizeof(trace_header_t) && memcmp(tr->map, TRACE_MAGIC, 8) == 0) {
+        if (!trace_open_binary(tr)) {
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_TRACE_ERR_FORMAT, 0, 0, path);
+            trace_close(tr);
+            return false;
+        }
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_TRACE_OPEN, 1, tr->count, path);
+    } else {
+        tr->pos = tr->map;
+        tr->line = 1;
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_TRACE_OPEN, 0, 0, path);
+    }
+    return true;
+}
+
+// Unmap a trace
+void trace_close(trace_reader_t *tr) {
+    if (tr->map) {
+        munmap((void *)tr->map, tr->size);
+        tr->map = NULL;
+    }
+    tr->records = NULL;
+    tr->count = 0;
+    tr->pos = NULL;
+}
+
+// Parse an unsigned decimal; returns false if no digit was found
+static bool trace_parse_uint(const char **p, const char *end, uint64_t *value) {
+    const char *s = *p;
+    uint64_t v = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        v = v * 10 + (uint64_t)(*s - '0');
+        s++;
+    }
+    if (s == *p) {
+        return false;
+    }
+    *value = v;
+    *p = s;
+    return true;
+}
+
+// Skip spaces and tabs, returns false if nothing was skipped
+static bool trace_skip_blanks(const char **p, const char *end) {
+    const char *s = *p;
+    while (s < end && (*s == ' ' || *s == '\t')) {
+        s++;
+    }
+    bool skipped = s != *p;
+    *p = s;
+    return skipped;
+}
+
+// Check whether a word at p matches 'word' and ends there
+static bool trace_match_word(const char **p, const char *end, const char *word) {
+    size_t len = strlen(word);
+    if ((size_t)(end - *p) < len || memcmp(*p, word, len) != 0) {
+        return false;
+    }
+    const char *after = *p + len;
+    if (after < end && *after != ' ' && *after != '\t' && *after != '\r' &&
+        *after != '\n' && *after != '#') {
+        return false;
+    }
+    *p = after;
+    return true;
+}
+
+// Parse the next text event into tr->parsed; false at end or on error
+static bool trace_parse_text(trace_reader_t *tr) {
+    const char *end = tr->map + tr->size;
+    const char *p = tr->pos;
+    
+    for (;;) {
+        trace_skip_blanks(&p, end);
+        if (p >= end) {
+            tr->pos = p;
+            return false;
+        }
+        if (*p == '\n') {
+            p++;
+            tr->line++;
+            continue;
+        }
+        if (*p == '#' || *p == '\r') {
+            const char *nl = memchr(p, '\n', (size_t)(end - p));
+            p = nl ? nl : end;
+            continue;
+        }
+        break;
+    }
+    
+    // <time_ms>[.fraction] <pin> press|release
+    uint64_t ms, pin, frac = 0;
+    uint64_t frac_scale = SIM_CLOCK_NS_PER_MS;
+    bool ok = trace_parse_uint(&p, end, &ms);
+    if (ok && p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (frac_scale > 1) {
+                frac_scale /= 10;
+                frac += (uint64_t)(*p - '0') * frac_scale;
+            }
+            p++;
+        }
+    }
+    ok = ok && trace_skip_blanks(&p, end) && trace_parse_uint(&p, end, &pin) &&
+         trace_skip_blanks(&p, end);
+    
+    bool press = false;
+    if (ok && trace_match_word(&p, end, "press")) {
+        press = true;
+    } else if (!ok || !trace_match_word(&p, end, "release")) {
+        ok = false;
+    }
+    
+    if (!ok || pin > UINT32_MAX) {
+        tr->failed = true;
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TRACE_ERR_FORMAT, (uint32_t)tr->line, 0, tr->path);
+        return false;
+    }
+    
+    tr->parsed.time_ns = ms * SIM_CLOCK_NS_PER_MS + frac;
+    tr->parsed.pin = (uint32_t)pin;
+    tr->parsed.press = press;
+    tr->pos = p;
+    return true;
+}
+
+// Next event without consuming it, NULL at the end of the trace
+// Binary records are returned in place, without copying.
+const trace_record_t *trace_peek(trace_reader_t *tr) {
+    if (tr->failed) {
+        return NULL;
+    }
+    if (tr->binary) {
+        return (tr->index < tr->count) ? &tr->records[tr->index] : NULL;
+    }
+    if (!tr->has_parsed) {
+        if (!tr->map || !trace_parse_text(tr)) {
+            return NULL;
+        }
+        tr->has_parsed = true;
+    }
+    return &tr->parsed;
+}
+
+// Consume the event returned by trace_peek()
+void trace_next(trace_reader_t *tr) {
+    if (trace_peek(tr)) {
+        tr->has_parsed = false;
+        tr->index++;
+    }
+}
+
+// Create a binary trace; the header is completed by trace_writer_close()
+bool trace_writer_open(trace_writer_t *tw, const char *path) {
+    trace_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(trace_record_t);
+    
+    tw->path = path;
+    tw->count = 0;
+    tw->file = fopen(path, "wb");
+    if (!tw->file || fwrite(&header, sizeof(header), 1, tw->file) != 1) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TRACE_ERR_WRITE, 0, 0, path);
+        if (tw->file) {
+            fclose(tw->file);
+            tw->file = NULL;
+        }
+        return false;
+    }
+    return true;
+}
+
+// Append one event
+bool trace_writer_append(trace_writer_t *tw, uint64_t time_ns, uint32_t pin, bool press) {
+    trace_record_t rec = {time_ns, pin, press ? 1U : 0U};
+    if (!tw->file || fwrite(&rec, sizeof(rec), 1, tw->file) != 1) {
+        return false;
+    }
+    tw->count++;
+    return true;
+}
+
+// Write the final record count and close the file
+bool trace_writer_close(trace_writer_t *tw) {
+    if (!tw->file) {
+        return false;
+    }
+    
+    uint64_t count = tw->count;
+    bool ok = fseek(tw->file, (long)offsetof(trace_header_t, count), SEEK_SET) == 0 &&
+              fwrite(&count, sizeof(count), 1, tw->file) == 1;
+    ok = (fclose(tw->file) == 0) && ok;
+    tw->file = NULL;
+    if (!ok) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_TRACE_ERR_WRITE, 0, 0, tw->path);
+    }
+    return ok;
+}
@@ -0,0 +1,207 @@
+#include "vcd.h"
+#include "sim_log.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Largest single value-change block: "#<20 digits>\n" plus "<level><id>\n"
+// for every pin
+#define VCD_CHANGE_MAX (24 + 3 * GPIO_NUM_MAX)
+
+// Single-character VCD identifier of a pin
+static inline char vcd_id(uint32_t pin) {
+    return (char)('!' + pin);
+}
+
+// Write the whole buffer to the file
+static void vcd_flush(vcd_writer_t *vw) {
+    size_t done = 0;
+    while (!vw->failed && done < vw->len) {
+        ssize_t n = write(vw->fd, vw->buf + done, vw->len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            vw->failed = true;
+            SIM_LOGE(SIMULATION, SIM_EVT_SIM_VCD_ERR_WRITE, 0, 0, vw->path);
+            break;
+        }
+        done += (size_t)n;
+    }
+    vw->len = 0;
+}
+
+// Make room for 'size' more bytes
+static inline void vcd_reserve(vcd_writer_t *vw, size_t size) {
+    if (vw->len + size > VCD_BUFFER_SIZE) {
+        vcd_flush(vw);
+    }
+}
+
+// Append formatted header text
+static void vcd_printf(vcd_writer_t *vw, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void vcd_printf(vcd_writer_t *vw, const char *fmt, ...) {
+    va_list ap;
+    vcd_reserve(vw, 256);
+    va_start(ap, fmt);
+    int n = vsnprintf(vw->buf + vw->len, VCD_BUFFER_SIZE - vw->len, fmt, ap);
+    va_end(ap);
+    if (n > 0 && (size_t)n < VCD_BUFFER_SIZE - vw->len) {
+        vw->len += (size_t)n;
+    }
+}
+
+// Append "#<time>\n" without going through printf
+static inline void vcd_put_time(vcd_writer_t *vw, uint64_t t) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + t % 10);
+        t /= 10;
+    } while (t);
+    
+    char *p = vw->buf + vw->len;
+    *p++ = '#';
+    while (n) {
+        *p++ = digits[--n];
+    }
+    *p++ = '\n';
+    vw->len = (size_t)(p - vw->buf);
+}
+
+// Append "<level><id>\n"
+static inline void vcd_put_value(vcd_writer_t *vw, uint32_t pin, uint32_t level) {
+    char *p = vw->buf + vw->len;
+    p[0] = level ? '1' : '0';
+    p[1] = vcd_id(pin);
+    p[2] = '\n';
+    vw->len += 3;
+}
+
+// Watch callback: one timestamp, then every pin that changed
+static void vcd_on_change(void *arg, uint64_t changed, uint64_t levels) {
+    vcd_writer_t *vw = arg;
+    
+    pthread_mutex_lock(&vw->lock);
+    if (!vw->failed) {
+        // Read the clock under the lock so timestamps never go backwards
+        uint64_t t = sim_clock_now(vw->clock) - vw->base_ns;
+        if (t < vw->last_ns) {
+            t = vw->last_ns;
+        }
+        
+        vcd_reserve(vw, VCD_CHANGE_MAX);
+        if (t != vw->last_ns) {
+            vcd_put_time(vw, t);
+            vw->last_ns = t;
+        }
+        while (changed) {
+            uint32_t pin = (uint32_t)__builtin_ctzll(changed);
+            changed &= changed - 1;
+            vcd_put_value(vw, pin, (uint32_t)(levels >> pin) & 1);
+            vw->changes++;
+        }
+    }
+    pthread_mutex_unlock(&vw->lock);
+}
+
+// Create the dump file; pins may then be labelled before vcd_writer_start()
+bool vcd_writer_open(vcd_writer_t *vw, const char *path, gpio_device_t *gpio, sim_clock_t *clock) {
+    memset(vw, 0, sizeof(*vw));
+    vw->gpio = gpio;
+    vw->clock = clock;
+    vw->path = path;
+    vw->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (vw->fd < 0) {
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_VCD_ERR_WRITE, 0, 0, path);
+        return false;
+    }
+    
+    vw->buf = malloc(VCD_BUFFER_SIZE);
+    if (!vw->buf) {
+        close(vw->fd);
+        vw->fd = -1;
+        return false;
+    }
+    pthread_mutex_init(&vw->lock, NULL);
+    return true;
+}
+
+// Name the signal of a pin (default "gpio<N>")
+void vcd_writer_label(vcd_writer_t *vw, uint32_t gpio_num, const char *name) {
+    if (GPIO_IS_VALID_GPIO(gpio_num) && !vw->started) {
+        vw->labels[gpio_num] = name;
+    }
+}
+
+// Write the header and the initial level of every configured pin, then
+// record changes from now on. Call before other threads drive the board.
+bool vcd_writer_start(vcd_writer_t *vw) {
+    if (vw->fd < 0 || vw->started) {
+        return false;
+    }
+    
+    vw->pins = __atomic_load_n(&vw->gpio->configured, __ATOMIC_ACQUIRE);
+    vw->base_ns = sim_clock_now(vw->clock);
+    
+    vcd_printf(vw, "$version esp32_led_sim $end\n");
+    vcd_printf(vw, "$comment clock %s $end\n", sim_clock_mode_name(vw->clock->mode));
+    vcd_printf(vw, "$timescale 1ns $end\n");
+    vcd_printf(vw, "$scope module gpio $end\n");
+    for (uint64_t pins = vw->pins; pins; pins &= pins - 1) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(pins);
+        if (vw->labels[pin]) {
+            vcd_printf(vw, "$var wire 1 %c %s $end\n", vcd_id(pin), vw->labels[pin]);
+        } else {
+            vcd_printf(vw, "$var wire 1 %c gpio%u $end\n", vcd_id(pin), pin);
+        }
+    }
+    vcd_printf(vw, "$upscope $end\n$enddefinitions $end\n");
+    
+    vcd_printf(vw, "#0\n$dumpvars\n");
+    for (uint64_t pins = vw->pins; pins; pins &= pins - 1) {
+        uint32_t pin = (uint32_t)__builtin_ctzll(pins);
+        vcd_put_value(vw, pin, gpio_dev_get_level(vw->gpio, pin));
+    }
+    vcd_printf(vw, "$end\n");
+    
+    vw->started = gpio_dev_add_watch(vw->gpio, vw->pins, vcd_on_change, vw);
+    if (vw->started) {
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_VCD_OPEN, 0, (uint64_t)__builtin_popcountll(vw->pins), vw->path);
+    }
+    return vw->started;
+}
+
+// Stop recording, write out the buffer and close the file
+bool vcd_writer_close(vcd_writer_t *vw) {
+    if (vw->fd < 0) {
+        return false;
+    }
+    
+    if (vw->started) {
+        gpio_dev_remove_watch(vw->gpio, vcd_on_change, vw);
+    }
+    
+    pthread_mutex_lock(&vw->lock);
+    vcd_flush(vw);
+    bool ok = !vw->failed;
+    pthread_mutex_unlock(&vw->lock);
+    
+    if (close(vw->fd) != 0 && ok) {
+        ok = false;
+        SIM_LOGE(SIMULATION, SIM_EVT_SIM_VCD_ERR_WRITE, 0, 0, vw->path);
+    }
+    vw->fd = -1;
+    free(vw->buf);
+    vw->buf = NULL;
+    pthread_mutex_destroy(&vw->lock);
+    
+    if (ok) {
+        SIM_LOGI(SIMULATION, SIM_EVT_SIM_VCD_DONE, 0, vw->changes, vw->path);
+    }
+    return ok;
+}